@@ -0,0 +1,563 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#include "bvh.h"
+
+#include "../threading/pool.h"
+
+#include <stdlib.h>
+
+#define BVH_BIN_COUNT 16
+
+// Below this many primitives the centroid pass stays on the calling thread
+#define BVH_PARALLEL_MIN_PRIMS 4096
+
+// Nodes with at least this many primitives build their left child as a pool job while the right one is built in place
+#define BVH_SPLIT_JOB_MIN_PRIMS 1024
+
+// Relative costs used by the SAH, only their ratio matters
+#define BVH_TRAVERSAL_COST REAL(1.0)
+#define BVH_INTERSECT_COST REAL(1.0)
+
+typedef struct bvh_bin {
+	rte_aabb_t bounds;
+	int count;
+} bvh_bin_t;
+
+typedef struct bvh_builder {
+	rte_bvh_t* bvh;
+	const rte_aabb_t* prim_bounds;
+	rvec3_t* centroids;
+	int max_leaf_size;
+
+	// NULL builds everything on the calling thread
+	rte_pool_t* pool;
+} bvh_builder_t;
+
+// A subtree handed to the pool, lives on the stack of the node that split it until the job is waited on
+typedef struct bvh_split_job {
+	bvh_builder_t* builder;
+
+	int node_index;
+	int first;
+	int count;
+	int depth;
+} bvh_split_job_t;
+
+//
+// Builder
+//
+static void bvh_make_leaf(rte_bvh_node_t* node, int first, int count) {
+	node->left_first = first;
+	node->count = count;
+}
+
+static void bvh_subdivide(bvh_builder_t* builder, int node_index, int first, int count, int depth);
+
+static void bvh_split_job(void* user, int index) {
+	(void)index;
+
+	bvh_split_job_t* job = (bvh_split_job_t*)user;
+	bvh_subdivide(job->builder, job->node_index, job->first, job->count, job->depth);
+}
+
+static void bvh_subdivide(bvh_builder_t* builder, int node_index, int first, int count, int depth) {
+	rte_bvh_t* bvh = builder->bvh;
+	rte_bvh_node_t* node = &bvh->nodes[node_index];
+
+	rte_aabb_t centroid_bounds;
+
+	aabb_empty(&node->bounds);
+	aabb_empty(&centroid_bounds);
+
+	for (int i = first; i < first + count; i++) {
+		int prim = bvh->indices[i];
+
+		aabb_grow(&node->bounds, &builder->prim_bounds[prim]);
+		aabb_grow_point(&centroid_bounds, builder->centroids[prim]);
+	}
+
+	// Deeper trees would overflow the traversal stack
+	if (count <= 1 || depth >= BVH_STACK_SIZE - 1) {
+		bvh_make_leaf(node, first, count);
+		return;
+	}
+
+	//
+	// Find the cheapest split plane by binning centroids along each axis
+	//
+	int best_axis = -1;
+	int best_split = 0;
+	real_t best_cost = REAL(0.0);
+
+	for (int axis = 0; axis < 3; axis++) {
+		real_t extent = centroid_bounds.max[axis] - centroid_bounds.min[axis];
+
+		if (extent <= REAL(0.0)) {
+			continue;
+		}
+
+		real_t scale = (real_t)BVH_BIN_COUNT / extent;
+
+		bvh_bin_t bins[BVH_BIN_COUNT];
+
+		for (int b = 0; b < BVH_BIN_COUNT; b++) {
+			aabb_empty(&bins[b].bounds);
+			bins[b].count = 0;
+		}
+
+		for (int i = first; i < first + count; i++) {
+			int prim = bvh->indices[i];
+			int b = (int)((builder->centroids[prim][axis] - centroid_bounds.min[axis]) * scale);
+
+			if (b >= BVH_BIN_COUNT) {
+				b = BVH_BIN_COUNT - 1;
+			}
+
+			aabb_grow(&bins[b].bounds, &builder->prim_bounds[prim]);
+			bins[b].count++;
+		}
+
+		// Sweep from both ends to get the cost of every plane between the bins
+		real_t left_area[BVH_BIN_COUNT - 1];
+		int left_count[BVH_BIN_COUNT - 1];
+
+		rte_aabb_t sweep;
+		int sweep_count = 0;
+
+		aabb_empty(&sweep);
+		for (int b = 0; b < BVH_BIN_COUNT - 1; b++) {
+			aabb_grow(&sweep, &bins[b].bounds);
+			sweep_count += bins[b].count;
+
+			left_area[b] = aabb_surface_area(&sweep);
+			left_count[b] = sweep_count;
+		}
+
+		aabb_empty(&sweep);
+		sweep_count = 0;
+
+		for (int b = BVH_BIN_COUNT - 1; b > 0; b--) {
+			aabb_grow(&sweep, &bins[b].bounds);
+			sweep_count += bins[b].count;
+
+			if (left_count[b - 1] == 0 || sweep_count == 0) {
+				continue;
+			}
+
+			real_t cost = left_area[b - 1] * (real_t)left_count[b - 1] + aabb_surface_area(&sweep) * (real_t)sweep_count;
+
+			if (best_axis == -1 || cost < best_cost) {
+				best_axis = axis;
+				best_split = b;
+				best_cost = cost;
+			}
+		}
+	}
+
+	int mid;
+
+	if (best_axis == -1) {
+		// Every centroid is in the same spot, SAH can't help us here
+		if (count <= builder->max_leaf_size) {
+			bvh_make_leaf(node, first, count);
+			return;
+		}
+
+		mid = first + count / 2;
+	} else {
+		real_t node_area = aabb_surface_area(&node->bounds);
+		real_t split_cost = BVH_TRAVERSAL_COST;
+		real_t leaf_cost = BVH_INTERSECT_COST * (real_t)count;
+
+		if (node_area > REAL(0.0)) {
+			split_cost += BVH_INTERSECT_COST * best_cost / node_area;
+		}
+
+		if (split_cost >= leaf_cost && count <= builder->max_leaf_size) {
+			bvh_make_leaf(node, first, count);
+			return;
+		}
+
+		// Partition the indices around the chosen plane
+		real_t scale = (real_t)BVH_BIN_COUNT / (centroid_bounds.max[best_axis] - centroid_bounds.min[best_axis]);
+
+		int i = first;
+		int j = first + count - 1;
+
+		while (i <= j) {
+			int prim = bvh->indices[i];
+			int b = (int)((builder->centroids[prim][best_axis] - centroid_bounds.min[best_axis]) * scale);
+
+			if (b >= BVH_BIN_COUNT) {
+				b = BVH_BIN_COUNT - 1;
+			}
+
+			if (b < best_split) {
+				i++;
+			} else {
+				bvh->indices[i] = bvh->indices[j];
+				bvh->indices[j] = prim;
+				j--;
+			}
+		}
+
+		mid = i;
+	}
+
+	// Subtrees may be built concurrently, the pair of children is reserved atomically
+	int left_index = rte_atomic_add(&bvh->node_count, 2);
+
+	node->left_first = left_index;
+	node->count = 0;
+
+	// Both children own disjoint index ranges, so the left one can be built elsewhere while this thread takes the right
+	// The wait runs the job itself when no worker has taken it yet, so nested splits can't deadlock the pool
+	if (builder->pool != NULL && mid - first >= BVH_SPLIT_JOB_MIN_PRIMS) {
+		bvh_split_job_t left;
+		rte_job_t job;
+
+		left.builder = builder;
+		left.node_index = left_index;
+		left.first = first;
+		left.count = mid - first;
+		left.depth = depth + 1;
+
+		rte_pool_submit(builder->pool, &job, bvh_split_job, &left, 1);
+		bvh_subdivide(builder, left_index + 1, mid, first + count - mid, depth + 1);
+		rte_job_wait(&job);
+
+		return;
+	}
+
+	bvh_subdivide(builder, left_index, first, mid - first, depth + 1);
+	bvh_subdivide(builder, left_index + 1, mid, first + count - mid, depth + 1);
+}
+
+static void bvh_centroids_job(void* user, int begin, int end) {
+	bvh_builder_t* builder = (bvh_builder_t*)user;
+
+	for (int p = begin; p < end; p++) {
+		aabb_centroid(RVEC_OUT(builder->centroids[p]), &builder->prim_bounds[p]);
+		builder->bvh->indices[p] = p;
+	}
+}
+
+int bvh_build(rte_bvh_t* bvh, const rte_aabb_t* prim_bounds, int prim_count, int max_leaf_size) {
+	bvh->nodes = NULL;
+	bvh->node_count = 0;
+	bvh->indices = NULL;
+	bvh->index_count = 0;
+
+	if (prim_count <= 0) {
+		return 1;
+	}
+
+	bvh_builder_t builder;
+
+	builder.bvh = bvh;
+	builder.prim_bounds = prim_bounds;
+	builder.max_leaf_size = max_leaf_size < 1 ? 1 : max_leaf_size;
+	builder.centroids = (rvec3_t*)malloc(sizeof(rvec3_t) * prim_count);
+
+	// A binary tree with N leaves never has more than 2N - 1 nodes
+	bvh->nodes = (rte_bvh_node_t*)malloc(sizeof(rte_bvh_node_t) * (2 * prim_count - 1));
+	bvh->indices = (int*)malloc(sizeof(int) * prim_count);
+
+	if (builder.centroids == NULL || bvh->nodes == NULL || bvh->indices == NULL) {
+		free(builder.centroids);
+		bvh_free(bvh);
+		return 0;
+	}
+
+	rte_parallel_for(prim_count, BVH_PARALLEL_MIN_PRIMS, bvh_centroids_job, &builder);
+
+	bvh->index_count = prim_count;
+	bvh->node_count = 1;
+
+	// Subtrees fork onto the shared pool as soon as the root splits, only node allocation is shared between them
+	builder.pool = NULL;
+
+	if (prim_count >= BVH_SPLIT_JOB_MIN_PRIMS * 2) {
+		rte_pool_t* pool = rte_pool_shared();
+
+		if (pool != NULL && rte_pool_thread_count(pool) > 0) {
+			builder.pool = pool;
+		}
+	}
+
+	bvh_subdivide(&builder, 0, 0, prim_count, 0);
+
+	free(builder.centroids);
+	return 1;
+}
+
+void bvh_free(rte_bvh_t* bvh) {
+	free(bvh->nodes);
+	free(bvh->indices);
+
+	bvh->nodes = NULL;
+	bvh->node_count = 0;
+	bvh->indices = NULL;
+	bvh->index_count = 0;
+}
+
+//
+// Refitting
+//
+static void bvh_refit_node(rte_bvh_t* bvh, const rte_aabb_t* prim_bounds, int node_index) {
+	rte_bvh_node_t* node = &bvh->nodes[node_index];
+
+	if (node->count > 0) {
+		aabb_empty(&node->bounds);
+
+		for (int i = node->left_first; i < node->left_first + node->count; i++) {
+			aabb_grow(&node->bounds, &prim_bounds[bvh->indices[i]]);
+		}
+
+		return;
+	}
+
+	// Children aren't guaranteed to come after their parent (the LBVH reuses slots), so walk the tree instead of the array
+	bvh_refit_node(bvh, prim_bounds, node->left_first);
+	bvh_refit_node(bvh, prim_bounds, node->left_first + 1);
+
+	node->bounds = bvh->nodes[node->left_first].bounds;
+	aabb_grow(&node->bounds, &bvh->nodes[node->left_first + 1].bounds);
+}
+
+void bvh_refit(rte_bvh_t* bvh, const rte_aabb_t* prim_bounds) {
+	if (bvh->node_count > 0) {
+		bvh_refit_node(bvh, prim_bounds, 0);
+	}
+}
+
+//
+// Traversal
+//
+
+// Leaf tests are passed in so the same loops serve every kind of primitive set
+
+static inline int bvh_traverse_closest(const rte_bvh_t* bvh, const rte_ray_t* ray, real_t* p_t, bvh_leaf_closest_t leaf, const void* user) {
+	if (bvh->node_count == 0) {
+		return -1;
+	}
+
+	rvec3_t inv_direction;
+	for (int a = 0; a < 3; a++) {
+		inv_direction[a] = REAL(1.0) / ray->direction[a];
+	}
+
+	int hit_slot = -1;
+	real_t closest_t = *p_t;
+
+	int stack[BVH_STACK_SIZE];
+	real_t stack_near[BVH_STACK_SIZE];
+	int stack_size = 0;
+
+	real_t t_near;
+	if (!aabb_ray_intersect(&bvh->nodes[0].bounds, ray->origin, inv_direction, closest_t, &t_near)) {
+		return -1;
+	}
+
+	int node_index = 0;
+
+	for (;;) {
+		const rte_bvh_node_t* node = &bvh->nodes[node_index];
+
+		if (node->count > 0) {
+			int slot = leaf(user, node->left_first, node->count, &closest_t);
+
+			if (slot != -1) {
+				hit_slot = slot;
+			}
+		} else {
+			int near_index = node->left_first;
+			int far_index = node->left_first + 1;
+
+			real_t t_near_child, t_far_child;
+
+			int hit_near = aabb_ray_intersect(&bvh->nodes[near_index].bounds, ray->origin, inv_direction, closest_t, &t_near_child);
+			int hit_far = aabb_ray_intersect(&bvh->nodes[far_index].bounds, ray->origin, inv_direction, closest_t, &t_far_child);
+
+			if (hit_near && hit_far) {
+				// Visit the closer child first so the far one is more likely to be culled
+				if (t_far_child < t_near_child) {
+					int swap_index = near_index;
+					near_index = far_index;
+					far_index = swap_index;
+
+					real_t swap_t = t_near_child;
+					t_near_child = t_far_child;
+					t_far_child = swap_t;
+				}
+
+				stack[stack_size] = far_index;
+				stack_near[stack_size] = t_far_child;
+				stack_size++;
+
+				node_index = near_index;
+				continue;
+			}
+
+			if (hit_near) {
+				node_index = near_index;
+				continue;
+			}
+
+			if (hit_far) {
+				node_index = far_index;
+				continue;
+			}
+		}
+
+		// Pop until we find a node that could still hold a closer hit
+		node_index = -1;
+
+		while (stack_size > 0) {
+			stack_size--;
+
+			if (stack_near[stack_size] < closest_t) {
+				node_index = stack[stack_size];
+				break;
+			}
+		}
+
+		if (node_index == -1) {
+			break;
+		}
+	}
+
+	*p_t = closest_t;
+	return hit_slot;
+}
+
+static inline int bvh_traverse_any(const rte_bvh_t* bvh, const rte_ray_t* ray, real_t t_max, bvh_leaf_any_t leaf, const void* user) {
+	if (bvh->node_count == 0) {
+		return 0;
+	}
+
+	rvec3_t inv_direction;
+	for (int a = 0; a < 3; a++) {
+		inv_direction[a] = REAL(1.0) / ray->direction[a];
+	}
+
+	int stack[BVH_STACK_SIZE];
+	int stack_size = 0;
+
+	real_t t_near;
+	if (!aabb_ray_intersect(&bvh->nodes[0].bounds, ray->origin, inv_direction, t_max, &t_near)) {
+		return 0;
+	}
+
+	stack[stack_size++] = 0;
+
+	// Order doesn't matter here, any hit ends the search
+	while (stack_size > 0) {
+		const rte_bvh_node_t* node = &bvh->nodes[stack[--stack_size]];
+
+		if (node->count > 0) {
+			if (leaf(user, node->left_first, node->count, t_max)) {
+				return 1;
+			}
+
+			continue;
+		}
+
+		for (int c = node->left_first; c < node->left_first + 2; c++) {
+			if (aabb_ray_intersect(&bvh->nodes[c].bounds, ray->origin, inv_direction, t_max, &t_near)) {
+				stack[stack_size++] = c;
+			}
+		}
+	}
+
+	return 0;
+}
+
+int bvh_intersect_leaves(const rte_bvh_t* bvh, const rte_ray_t* ray, real_t* p_t, bvh_leaf_closest_t leaf, const void* user) {
+	return bvh_traverse_closest(bvh, ray, p_t, leaf, user);
+}
+
+int bvh_occluded_leaves(const rte_bvh_t* bvh, const rte_ray_t* ray, real_t t_max, bvh_leaf_any_t leaf, const void* user) {
+	return bvh_traverse_any(bvh, ray, t_max, leaf, user);
+}
+
+//
+// Spheres
+//
+typedef struct bvh_sphere_query {
+	const sphere_set_t* set;
+	const rte_ray_t* ray;
+} bvh_sphere_query_t;
+
+static int bvh_sphere_leaf_closest(const void* user, int first, int count, real_t* p_t) {
+	const bvh_sphere_query_t* query = (const bvh_sphere_query_t*)user;
+	return sphere_set_intersect(query->set, first, count, query->ray, p_t);
+}
+
+static int bvh_sphere_leaf_any(const void* user, int first, int count, real_t t_max) {
+	const bvh_sphere_query_t* query = (const bvh_sphere_query_t*)user;
+	return sphere_set_occluded(query->set, first, count, query->ray, t_max);
+}
+
+int bvh_intersect_sphere_set(const rte_bvh_t* bvh, const sphere_set_t* set, const rte_ray_t* ray, real_t* p_t) {
+	bvh_sphere_query_t query = {set, ray};
+	return bvh_traverse_closest(bvh, ray, p_t, bvh_sphere_leaf_closest, &query);
+}
+
+int bvh_occluded_sphere_set(const rte_bvh_t* bvh, const sphere_set_t* set, const rte_ray_t* ray, real_t t_max) {
+	bvh_sphere_query_t query = {set, ray};
+	return bvh_traverse_any(bvh, ray, t_max, bvh_sphere_leaf_any, &query);
+}
+
+//
+// Triangles
+//
+typedef struct bvh_triangle_query {
+	const triangle_set_t* set;
+	const rte_ray_t* ray;
+	triangle_ray_t tri_ray;
+
+	real_t u;
+	real_t v;
+} bvh_triangle_query_t;
+
+static int bvh_triangle_leaf_closest(const void* user, int first, int count, real_t* p_t) {
+	bvh_triangle_query_t* query = (bvh_triangle_query_t*)user;
+	return triangle_set_intersect(query->set, first, count, &query->tri_ray, query->ray, p_t, &query->u, &query->v);
+}
+
+static int bvh_triangle_leaf_any(const void* user, int first, int count, real_t t_max) {
+	const bvh_triangle_query_t* query = (const bvh_triangle_query_t*)user;
+	return triangle_set_occluded(query->set, first, count, &query->tri_ray, query->ray, t_max);
+}
+
+int bvh_intersect_triangle_set(const rte_bvh_t* bvh, const triangle_set_t* set, const rte_ray_t* ray, real_t* p_t, real_t* p_u, real_t* p_v) {
+	bvh_triangle_query_t query;
+
+	query.set = set;
+	query.ray = ray;
+	query.u = REAL(0.0);
+	query.v = REAL(0.0);
+
+	triangle_ray_setup(&query.tri_ray, ray);
+
+	int slot = bvh_traverse_closest(bvh, ray, p_t, bvh_triangle_leaf_closest, &query);
+
+	*p_u = query.u;
+	*p_v = query.v;
+
+	return slot;
+}
+
+int bvh_occluded_triangle_set(const rte_bvh_t* bvh, const triangle_set_t* set, const rte_ray_t* ray, real_t t_max) {
+	bvh_triangle_query_t query;
+
+	query.set = set;
+	query.ray = ray;
+
+	triangle_ray_setup(&query.tri_ray, ray);
+
+	return bvh_traverse_any(bvh, ray, t_max, bvh_triangle_leaf_any, &query);
+}
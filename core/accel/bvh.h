@@ -0,0 +1,65 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#ifndef RTEVERYWHERE_BVH_H
+#define RTEVERYWHERE_BVH_H
+
+#include "../math/real.h"
+#include "../math/vectors.h"
+#include "../math/aabb.h"
+#include "../math/ray.h"
+
+#include "../shapes/sphere.h"
+#include "../shapes/sphere_set.h"
+#include "../shapes/triangle_set.h"
+
+#define BVH_STACK_SIZE 64
+
+// Interior nodes have a count of 0 and store their left child in left_first, the right child always follows it
+// Leaves store the offset of their first primitive into the index list instead
+typedef struct rte_bvh_node {
+	rte_aabb_t bounds;
+	int left_first;
+	int count;
+} rte_bvh_node_t;
+
+typedef struct rte_bvh {
+	rte_bvh_node_t* nodes;
+	int node_count;
+
+	// Primitive indices, reordered so every leaf references a contiguous range
+	int* indices;
+	int index_count;
+} rte_bvh_t;
+
+// Builds a binned SAH hierarchy over the given primitive bounds
+// Returns 0 on allocation failure
+extern int bvh_build(rte_bvh_t* bvh, const rte_aabb_t* prim_bounds, int prim_count, int max_leaf_size);
+extern void bvh_free(rte_bvh_t* bvh);
+
+// Recomputes every node's bounds from new primitive bounds, keeping the topology
+// Much cheaper than a rebuild but the tree degrades as primitives drift away from where it was built
+extern void bvh_refit(rte_bvh_t* bvh, const rte_aabb_t* prim_bounds);
+
+// Leaf tests for the generic traversals below, first and count are a range of the index list
+// Closest returns the index of a hit nearer than *p_t (and updates it) or -1, any returns 1 on a hit before t_max
+typedef int (*bvh_leaf_closest_t)(const void* user, int first, int count, real_t* p_t);
+typedef int (*bvh_leaf_any_t)(const void* user, int first, int count, real_t t_max);
+
+extern int bvh_intersect_leaves(const rte_bvh_t* bvh, const rte_ray_t* ray, real_t* p_t, bvh_leaf_closest_t leaf, const void* user);
+extern int bvh_occluded_leaves(const rte_bvh_t* bvh, const rte_ray_t* ray, real_t t_max, bvh_leaf_any_t leaf, const void* user);
+
+// The sphere set must be built in BVH index order, so leaves map directly onto slot ranges
+// Returns the slot of the nearest hit closer than *p_t and updates *p_t, or -1 if nothing was hit
+extern int bvh_intersect_sphere_set(const rte_bvh_t* bvh, const sphere_set_t* set, const rte_ray_t* ray, real_t* p_t);
+
+// Any-hit traversal, returns as soon as a sphere blocks the ray before t_max
+extern int bvh_occluded_sphere_set(const rte_bvh_t* bvh, const sphere_set_t* set, const rte_ray_t* ray, real_t t_max);
+
+// Triangle versions of the above, the set follows the same BVH order rule
+// p_u and p_v receive the barycentrics of the hit, see triangle_ray_intersect
+extern int bvh_intersect_triangle_set(const rte_bvh_t* bvh, const triangle_set_t* set, const rte_ray_t* ray, real_t* p_t, real_t* p_u, real_t* p_v);
+extern int bvh_occluded_triangle_set(const rte_bvh_t* bvh, const triangle_set_t* set, const rte_ray_t* ray, real_t t_max);
+
+#endif //RTEVERYWHERE_BVH_H
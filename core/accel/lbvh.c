@@ -0,0 +1,694 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#include "lbvh.h"
+
+#include "../threading/thread.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define LBVH_GRAIN 4096
+
+// The sort always uses the same number of chunks so the result doesn't depend on the thread count
+#define LBVH_SORT_CHUNKS 64
+#define LBVH_RADIX_BITS 8
+#define LBVH_RADIX_BUCKETS (1 << LBVH_RADIX_BITS)
+
+#define LBVH_TREELET_LEAVES 7
+#define LBVH_TREELET_SUBSETS (1 << LBVH_TREELET_LEAVES)
+
+// Relative costs used by the SAH, only their ratio matters
+#define LBVH_TRAVERSAL_COST REAL(1.0)
+#define LBVH_INTERSECT_COST REAL(1.0)
+
+typedef struct lbvh_meta {
+	real_t cost; // SAH cost of the subtree under the slot
+	int pair; // First slot of the Karras child pair this node owns, -1 for single primitive leaves
+} lbvh_meta_t;
+
+typedef struct lbvh_builder {
+	rte_bvh_t* bvh;
+	const rte_aabb_t* prim_bounds;
+	int count;
+	int max_leaf_size;
+	int morton_bits;
+
+	rte_aabb_t centroid_bounds;
+	rte_aabb_t chunk_bounds[LBVH_SORT_CHUNKS];
+	int chunk_size;
+
+	// Radix sort state, src and dst swap every pass
+	uint64_t* keys;
+	uint64_t* key_scratch;
+	int* value_scratch;
+
+	uint64_t* src_keys;
+	uint64_t* dst_keys;
+	int* src_values;
+	int* dst_values;
+
+	int shift;
+	int histograms[LBVH_SORT_CHUNKS][LBVH_RADIX_BUCKETS];
+
+	// Indexed by Karras interior node (i.e. pair) index
+	int* slot_of_internal;
+	int* internal_first;
+	int* internal_count;
+	volatile int* visits;
+
+	int* leaf_slot; // Slot holding the leaf of sorted primitive k
+	lbvh_meta_t* meta;
+
+	int treelets;
+} lbvh_builder_t;
+
+rte_lbvh_options_t lbvh_default_options() {
+	rte_lbvh_options_t options;
+
+	options.morton_bits = 30;
+	options.max_leaf_size = 4;
+	options.treelet_passes = 0;
+
+	return options;
+}
+
+//
+// Morton codes
+//
+static uint64_t lbvh_expand_bits(uint64_t v) {
+	// Spreads the low 21 bits out so two zero bits follow each one
+	v &= 0x1fffff;
+	v = (v | v << 32) & 0x1f00000000ffffULL;
+	v = (v | v << 16) & 0x1f0000ff0000ffULL;
+	v = (v | v << 8) & 0x100f00f00f00f00fULL;
+	v = (v | v << 4) & 0x10c30c30c30c30c3ULL;
+	v = (v | v << 2) & 0x1249249249249249ULL;
+
+	return v;
+}
+
+static int lbvh_clz64(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+	return v == 0 ? 64 : __builtin_clzll(v);
+#else
+	int zeros = 0;
+
+	for (uint64_t bit = (uint64_t)1 << 63; bit != 0 && (v & bit) == 0; bit >>= 1) {
+		zeros++;
+	}
+
+	return zeros;
+#endif
+}
+
+static void lbvh_bounds_job(void* user, int begin, int end) {
+	lbvh_builder_t* builder = (lbvh_builder_t*)user;
+
+	for (int c = begin; c < end; c++) {
+		rte_aabb_t* bounds = &builder->chunk_bounds[c];
+		aabb_empty(bounds);
+
+		int last = (c + 1) * builder->chunk_size < builder->count ? (c + 1) * builder->chunk_size : builder->count;
+
+		for (int p = c * builder->chunk_size; p < last; p++) {
+			rvec3_t centroid;
+			aabb_centroid(RVEC_OUT(centroid), &builder->prim_bounds[p]);
+
+			aabb_grow_point(bounds, centroid);
+		}
+	}
+}
+
+static void lbvh_keys_job(void* user, int begin, int end) {
+	lbvh_builder_t* builder = (lbvh_builder_t*)user;
+
+	int axis_bits = builder->morton_bits / 3;
+	real_t cells = (real_t)((1 << axis_bits) - 1);
+
+	for (int p = begin; p < end; p++) {
+		rvec3_t centroid;
+		aabb_centroid(RVEC_OUT(centroid), &builder->prim_bounds[p]);
+
+		uint64_t key = 0;
+
+		for (int a = 0; a < 3; a++) {
+			real_t extent = builder->centroid_bounds.max[a] - builder->centroid_bounds.min[a];
+			real_t cell = REAL(0.0);
+
+			if (extent > REAL(0.0)) {
+				cell = (centroid[a] - builder->centroid_bounds.min[a]) / extent * cells;
+			}
+
+			key |= lbvh_expand_bits((uint64_t)cell) << (2 - a);
+		}
+
+		builder->keys[p] = key;
+		builder->bvh->indices[p] = p;
+	}
+}
+
+//
+// Radix sort
+// Each chunk counts its digits, a serial scan turns those into per chunk offsets and the chunks scatter in parallel
+//
+static void lbvh_histogram_job(void* user, int begin, int end) {
+	lbvh_builder_t* builder = (lbvh_builder_t*)user;
+
+	for (int c = begin; c < end; c++) {
+		int* histogram = builder->histograms[c];
+
+		for (int b = 0; b < LBVH_RADIX_BUCKETS; b++) {
+			histogram[b] = 0;
+		}
+
+		int last = (c + 1) * builder->chunk_size < builder->count ? (c + 1) * builder->chunk_size : builder->count;
+
+		for (int i = c * builder->chunk_size; i < last; i++) {
+			histogram[(builder->src_keys[i] >> builder->shift) & (LBVH_RADIX_BUCKETS - 1)]++;
+		}
+	}
+}
+
+static void lbvh_scatter_job(void* user, int begin, int end) {
+	lbvh_builder_t* builder = (lbvh_builder_t*)user;
+
+	for (int c = begin; c < end; c++) {
+		int* offsets = builder->histograms[c];
+		int last = (c + 1) * builder->chunk_size < builder->count ? (c + 1) * builder->chunk_size : builder->count;
+
+		for (int i = c * builder->chunk_size; i < last; i++) {
+			int dst = offsets[(builder->src_keys[i] >> builder->shift) & (LBVH_RADIX_BUCKETS - 1)]++;
+
+			builder->dst_keys[dst] = builder->src_keys[i];
+			builder->dst_values[dst] = builder->src_values[i];
+		}
+	}
+}
+
+static void lbvh_sort(lbvh_builder_t* builder) {
+	int passes = (builder->morton_bits + LBVH_RADIX_BITS - 1) / LBVH_RADIX_BITS;
+
+	// An even number of passes leaves the result in the original arrays
+	passes += passes & 1;
+
+	builder->src_keys = builder->keys;
+	builder->dst_keys = builder->key_scratch;
+	builder->src_values = builder->bvh->indices;
+	builder->dst_values = builder->value_scratch;
+
+	for (int pass = 0; pass < passes; pass++) {
+		builder->shift = pass * LBVH_RADIX_BITS;
+
+		rte_parallel_for(LBVH_SORT_CHUNKS, 1, lbvh_histogram_job, builder);
+
+		int sum = 0;
+		for (int b = 0; b < LBVH_RADIX_BUCKETS; b++) {
+			for (int c = 0; c < LBVH_SORT_CHUNKS; c++) {
+				int count = builder->histograms[c][b];
+				builder->histograms[c][b] = sum;
+				sum += count;
+			}
+		}
+
+		rte_parallel_for(LBVH_SORT_CHUNKS, 1, lbvh_scatter_job, builder);
+
+		uint64_t* swap_keys = builder->src_keys;
+		builder->src_keys = builder->dst_keys;
+		builder->dst_keys = swap_keys;
+
+		int* swap_values = builder->src_values;
+		builder->src_values = builder->dst_values;
+		builder->dst_values = swap_values;
+	}
+}
+
+//
+// Hierarchy emission
+//
+
+// Length of the common key prefix between sorted primitives i and j, duplicates fall back to their index
+static int lbvh_delta(const lbvh_builder_t* builder, int i, int j) {
+	if (j < 0 || j >= builder->count) {
+		return -1;
+	}
+
+	uint64_t x = builder->keys[i] ^ builder->keys[j];
+
+	if (x == 0) {
+		return 64 + lbvh_clz64((uint64_t)(i ^ j));
+	}
+
+	return lbvh_clz64(x);
+}
+
+static void lbvh_emit_job(void* user, int begin, int end) {
+	lbvh_builder_t* builder = (lbvh_builder_t*)user;
+	rte_bvh_node_t* nodes = builder->bvh->nodes;
+
+	for (int i = begin; i < end; i++) {
+		// Find which end of the range i sits on and how far the range reaches
+		int d = lbvh_delta(builder, i, i + 1) > lbvh_delta(builder, i, i - 1) ? 1 : -1;
+		int delta_min = lbvh_delta(builder, i, i - d);
+
+		int length_max = 2;
+		while (lbvh_delta(builder, i, i + length_max * d) > delta_min) {
+			length_max *= 2;
+		}
+
+		int length = 0;
+		for (int t = length_max / 2; t >= 1; t /= 2) {
+			if (lbvh_delta(builder, i, i + (length + t) * d) > delta_min) {
+				length += t;
+			}
+		}
+
+		int j = i + length * d;
+		int delta_node = lbvh_delta(builder, i, j);
+
+		// Binary search for the split, where the common prefix gets longer
+		int split = 0;
+		int t = length;
+
+		do {
+			t = (t + 1) / 2;
+
+			if (lbvh_delta(builder, i, i + (split + t) * d) > delta_node) {
+				split += t;
+			}
+		} while (t > 1);
+
+		int gamma = i + split * d + (d < 0 ? -1 : 0);
+
+		int first = i < j ? i : j;
+		int last = i < j ? j : i;
+
+		builder->internal_first[i] = first;
+		builder->internal_count[i] = last - first + 1;
+
+		int pair = 1 + 2 * i;
+
+		for (int c = 0; c < 2; c++) {
+			int child = gamma + c;
+			int slot = pair + c;
+
+			if (child == (c == 0 ? first : last)) {
+				nodes[slot].left_first = child;
+				nodes[slot].count = 1;
+
+				builder->meta[slot].pair = -1;
+				builder->leaf_slot[child] = slot;
+			} else {
+				builder->slot_of_internal[child] = slot;
+			}
+		}
+	}
+}
+
+// Interior records are written once every slot is known
+static void lbvh_link_job(void* user, int begin, int end) {
+	lbvh_builder_t* builder = (lbvh_builder_t*)user;
+
+	for (int i = begin; i < end; i++) {
+		int slot = builder->slot_of_internal[i];
+
+		builder->bvh->nodes[slot].left_first = 1 + 2 * i;
+		builder->bvh->nodes[slot].count = 0;
+
+		builder->meta[slot].pair = 1 + 2 * i;
+	}
+}
+
+//
+// Treelet restructuring
+// The treelet under a node is grown to 7 leaves by opening its largest interior leaf, then the cheapest topology over
+// those leaves is found exhaustively and written back into the slots the treelet already owned
+//
+typedef struct lbvh_treelet {
+	rte_bvh_node_t leaves[LBVH_TREELET_LEAVES];
+	lbvh_meta_t leaf_meta[LBVH_TREELET_LEAVES];
+
+	int pairs[LBVH_TREELET_LEAVES - 1];
+	int next_pair;
+
+	rte_aabb_t bounds[LBVH_TREELET_SUBSETS];
+	real_t cost[LBVH_TREELET_SUBSETS];
+	unsigned char partition[LBVH_TREELET_SUBSETS];
+} lbvh_treelet_t;
+
+static void lbvh_treelet_emit(lbvh_builder_t* builder, lbvh_treelet_t* treelet, unsigned int mask, int slot) {
+	rte_bvh_node_t* node = &builder->bvh->nodes[slot];
+	lbvh_meta_t* meta = &builder->meta[slot];
+
+	if ((mask & (mask - 1)) == 0) {
+		int leaf = 0;
+		while (!(mask & (1u << leaf))) {
+			leaf++;
+		}
+
+		*node = treelet->leaves[leaf];
+		*meta = treelet->leaf_meta[leaf];
+	} else {
+		int pair = treelet->pairs[treelet->next_pair++];
+
+		node->bounds = treelet->bounds[mask];
+		node->left_first = pair;
+		node->count = 0;
+
+		meta->cost = treelet->cost[mask];
+		meta->pair = pair;
+
+		lbvh_treelet_emit(builder, treelet, treelet->partition[mask], pair);
+		lbvh_treelet_emit(builder, treelet, mask & ~treelet->partition[mask], pair + 1);
+	}
+
+	// Keep the bottom-up walks of later passes pointing at the moved nodes
+	if (meta->pair == -1) {
+		builder->leaf_slot[node->left_first] = slot;
+	} else {
+		builder->slot_of_internal[(meta->pair - 1) / 2] = slot;
+	}
+}
+
+static void lbvh_restructure(lbvh_builder_t* builder, int root_slot) {
+	rte_bvh_node_t* nodes = builder->bvh->nodes;
+
+	lbvh_treelet_t treelet;
+	int leaf_slots[LBVH_TREELET_LEAVES];
+
+	int root_pair = nodes[root_slot].left_first;
+
+	leaf_slots[0] = root_pair;
+	leaf_slots[1] = root_pair + 1;
+	treelet.pairs[0] = root_pair;
+
+	int leaf_count = 2;
+
+	while (leaf_count < LBVH_TREELET_LEAVES) {
+		int best = -1;
+		real_t best_area = REAL(0.0);
+
+		for (int l = 0; l < leaf_count; l++) {
+			const rte_bvh_node_t* leaf = &nodes[leaf_slots[l]];
+
+			if (leaf->count == 0) {
+				real_t area = aabb_surface_area(&leaf->bounds);
+
+				if (best == -1 || area > best_area) {
+					best = l;
+					best_area = area;
+				}
+			}
+		}
+
+		if (best == -1) {
+			break;
+		}
+
+		int pair = nodes[leaf_slots[best]].left_first;
+
+		treelet.pairs[leaf_count - 1] = pair;
+
+		leaf_slots[best] = pair;
+		leaf_slots[leaf_count++] = pair + 1;
+	}
+
+	// Two or three leaves only have one possible topology
+	if (leaf_count < 4) {
+		return;
+	}
+
+	for (int l = 0; l < leaf_count; l++) {
+		treelet.leaves[l] = nodes[leaf_slots[l]];
+		treelet.leaf_meta[l] = builder->meta[leaf_slots[l]];
+	}
+
+	unsigned int full = (1u << leaf_count) - 1;
+
+	aabb_empty(&treelet.bounds[0]);
+
+	for (unsigned int mask = 1; mask <= full; mask++) {
+		int leaf = 0;
+		while (!(mask & (1u << leaf))) {
+			leaf++;
+		}
+
+		// Every subset is a smaller one plus its lowest leaf
+		rte_aabb_t* bounds = &treelet.bounds[mask];
+
+		*bounds = treelet.bounds[mask & (mask - 1)];
+		aabb_grow(bounds, &treelet.leaves[leaf].bounds);
+
+		if ((mask & (mask - 1)) == 0) {
+			treelet.cost[mask] = treelet.leaf_meta[leaf].cost;
+			continue;
+		}
+
+		// Only partitions holding the lowest leaf are tried, the mirrored ones cost the same
+		unsigned int lowest = mask & (~mask + 1);
+		real_t best_cost = REAL(0.0);
+		unsigned int best_partition = 0;
+
+		for (unsigned int part = (mask - 1) & mask; part != 0; part = (part - 1) & mask) {
+			if (!(part & lowest)) {
+				continue;
+			}
+
+			real_t cost = treelet.cost[part] + treelet.cost[mask & ~part];
+
+			if (best_partition == 0 || cost < best_cost) {
+				best_cost = cost;
+				best_partition = part;
+			}
+		}
+
+		treelet.cost[mask] = LBVH_TRAVERSAL_COST * aabb_surface_area(bounds) + best_cost;
+		treelet.partition[mask] = (unsigned char)best_partition;
+	}
+
+	treelet.next_pair = 0;
+	lbvh_treelet_emit(builder, &treelet, full, root_slot);
+}
+
+//
+// Bottom-up pass
+// Every primitive walks towards the root, the second walk to reach an interior node finishes it and carries on
+//
+static void lbvh_refit_job(void* user, int begin, int end) {
+	lbvh_builder_t* builder = (lbvh_builder_t*)user;
+	rte_bvh_node_t* nodes = builder->bvh->nodes;
+
+	for (int k = begin; k < end; k++) {
+		int slot = builder->leaf_slot[k];
+
+		nodes[slot].bounds = builder->prim_bounds[builder->bvh->indices[k]];
+		builder->meta[slot].cost = LBVH_INTERSECT_COST * aabb_surface_area(&nodes[slot].bounds);
+
+		while (slot != 0) {
+			int i = (slot - 1) / 2;
+
+			// The first walk to arrive stops, its sibling may not be finished yet
+			if (rte_atomic_add(&builder->visits[i], 1) == 0) {
+				break;
+			}
+
+			slot = builder->slot_of_internal[i];
+
+			rte_bvh_node_t* node = &nodes[slot];
+			int pair = builder->meta[slot].pair;
+
+			node->bounds = nodes[pair].bounds;
+			aabb_grow(&node->bounds, &nodes[pair + 1].bounds);
+
+			real_t area = aabb_surface_area(&node->bounds);
+
+			if (node->count > 0) {
+				builder->meta[slot].cost = LBVH_INTERSECT_COST * area * (real_t)node->count;
+				continue;
+			}
+
+			if (builder->treelets) {
+				lbvh_restructure(builder, slot);
+			}
+
+			real_t split_cost = LBVH_TRAVERSAL_COST * area + builder->meta[pair].cost + builder->meta[pair + 1].cost;
+
+			// Small subtrees become leaves when the SAH says so, only before restructuring while they still cover one range
+			if (!builder->treelets && builder->internal_count[i] <= builder->max_leaf_size) {
+				real_t leaf_cost = LBVH_INTERSECT_COST * area * (real_t)builder->internal_count[i];
+
+				if (leaf_cost <= split_cost) {
+					node->left_first = builder->internal_first[i];
+					node->count = builder->internal_count[i];
+
+					split_cost = leaf_cost;
+				}
+			}
+
+			builder->meta[slot].cost = split_cost;
+		}
+	}
+}
+
+static void lbvh_refit(lbvh_builder_t* builder, int treelets) {
+	for (int i = 0; i < builder->count - 1; i++) {
+		builder->visits[i] = 0;
+	}
+
+	builder->treelets = treelets;
+	rte_parallel_for(builder->count, LBVH_GRAIN, lbvh_refit_job, builder);
+}
+
+// Returns the depth of the deepest leaf, collapsing interior nodes that would go past max_depth when they cover a contiguous range
+static int lbvh_limit_depth(lbvh_builder_t* builder, int max_depth, int collapse) {
+	rte_bvh_node_t* nodes = builder->bvh->nodes;
+
+	int stack[BVH_STACK_SIZE];
+	int stack_depth[BVH_STACK_SIZE];
+	int stack_size = 0;
+	int deepest = 0;
+
+	stack[stack_size] = 0;
+	stack_depth[stack_size] = 0;
+	stack_size++;
+
+	while (stack_size > 0) {
+		stack_size--;
+
+		int slot = stack[stack_size];
+		int depth = stack_depth[stack_size];
+
+		rte_bvh_node_t* node = &nodes[slot];
+
+		if (node->count == 0 && depth >= max_depth) {
+			if (!collapse) {
+				return depth + 1;
+			}
+
+			int i = (builder->meta[slot].pair - 1) / 2;
+
+			node->left_first = builder->internal_first[i];
+			node->count = builder->internal_count[i];
+		}
+
+		if (depth > deepest) {
+			deepest = depth;
+		}
+
+		if (node->count == 0) {
+			for (int c = 0; c < 2; c++) {
+				stack[stack_size] = node->left_first + c;
+				stack_depth[stack_size] = depth + 1;
+				stack_size++;
+			}
+		}
+	}
+
+	return deepest;
+}
+
+int lbvh_build(rte_bvh_t* bvh, const rte_aabb_t* prim_bounds, int prim_count, const rte_lbvh_options_t* options) {
+	bvh->nodes = NULL;
+	bvh->node_count = 0;
+	bvh->indices = NULL;
+	bvh->index_count = 0;
+
+	if (prim_count <= 0) {
+		return 1;
+	}
+
+	lbvh_builder_t* builder = (lbvh_builder_t*)malloc(sizeof(lbvh_builder_t));
+
+	if (builder == NULL) {
+		return 0;
+	}
+
+	int internal_count = prim_count - 1 > 0 ? prim_count - 1 : 1;
+
+	builder->bvh = bvh;
+	builder->prim_bounds = prim_bounds;
+	builder->count = prim_count;
+	builder->max_leaf_size = options->max_leaf_size < 1 ? 1 : options->max_leaf_size;
+	builder->morton_bits = options->morton_bits > 30 ? 63 : 30;
+	builder->chunk_size = (prim_count + LBVH_SORT_CHUNKS - 1) / LBVH_SORT_CHUNKS;
+
+	bvh->nodes = (rte_bvh_node_t*)malloc(sizeof(rte_bvh_node_t) * (2 * prim_count - 1));
+	bvh->indices = (int*)malloc(sizeof(int) * prim_count);
+
+	builder->keys = (uint64_t*)malloc(sizeof(uint64_t) * prim_count);
+	builder->key_scratch = (uint64_t*)malloc(sizeof(uint64_t) * prim_count);
+	builder->value_scratch = (int*)malloc(sizeof(int) * prim_count);
+
+	builder->slot_of_internal = (int*)malloc(sizeof(int) * internal_count);
+	builder->internal_first = (int*)malloc(sizeof(int) * internal_count);
+	builder->internal_count = (int*)malloc(sizeof(int) * internal_count);
+	builder->visits = (volatile int*)malloc(sizeof(int) * internal_count);
+
+	builder->leaf_slot = (int*)malloc(sizeof(int) * prim_count);
+	builder->meta = (lbvh_meta_t*)malloc(sizeof(lbvh_meta_t) * (2 * prim_count - 1));
+
+	int success = bvh->nodes != NULL && bvh->indices != NULL && builder->keys != NULL && builder->key_scratch != NULL
+		&& builder->value_scratch != NULL && builder->slot_of_internal != NULL && builder->internal_first != NULL
+		&& builder->internal_count != NULL && builder->visits != NULL && builder->leaf_slot != NULL && builder->meta != NULL;
+
+	if (success) {
+		rte_parallel_for(LBVH_SORT_CHUNKS, 1, lbvh_bounds_job, builder);
+
+		aabb_empty(&builder->centroid_bounds);
+		for (int c = 0; c < LBVH_SORT_CHUNKS; c++) {
+			aabb_grow(&builder->centroid_bounds, &builder->chunk_bounds[c]);
+		}
+
+		rte_parallel_for(prim_count, LBVH_GRAIN, lbvh_keys_job, builder);
+		lbvh_sort(builder);
+
+		bvh->index_count = prim_count;
+		bvh->node_count = 2 * prim_count - 1;
+
+		if (prim_count == 1) {
+			bvh->nodes[0].bounds = prim_bounds[0];
+			bvh->nodes[0].left_first = 0;
+			bvh->nodes[0].count = 1;
+		} else {
+			builder->slot_of_internal[0] = 0;
+
+			rte_parallel_for(prim_count - 1, LBVH_GRAIN, lbvh_emit_job, builder);
+			rte_parallel_for(prim_count - 1, LBVH_GRAIN, lbvh_link_job, builder);
+
+			// Long runs of near identical keys can go deeper than the traversal stack allows
+			lbvh_limit_depth(builder, BVH_STACK_SIZE - 1, 1);
+			lbvh_refit(builder, 0);
+
+			for (int pass = 0; pass < options->treelet_passes; pass++) {
+				lbvh_refit(builder, 1);
+			}
+
+			// Restructuring can deepen the tree, in the rare case that goes too far fall back to the plain LBVH
+			if (options->treelet_passes > 0 && lbvh_limit_depth(builder, BVH_STACK_SIZE - 1, 0) > BVH_STACK_SIZE - 1) {
+				rte_parallel_for(prim_count - 1, LBVH_GRAIN, lbvh_emit_job, builder);
+				rte_parallel_for(prim_count - 1, LBVH_GRAIN, lbvh_link_job, builder);
+
+				lbvh_limit_depth(builder, BVH_STACK_SIZE - 1, 1);
+				lbvh_refit(builder, 0);
+			}
+		}
+	}
+
+	free(builder->keys);
+	free(builder->key_scratch);
+	free(builder->value_scratch);
+	free(builder->slot_of_internal);
+	free(builder->internal_first);
+	free(builder->internal_count);
+	free((void*)builder->visits);
+	free(builder->leaf_slot);
+	free(builder->meta);
+	free(builder);
+
+	if (!success) {
+		bvh_free(bvh);
+	}
+
+	return success;
+}
@@ -0,0 +1,30 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#ifndef RTEVERYWHERE_LBVH_H
+#define RTEVERYWHERE_LBVH_H
+
+#include "bvh.h"
+
+//
+// Linear BVH builder (Karras 2012)
+// Primitives are sorted along a Morton curve and every interior node is emitted independently, so the whole build
+// runs across all cores. Trees are worse than bvh_build's SAH trees, the optional treelet pass (Karras & Aila 2013)
+// wins most of that back for a fraction of a full SAH build
+//
+// The result is a regular rte_bvh_t, the interior node with Karras index i keeps its children in slots 1 + 2i and 2 + 2i
+//
+
+typedef struct rte_lbvh_options {
+	int morton_bits; // 30 or 63, more bits separate dense clusters better but double the sort passes
+	int max_leaf_size;
+	int treelet_passes; // 0 skips the treelet optimization
+} rte_lbvh_options_t;
+
+extern rte_lbvh_options_t lbvh_default_options();
+
+// Same contract as bvh_build, returns 0 on allocation failure
+extern int lbvh_build(rte_bvh_t* bvh, const rte_aabb_t* prim_bounds, int prim_count, const rte_lbvh_options_t* options);
+
+#endif //RTEVERYWHERE_LBVH_H
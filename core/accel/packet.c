@@ -0,0 +1,327 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#include "packet.h"
+
+#include <math.h>
+
+#define PACKET_ALL_LANES(COUNT) ((COUNT) >= 32 ? 0xFFFFFFFFu : (1u << (COUNT)) - 1)
+
+void packet_setup(rte_packet_t* packet, const rte_ray_t* rays, const real_t* t_max, int count) {
+	packet->count = count;
+
+	for (int l = 0; l < PACKET_SIZE; l++) {
+		// Unused lanes mirror the first ray so they never produce NaNs, they are always masked out
+		const rte_ray_t* ray = &rays[l < count ? l : 0];
+
+		packet->origin_x[l] = ray->origin[0];
+		packet->origin_y[l] = ray->origin[1];
+		packet->origin_z[l] = ray->origin[2];
+
+		packet->dir_x[l] = ray->direction[0];
+		packet->dir_y[l] = ray->direction[1];
+		packet->dir_z[l] = ray->direction[2];
+
+		packet->inv_x[l] = REAL(1.0) / ray->direction[0];
+		packet->inv_y[l] = REAL(1.0) / ray->direction[1];
+		packet->inv_z[l] = REAL(1.0) / ray->direction[2];
+
+		packet->t[l] = l < count ? t_max[l] : REAL(0.0);
+		packet->slot[l] = -1;
+	}
+
+	packet->shared_origin = 1;
+
+	for (int l = 1; l < count; l++) {
+		if (rays[l].origin[0] != rays[0].origin[0] || rays[l].origin[1] != rays[0].origin[1] || rays[l].origin[2] != rays[0].origin[2]) {
+			packet->shared_origin = 0;
+			break;
+		}
+	}
+
+	// An axis can only bound the frustum if no ray flips direction along it
+	for (int a = 0; a < 3; a++) {
+		const real_t* inv = a == 0 ? packet->inv_x : (a == 1 ? packet->inv_y : packet->inv_z);
+
+		int positive = 0;
+		int negative = 0;
+
+		packet->inv_min[a] = inv[0];
+		packet->inv_max[a] = inv[0];
+
+		for (int l = 0; l < count; l++) {
+			if (rays[l].direction[a] > 0) {
+				positive++;
+			} else if (rays[l].direction[a] < 0) {
+				negative++;
+			}
+
+			packet->inv_min[a] = real_min(packet->inv_min[a], inv[l]);
+			packet->inv_max[a] = real_max(packet->inv_max[a], inv[l]);
+		}
+
+		packet->axis_coherent[a] = positive == count || negative == count;
+	}
+}
+
+//
+// Culling
+//
+
+// Interval test of the whole packet against a box, only rejects boxes no lane can hit
+static int packet_frustum_culled(const rte_packet_t* packet, const rte_aabb_t* bounds, real_t t_far) {
+	if (!packet->shared_origin) {
+		return 0;
+	}
+
+	const real_t origin[3] = {packet->origin_x[0], packet->origin_y[0], packet->origin_z[0]};
+
+	real_t entry = REAL(0.0);
+	real_t exit = t_far;
+
+	for (int a = 0; a < 3; a++) {
+		if (!packet->axis_coherent[a]) {
+			continue;
+		}
+
+		int positive = packet->inv_min[a] > 0;
+
+		real_t near_dist = (positive ? bounds->min[a] : bounds->max[a]) - origin[a];
+		real_t far_dist = (positive ? bounds->max[a] : bounds->min[a]) - origin[a];
+
+		// Every lane's slab distances lie between the products with the extreme inverse directions
+		real_t entry_a = real_min(near_dist * packet->inv_min[a], near_dist * packet->inv_max[a]);
+		real_t exit_a = real_max(far_dist * packet->inv_min[a], far_dist * packet->inv_max[a]);
+
+		entry = real_max(entry, entry_a);
+		exit = real_min(exit, exit_a);
+	}
+
+	return entry > exit;
+}
+
+// Returns the subset of active lanes whose ray enters the box before their closest hit
+static unsigned int packet_node_mask(const rte_packet_t* packet, const rte_aabb_t* bounds, unsigned int active) {
+	unsigned int result = 0;
+
+#ifdef RSIMD_WIDTH
+	const rsimd_t zero = rsimd_set1(REAL(0.0));
+
+	const rsimd_t min_x = rsimd_set1(bounds->min[0]);
+	const rsimd_t min_y = rsimd_set1(bounds->min[1]);
+	const rsimd_t min_z = rsimd_set1(bounds->min[2]);
+
+	const rsimd_t max_x = rsimd_set1(bounds->max[0]);
+	const rsimd_t max_y = rsimd_set1(bounds->max[1]);
+	const rsimd_t max_z = rsimd_set1(bounds->max[2]);
+
+	for (int base = 0; base < PACKET_SIZE; base += RSIMD_WIDTH) {
+		unsigned int group = (active >> base) & PACKET_ALL_LANES(RSIMD_WIDTH);
+
+		if (group == 0) {
+			continue;
+		}
+
+		rsimd_t ox = rsimd_load(packet->origin_x + base);
+		rsimd_t oy = rsimd_load(packet->origin_y + base);
+		rsimd_t oz = rsimd_load(packet->origin_z + base);
+
+		rsimd_t inv_x = rsimd_load(packet->inv_x + base);
+		rsimd_t inv_y = rsimd_load(packet->inv_y + base);
+		rsimd_t inv_z = rsimd_load(packet->inv_z + base);
+
+		rsimd_t tx0 = rsimd_mul(rsimd_sub(min_x, ox), inv_x);
+		rsimd_t tx1 = rsimd_mul(rsimd_sub(max_x, ox), inv_x);
+		rsimd_t ty0 = rsimd_mul(rsimd_sub(min_y, oy), inv_y);
+		rsimd_t ty1 = rsimd_mul(rsimd_sub(max_y, oy), inv_y);
+		rsimd_t tz0 = rsimd_mul(rsimd_sub(min_z, oz), inv_z);
+		rsimd_t tz1 = rsimd_mul(rsimd_sub(max_z, oz), inv_z);
+
+		rsimd_t t_near = rsimd_max(rsimd_max(zero, rsimd_min(tx0, tx1)), rsimd_max(rsimd_min(ty0, ty1), rsimd_min(tz0, tz1)));
+		rsimd_t t_far = rsimd_min(rsimd_min(rsimd_load(packet->t + base), rsimd_max(tx0, tx1)), rsimd_min(rsimd_max(ty0, ty1), rsimd_max(tz0, tz1)));
+
+		result |= (rsimd_mask_bits(rsimd_cmp_le(t_near, t_far)) & group) << base;
+	}
+#else
+	for (int l = 0; l < packet->count; l++) {
+		if (!(active & (1u << l))) {
+			continue;
+		}
+
+		rvec3_t origin = {packet->origin_x[l], packet->origin_y[l], packet->origin_z[l]};
+		rvec3_t inv_direction = {packet->inv_x[l], packet->inv_y[l], packet->inv_z[l]};
+
+		real_t t_near;
+		if (aabb_ray_intersect(bounds, origin, inv_direction, packet->t[l], &t_near)) {
+			result |= 1u << l;
+		}
+	}
+#endif
+
+	return result;
+}
+
+//
+// Leaves
+//
+static void packet_intersect_leaf(const sphere_set_t* set, int first, int count, rte_packet_t* packet, unsigned int active) {
+	for (int s = first; s < first + count; s++) {
+#ifdef RSIMD_WIDTH
+		const rsimd_t zero = rsimd_set1(REAL(0.0));
+
+		const rsimd_t cx = rsimd_set1(set->center_x[s]);
+		const rsimd_t cy = rsimd_set1(set->center_y[s]);
+		const rsimd_t cz = rsimd_set1(set->center_z[s]);
+		const rsimd_t r2 = rsimd_set1(set->radius_sqr[s]);
+
+		for (int base = 0; base < PACKET_SIZE; base += RSIMD_WIDTH) {
+			unsigned int group = (active >> base) & PACKET_ALL_LANES(RSIMD_WIDTH);
+
+			if (group == 0) {
+				continue;
+			}
+
+			// Same math as sphere_set_intersect, but one ray per lane against a single sphere
+			rsimd_t dx = rsimd_sub(rsimd_load(packet->origin_x + base), cx);
+			rsimd_t dy = rsimd_sub(rsimd_load(packet->origin_y + base), cy);
+			rsimd_t dz = rsimd_sub(rsimd_load(packet->origin_z + base), cz);
+
+			rsimd_t dir_x = rsimd_load(packet->dir_x + base);
+			rsimd_t dir_y = rsimd_load(packet->dir_y + base);
+			rsimd_t dir_z = rsimd_load(packet->dir_z + base);
+
+			rsimd_t p1 = rsimd_sub(zero, rsimd_add(rsimd_add(rsimd_mul(dir_x, dx), rsimd_mul(dir_y, dy)), rsimd_mul(dir_z, dz)));
+			rsimd_t d2 = rsimd_add(rsimd_add(rsimd_mul(dx, dx), rsimd_mul(dy, dy)), rsimd_mul(dz, dz));
+			rsimd_t p2sqr = rsimd_add(rsimd_sub(rsimd_mul(p1, p1), d2), r2);
+
+			rsimd_t p2 = rsimd_sqrt(rsimd_max(p2sqr, zero));
+			rsimd_t t_near = rsimd_sub(p1, p2);
+			rsimd_t t = rsimd_select(rsimd_cmp_gt(t_near, zero), rsimd_add(p1, p2), t_near);
+
+			rsimd_t closest = rsimd_load(packet->t + base);
+
+			rsimd_mask_t hit = rsimd_mask_from_bits(group);
+			hit = rsimd_mask_and(hit, rsimd_cmp_le(zero, p2sqr));
+			hit = rsimd_mask_and(hit, rsimd_cmp_gt(t, zero));
+			hit = rsimd_mask_and(hit, rsimd_cmp_lt(t, closest));
+
+			unsigned int bits = rsimd_mask_bits(hit);
+
+			if (bits == 0) {
+				continue;
+			}
+
+			rsimd_store(packet->t + base, rsimd_select(hit, closest, t));
+
+			for (int l = 0; l < RSIMD_WIDTH; l++) {
+				if (bits & (1u << l)) {
+					packet->slot[base + l] = s;
+				}
+			}
+		}
+#else
+		for (int l = 0; l < packet->count; l++) {
+			if (!(active & (1u << l))) {
+				continue;
+			}
+
+			real_t dx = packet->origin_x[l] - set->center_x[s];
+			real_t dy = packet->origin_y[l] - set->center_y[s];
+			real_t dz = packet->origin_z[l] - set->center_z[s];
+
+			real_t p1 = -(packet->dir_x[l] * dx + packet->dir_y[l] * dy + packet->dir_z[l] * dz);
+			real_t p2sqr = p1 * p1 - (dx * dx + dy * dy + dz * dz) + set->radius_sqr[s];
+
+			if (p2sqr < 0) {
+				continue;
+			}
+
+			real_t p2 = (real_t)sqrt(p2sqr);
+			real_t t = p1 - p2 > 0 ? p1 - p2 : p1 + p2;
+
+			if (t > 0 && t < packet->t[l]) {
+				packet->t[l] = t;
+				packet->slot[l] = s;
+			}
+		}
+#endif
+	}
+}
+
+//
+// Traversal
+//
+void bvh_intersect_packet_sphere_set(const rte_bvh_t* bvh, const sphere_set_t* set, rte_packet_t* packet) {
+	if (bvh->node_count == 0 || packet->count == 0) {
+		return;
+	}
+
+	int stack_node[BVH_STACK_SIZE];
+	unsigned int stack_mask[BVH_STACK_SIZE];
+	int stack_size = 0;
+
+	stack_node[stack_size] = 0;
+	stack_mask[stack_size] = PACKET_ALL_LANES(packet->count);
+	stack_size++;
+
+	while (stack_size > 0) {
+		stack_size--;
+
+		const rte_bvh_node_t* node = &bvh->nodes[stack_node[stack_size]];
+		unsigned int mask = stack_mask[stack_size];
+
+		real_t t_far = REAL(0.0);
+		int first_lane = -1;
+
+		for (int l = 0; l < packet->count; l++) {
+			if (mask & (1u << l)) {
+				t_far = real_max(t_far, packet->t[l]);
+
+				if (first_lane == -1) {
+					first_lane = l;
+				}
+			}
+		}
+
+		if (packet_frustum_culled(packet, &node->bounds, t_far)) {
+			continue;
+		}
+
+		mask = packet_node_mask(packet, &node->bounds, mask);
+
+		if (mask == 0) {
+			continue;
+		}
+
+		if (node->count > 0) {
+			packet_intersect_leaf(set, node->left_first, node->count, packet, mask);
+			continue;
+		}
+
+		// Order the children along the first live ray, the rest of the packet is assumed to agree
+		int near_index = node->left_first;
+		int far_index = node->left_first + 1;
+
+		rvec3_t near_center, far_center, offset;
+		aabb_centroid(RVEC_OUT(near_center), &bvh->nodes[near_index].bounds);
+		aabb_centroid(RVEC_OUT(far_center), &bvh->nodes[far_index].bounds);
+		rvec3_sub(RVEC_OUT(offset), far_center, near_center);
+
+		real_t along = offset[0] * packet->dir_x[first_lane] + offset[1] * packet->dir_y[first_lane] + offset[2] * packet->dir_z[first_lane];
+
+		if (along < 0) {
+			int swap = near_index;
+			near_index = far_index;
+			far_index = swap;
+		}
+
+		stack_node[stack_size] = far_index;
+		stack_mask[stack_size] = mask;
+		stack_size++;
+
+		stack_node[stack_size] = near_index;
+		stack_mask[stack_size] = mask;
+		stack_size++;
+	}
+}
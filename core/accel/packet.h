@@ -0,0 +1,56 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#ifndef RTEVERYWHERE_PACKET_H
+#define RTEVERYWHERE_PACKET_H
+
+#include "../math/real.h"
+#include "../math/vectors.h"
+#include "../math/ray.h"
+
+#include "../shapes/sphere_set.h"
+
+#include "bvh.h"
+
+// Enough for a 4x4 block of pixels, or a 2x2 block with 4x MSAA
+// Must stay a multiple of RSIMD_WIDTH
+#define PACKET_SIZE 16
+
+//
+// A bundle of coherent rays traced through the BVH together
+// Rays are stored as a structure of arrays so lanes map onto SIMD registers
+//
+typedef struct rte_packet {
+	real_t origin_x[PACKET_SIZE];
+	real_t origin_y[PACKET_SIZE];
+	real_t origin_z[PACKET_SIZE];
+
+	real_t dir_x[PACKET_SIZE];
+	real_t dir_y[PACKET_SIZE];
+	real_t dir_z[PACKET_SIZE];
+
+	real_t inv_x[PACKET_SIZE];
+	real_t inv_y[PACKET_SIZE];
+	real_t inv_z[PACKET_SIZE];
+
+	// Closest hit so far and the sphere set slot it belongs to
+	real_t t[PACKET_SIZE];
+	int slot[PACKET_SIZE];
+
+	int count;
+
+	// Frustum culling data, only valid when every ray shares an origin
+	int shared_origin;
+	int axis_coherent[3];
+	real_t inv_min[3];
+	real_t inv_max[3];
+} rte_packet_t;
+
+// Sets up a packet from up to PACKET_SIZE rays, each lane starts with its own maximum distance
+extern void packet_setup(rte_packet_t* packet, const rte_ray_t* rays, const real_t* t_max, int count);
+
+// Finds the nearest sphere for every lane, lanes that hit something get their t and slot updated
+extern void bvh_intersect_packet_sphere_set(const rte_bvh_t* bvh, const sphere_set_t* set, rte_packet_t* packet);
+
+#endif //RTEVERYWHERE_PACKET_H
@@ -0,0 +1,439 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#include "qbvh.h"
+
+#include "../math/simd.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#define QBVH_CACHE_LINE 64
+
+// Every node visited pushes at most three of its children on top of the ones already waiting
+#define QBVH_STACK_SIZE (BVH_STACK_SIZE * (QBVH_WIDTH - 1) + 1)
+
+// Keeps 2^exponent a normal float
+#define QBVH_EXPONENT_MIN -126
+#define QBVH_EXPONENT_MAX 127
+
+#define QBVH_QUANT_MAX 255
+#define QBVH_COUNT_MAX 65535
+
+// Fails to compile if the node no longer fits a cache line exactly
+typedef char qbvh_node_size_check[sizeof(rte_qbvh_node_t) == QBVH_CACHE_LINE ? 1 : -1];
+
+typedef struct qbvh_builder {
+	const rte_bvh_t* bvh;
+	rte_qbvh_node_t* nodes;
+	int node_count;
+} qbvh_builder_t;
+
+typedef struct qbvh_entry {
+	int child;
+	int count;
+	real_t t_near;
+} qbvh_entry_t;
+
+// Builds 2^exponent straight from the bits
+static inline float qbvh_step(int exponent) {
+	union {
+		float f;
+		uint32_t bits;
+	} step;
+
+	step.bits = (uint32_t)(exponent + 127) << 23;
+	return step.f;
+}
+
+//
+// Building
+//
+
+// The grid has to be conservative both for the float kernel and for real_t (which may be a double)
+static int qbvh_decodes_below(float origin, int q, float step, real_t value) {
+	float f = origin + (float)q * step;
+	real_t r = (real_t)origin + (real_t)q * (real_t)step;
+
+	return (real_t)f <= value && r <= value;
+}
+
+static int qbvh_decodes_above(float origin, int q, float step, real_t value) {
+	float f = origin + (float)q * step;
+	real_t r = (real_t)origin + (real_t)q * (real_t)step;
+
+	return (real_t)f >= value && r >= value;
+}
+
+static void qbvh_encode_axis(rte_qbvh_node_t* node, int axis, const rte_aabb_t* parent, const rte_aabb_t* children, int count) {
+	float origin = (float)parent->min[axis];
+
+	if ((real_t)origin > parent->min[axis]) {
+		origin = nextafterf(origin, -HUGE_VALF);
+	}
+
+	// Smallest power of two step that still reaches the far side of the parent in 255 steps
+	int exponent = QBVH_EXPONENT_MIN;
+	real_t extent = parent->max[axis] - (real_t)origin;
+
+	if (extent > 0) {
+		frexp((double)extent / QBVH_QUANT_MAX, &exponent);
+		exponent = exponent < QBVH_EXPONENT_MIN ? QBVH_EXPONENT_MIN : exponent;
+	}
+
+	while (exponent < QBVH_EXPONENT_MAX && !qbvh_decodes_above(origin, QBVH_QUANT_MAX, qbvh_step(exponent), parent->max[axis])) {
+		exponent++;
+	}
+
+	float step = qbvh_step(exponent);
+
+	node->origin[axis] = origin;
+	node->exponent[axis] = (signed char)exponent;
+
+	for (int c = 0; c < QBVH_WIDTH; c++) {
+		if (c >= count) {
+			// Unused slots are masked off by child_count
+			node->min[axis][c] = QBVH_QUANT_MAX;
+			node->max[axis][c] = 0;
+			continue;
+		}
+
+		real_t lo = real_floor((children[c].min[axis] - (real_t)origin) / (real_t)step);
+		real_t hi = real_ceil((children[c].max[axis] - (real_t)origin) / (real_t)step);
+
+		int q_min = lo < 0 ? 0 : (lo > QBVH_QUANT_MAX ? QBVH_QUANT_MAX : (int)lo);
+		int q_max = hi < 0 ? 0 : (hi > QBVH_QUANT_MAX ? QBVH_QUANT_MAX : (int)hi);
+
+		// Rounding can land a step on the wrong side, walk outwards until the box is covered
+		while (q_min > 0 && !qbvh_decodes_below(origin, q_min, step, children[c].min[axis])) {
+			q_min--;
+		}
+
+		while (q_max < QBVH_QUANT_MAX && !qbvh_decodes_above(origin, q_max, step, children[c].max[axis])) {
+			q_max++;
+		}
+
+		node->min[axis][c] = (unsigned char)q_min;
+		node->max[axis][c] = (unsigned char)q_max;
+	}
+}
+
+// Returns the new node's index, or -1 if a leaf is too big to store
+static int qbvh_collapse(qbvh_builder_t* builder, int bvh_index) {
+	const rte_bvh_node_t* bvh_nodes = builder->bvh->nodes;
+
+	int children[QBVH_WIDTH];
+	int count = 0;
+
+	if (bvh_nodes[bvh_index].count > 0) {
+		// Only happens when the whole tree is a single leaf
+		children[count++] = bvh_index;
+	} else {
+		children[count++] = bvh_nodes[bvh_index].left_first;
+		children[count++] = bvh_nodes[bvh_index].left_first + 1;
+	}
+
+	// Pull grandchildren up in place of the largest interior child until the node is full
+	while (count < QBVH_WIDTH) {
+		int best = -1;
+		real_t best_area = REAL(-1.0);
+
+		for (int c = 0; c < count; c++) {
+			const rte_bvh_node_t* child = &bvh_nodes[children[c]];
+
+			if (child->count == 0 && aabb_surface_area(&child->bounds) > best_area) {
+				best = c;
+				best_area = aabb_surface_area(&child->bounds);
+			}
+		}
+
+		if (best == -1) {
+			break;
+		}
+
+		int opened = children[best];
+
+		children[best] = bvh_nodes[opened].left_first;
+		children[count++] = bvh_nodes[opened].left_first + 1;
+	}
+
+	int index = builder->node_count++;
+	rte_qbvh_node_t* node = &builder->nodes[index];
+
+	rte_aabb_t child_bounds[QBVH_WIDTH];
+	rte_aabb_t parent;
+
+	aabb_empty(&parent);
+
+	for (int c = 0; c < count; c++) {
+		child_bounds[c] = bvh_nodes[children[c]].bounds;
+		aabb_grow(&parent, &child_bounds[c]);
+	}
+
+	for (int a = 0; a < 3; a++) {
+		qbvh_encode_axis(node, a, &parent, child_bounds, count);
+	}
+
+	node->child_count = (unsigned char)count;
+
+	for (int c = 0; c < QBVH_WIDTH; c++) {
+		node->child[c] = -1;
+		node->count[c] = 0;
+	}
+
+	for (int c = 0; c < count; c++) {
+		const rte_bvh_node_t* child = &bvh_nodes[children[c]];
+
+		if (child->count > 0) {
+			if (child->count > QBVH_COUNT_MAX) {
+				return -1;
+			}
+
+			node->child[c] = child->left_first;
+			node->count[c] = (unsigned short)child->count;
+			continue;
+		}
+
+		int child_index = qbvh_collapse(builder, children[c]);
+
+		if (child_index == -1) {
+			return -1;
+		}
+
+		// The array never grows during the build, so the node pointer is still good
+		node->child[c] = child_index;
+	}
+
+	return index;
+}
+
+int qbvh_build(rte_qbvh_t* qbvh, const rte_bvh_t* bvh) {
+	qbvh->nodes = NULL;
+	qbvh->node_count = 0;
+	qbvh->block = NULL;
+
+	if (bvh->node_count == 0) {
+		return 1;
+	}
+
+	// Each node opens at least one binary interior node, of which there are fewer than half the nodes
+	qbvh_builder_t builder;
+
+	builder.bvh = bvh;
+	builder.nodes = (rte_qbvh_node_t*)malloc(sizeof(rte_qbvh_node_t) * (bvh->node_count / 2 + 1));
+	builder.node_count = 0;
+
+	if (builder.nodes == NULL) {
+		return 0;
+	}
+
+	if (qbvh_collapse(&builder, 0) == -1) {
+		free(builder.nodes);
+		return 0;
+	}
+
+	// Copied into an exactly sized block so nothing past the last node is kept around
+	size_t size = sizeof(rte_qbvh_node_t) * builder.node_count;
+
+	qbvh->block = malloc(size + QBVH_CACHE_LINE - 1);
+
+	if (qbvh->block == NULL) {
+		free(builder.nodes);
+		return 0;
+	}
+
+	qbvh->nodes = (rte_qbvh_node_t*)(((uintptr_t)qbvh->block + QBVH_CACHE_LINE - 1) & ~(uintptr_t)(QBVH_CACHE_LINE - 1));
+	qbvh->node_count = builder.node_count;
+
+	memcpy(qbvh->nodes, builder.nodes, size);
+	free(builder.nodes);
+
+	return 1;
+}
+
+void qbvh_free(rte_qbvh_t* qbvh) {
+	free(qbvh->block);
+
+	qbvh->nodes = NULL;
+	qbvh->node_count = 0;
+	qbvh->block = NULL;
+}
+
+//
+// Traversal
+//
+
+// Tests all children of a node at once, returns a bitmask of the ones hit before t_max and writes their entry distances
+static inline unsigned int qbvh_intersect_children(const rte_qbvh_node_t* node, const rte_ray_t* ray, const rvec3_t inv_direction, real_t t_max, real_t* t_near) {
+#if defined(RSIMD4)
+	rsimd4_t near = rsimd4_set1(REAL(0.0));
+	rsimd4_t far = rsimd4_set1(t_max);
+
+	for (int a = 0; a < 3; a++) {
+		rsimd4_t relative = rsimd4_set1(node->origin[a] - ray->origin[a]);
+		rsimd4_t step = rsimd4_set1(qbvh_step(node->exponent[a]));
+		rsimd4_t inv = rsimd4_set1(inv_direction[a]);
+
+		rsimd4_t lo = rsimd4_add(relative, rsimd4_mul(rsimd4_load_u8(node->min[a]), step));
+		rsimd4_t hi = rsimd4_add(relative, rsimd4_mul(rsimd4_load_u8(node->max[a]), step));
+
+		rsimd4_t t0 = rsimd4_mul(lo, inv);
+		rsimd4_t t1 = rsimd4_mul(hi, inv);
+
+		near = rsimd4_max(rsimd4_min(t0, t1), near);
+		far = rsimd4_min(rsimd4_max(t0, t1), far);
+	}
+
+	rsimd4_store(t_near, near);
+
+	return rsimd4_mask_bits(rsimd4_cmp_le(near, far)) & ((1u << node->child_count) - 1);
+#else
+	unsigned int hits = 0;
+
+	for (int c = 0; c < node->child_count; c++) {
+		real_t near = REAL(0.0);
+		real_t far = t_max;
+
+		for (int a = 0; a < 3; a++) {
+			real_t relative = (real_t)node->origin[a] - ray->origin[a];
+			real_t step = (real_t)qbvh_step(node->exponent[a]);
+
+			real_t t0 = (relative + (real_t)node->min[a][c] * step) * inv_direction[a];
+			real_t t1 = (relative + (real_t)node->max[a][c] * step) * inv_direction[a];
+
+			if (t0 > t1) {
+				real_t swap = t0;
+				t0 = t1;
+				t1 = swap;
+			}
+
+			near = t0 > near ? t0 : near;
+			far = t1 < far ? t1 : far;
+		}
+
+		t_near[c] = near;
+
+		if (near <= far) {
+			hits |= 1u << c;
+		}
+	}
+
+	return hits;
+#endif
+}
+
+int qbvh_intersect_sphere_set(const rte_qbvh_t* qbvh, const sphere_set_t* set, const rte_ray_t* ray, real_t* p_t) {
+	if (qbvh->node_count == 0) {
+		return -1;
+	}
+
+	rvec3_t inv_direction;
+	for (int a = 0; a < 3; a++) {
+		inv_direction[a] = REAL(1.0) / ray->direction[a];
+	}
+
+	int hit_slot = -1;
+	real_t closest_t = *p_t;
+
+	qbvh_entry_t stack[QBVH_STACK_SIZE];
+	int stack_size = 0;
+
+	stack[stack_size].child = 0;
+	stack[stack_size].count = 0;
+	stack[stack_size].t_near = REAL(0.0);
+	stack_size++;
+
+	while (stack_size > 0) {
+		qbvh_entry_t entry = stack[--stack_size];
+
+		// Something closer turned up since this was pushed
+		if (entry.t_near >= closest_t) {
+			continue;
+		}
+
+		if (entry.count > 0) {
+			int slot = sphere_set_intersect(set, entry.child, entry.count, ray, &closest_t);
+
+			if (slot != -1) {
+				hit_slot = slot;
+			}
+
+			continue;
+		}
+
+		const rte_qbvh_node_t* node = &qbvh->nodes[entry.child];
+
+		real_t t_near[QBVH_WIDTH];
+		unsigned int hits = qbvh_intersect_children(node, ray, inv_direction, closest_t, t_near);
+
+		// Push far to near so the nearest child is popped first
+		int base = stack_size;
+
+		for (int c = 0; c < QBVH_WIDTH; c++) {
+			if (!(hits & (1u << c))) {
+				continue;
+			}
+
+			qbvh_entry_t child;
+
+			child.child = node->child[c];
+			child.count = node->count[c];
+			child.t_near = t_near[c];
+
+			int i = stack_size++;
+
+			while (i > base && stack[i - 1].t_near < child.t_near) {
+				stack[i] = stack[i - 1];
+				i--;
+			}
+
+			stack[i] = child;
+		}
+	}
+
+	*p_t = closest_t;
+	return hit_slot;
+}
+
+int qbvh_occluded_sphere_set(const rte_qbvh_t* qbvh, const sphere_set_t* set, const rte_ray_t* ray, real_t t_max) {
+	if (qbvh->node_count == 0) {
+		return 0;
+	}
+
+	rvec3_t inv_direction;
+	for (int a = 0; a < 3; a++) {
+		inv_direction[a] = REAL(1.0) / ray->direction[a];
+	}
+
+	int stack[QBVH_STACK_SIZE];
+	int stack_size = 0;
+
+	stack[stack_size++] = 0;
+
+	// Order doesn't matter here, leaves are tested as soon as their parent is
+	while (stack_size > 0) {
+		const rte_qbvh_node_t* node = &qbvh->nodes[stack[--stack_size]];
+
+		real_t t_near[QBVH_WIDTH];
+		unsigned int hits = qbvh_intersect_children(node, ray, inv_direction, t_max, t_near);
+
+		for (int c = 0; c < QBVH_WIDTH; c++) {
+			if (!(hits & (1u << c))) {
+				continue;
+			}
+
+			if (node->count[c] > 0) {
+				if (sphere_set_occluded(set, node->child[c], node->count[c], ray, t_max)) {
+					return 1;
+				}
+			} else {
+				stack[stack_size++] = node->child[c];
+			}
+		}
+	}
+
+	return 0;
+}
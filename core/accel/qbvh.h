@@ -0,0 +1,56 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#ifndef RTEVERYWHERE_QBVH_H
+#define RTEVERYWHERE_QBVH_H
+
+#include "../math/real.h"
+#include "../math/vectors.h"
+#include "../math/ray.h"
+
+#include "../shapes/sphere_set.h"
+
+#include "bvh.h"
+
+#define QBVH_WIDTH 4
+
+//
+// Compressed four wide BVH, each node fills exactly one 64 byte cache line
+// Child boxes are stored as 8 bit offsets from the node's own box on a power of two grid, always rounded outwards
+// so a quantized box never misses anything the exact one would have hit
+//
+// Roughly a third the size of the binary BVH it is collapsed from, traversal decodes and tests all four children at once
+//
+typedef struct rte_qbvh_node {
+	// Child bounds are origin + q * 2^exponent on each axis
+	float origin[3];
+	signed char exponent[3];
+	unsigned char child_count;
+
+	// Indexed [axis][child], so each axis is a single four byte load
+	unsigned char min[3][QBVH_WIDTH];
+	unsigned char max[3][QBVH_WIDTH];
+
+	// Interior children store their node index, leaves the offset of their first primitive into the BVH's index list
+	int child[QBVH_WIDTH];
+	unsigned short count[QBVH_WIDTH]; // 0 for interior children
+} rte_qbvh_node_t;
+
+typedef struct rte_qbvh {
+	rte_qbvh_node_t* nodes; // Cache line aligned
+	int node_count;
+
+	void* block;
+} rte_qbvh_t;
+
+// Collapses a built binary BVH, leaves keep referencing its index list so it must outlive the QBVH
+// Returns 0 on allocation failure, or when a leaf holds more primitives than a node can address
+extern int qbvh_build(rte_qbvh_t* qbvh, const rte_bvh_t* bvh);
+extern void qbvh_free(rte_qbvh_t* qbvh);
+
+// Same contract as the bvh_* sphere set queries, the set must follow the source BVH's order
+extern int qbvh_intersect_sphere_set(const rte_qbvh_t* qbvh, const sphere_set_t* set, const rte_ray_t* ray, real_t* p_t);
+extern int qbvh_occluded_sphere_set(const rte_qbvh_t* qbvh, const sphere_set_t* set, const rte_ray_t* ray, real_t t_max);
+
+#endif //RTEVERYWHERE_QBVH_H
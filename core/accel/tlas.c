@@ -0,0 +1,257 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#include "tlas.h"
+
+#include <stdlib.h>
+
+#define TLAS_BVH_LEAF_SIZE 2
+
+// A refit that grows the root past this multiple of its built surface area rebuilds instead
+#define TLAS_REFIT_MAX_GROWTH REAL(2.0)
+
+void tlas_init(rte_tlas_t* tlas) {
+	tlas->instances = NULL;
+	tlas->instance_count = 0;
+	tlas->instance_capacity = 0;
+
+	tlas->bounds = NULL;
+
+	tlas->bvh.nodes = NULL;
+	tlas->bvh.node_count = 0;
+	tlas->bvh.indices = NULL;
+	tlas->bvh.index_count = 0;
+
+	tlas->dirty = 1;
+	tlas->built_area = REAL(0.0);
+}
+
+void tlas_free(rte_tlas_t* tlas) {
+	free(tlas->instances);
+	free(tlas->bounds);
+
+	bvh_free(&tlas->bvh);
+
+	tlas_init(tlas);
+}
+
+//
+// Instances
+//
+int tlas_add_instance(rte_tlas_t* tlas, const rte_mesh_t* mesh, const rmat4_t transform) {
+	if (tlas->instance_count == tlas->instance_capacity) {
+		int capacity = tlas->instance_capacity * 2 + 16;
+
+		rte_instance_t* instances = (rte_instance_t*)realloc(tlas->instances, sizeof(rte_instance_t) * capacity);
+
+		if (instances == NULL) {
+			return -1;
+		}
+
+		tlas->instances = instances;
+
+		rte_aabb_t* bounds = (rte_aabb_t*)realloc(tlas->bounds, sizeof(rte_aabb_t) * capacity);
+
+		if (bounds == NULL) {
+			return -1;
+		}
+
+		tlas->bounds = bounds;
+		tlas->instance_capacity = capacity;
+	}
+
+	int index = tlas->instance_count++;
+
+	tlas->instances[index].mesh = mesh;
+	tlas_set_transform(tlas, index, transform);
+
+	tlas->dirty = 1;
+	return index;
+}
+
+// The last instance is moved into the freed index
+void tlas_remove_instance(rte_tlas_t* tlas, int index) {
+	tlas->instance_count--;
+
+	if (index != tlas->instance_count) {
+		tlas->instances[index] = tlas->instances[tlas->instance_count];
+	}
+
+	tlas->dirty = 1;
+}
+
+void tlas_set_transform(rte_tlas_t* tlas, int index, const rmat4_t transform) {
+	rte_instance_t* instance = &tlas->instances[index];
+
+	rmat4_copy(instance->transform, transform);
+	rmat4_inverse(instance->inv_transform, transform);
+}
+
+//
+// Updating
+//
+static void tlas_instance_bounds(rte_aabb_t* bounds, const rte_instance_t* instance) {
+	aabb_empty(bounds);
+
+	if (instance->mesh->bvh.node_count == 0) {
+		// Nothing to hit, but keep a valid box at the instance origin so the build stays sane
+		rvec3_t origin = { instance->transform[0][3], instance->transform[1][3], instance->transform[2][3] };
+		aabb_grow_point(bounds, origin);
+		return;
+	}
+
+	const rte_aabb_t* local = &instance->mesh->bvh.nodes[0].bounds;
+
+	// Transforming all eight corners gives a box that still contains the rotated one
+	for (int c = 0; c < 8; c++) {
+		rvec4_t corner = {
+			(c & 1) ? local->max[0] : local->min[0],
+			(c & 2) ? local->max[1] : local->min[1],
+			(c & 4) ? local->max[2] : local->min[2],
+			REAL(1.0)
+		};
+
+		rvec4_t world;
+		rmat4_mul_rvec4(RVEC_OUT(world), instance->transform, corner);
+
+		rvec3_t point = { world[0], world[1], world[2] };
+		aabb_grow_point(bounds, point);
+	}
+}
+
+int tlas_update(rte_tlas_t* tlas) {
+	for (int i = 0; i < tlas->instance_count; i++) {
+		tlas_instance_bounds(&tlas->bounds[i], &tlas->instances[i]);
+	}
+
+	if (!tlas->dirty && tlas->bvh.node_count > 0) {
+		bvh_refit(&tlas->bvh, tlas->bounds);
+
+		if (aabb_surface_area(&tlas->bvh.nodes[0].bounds) <= tlas->built_area * TLAS_REFIT_MAX_GROWTH) {
+			return 1;
+		}
+	}
+
+	bvh_free(&tlas->bvh);
+
+	if (!bvh_build(&tlas->bvh, tlas->bounds, tlas->instance_count, TLAS_BVH_LEAF_SIZE)) {
+		return 0;
+	}
+
+	tlas->dirty = 0;
+	tlas->built_area = tlas->bvh.node_count > 0 ? aabb_surface_area(&tlas->bvh.nodes[0].bounds) : REAL(0.0);
+
+	return 1;
+}
+
+//
+// Tracing
+//
+typedef struct tlas_query {
+	const rte_tlas_t* tlas;
+	const rte_ray_t* ray;
+
+	// Object space result of the closest hit so far
+	mesh_intersect_t* intersect;
+} tlas_query_t;
+
+// The direction isn't renormalized, that way distances along the object space ray match the world space ones
+static void tlas_object_ray(rte_ray_t* dst, const rte_ray_t* ray, const rte_instance_t* instance) {
+	rvec4_t origin = { ray->origin[0], ray->origin[1], ray->origin[2], REAL(1.0) };
+	rvec4_t direction = { ray->direction[0], ray->direction[1], ray->direction[2], REAL(0.0) };
+
+	rvec4_t local_origin, local_direction;
+
+	rmat4_mul_rvec4(RVEC_OUT(local_origin), instance->inv_transform, origin);
+	rmat4_mul_rvec4(RVEC_OUT(local_direction), instance->inv_transform, direction);
+
+	for (int a = 0; a < 3; a++) {
+		dst->origin[a] = local_origin[a];
+		dst->direction[a] = local_direction[a];
+	}
+}
+
+static int tlas_leaf_closest(const void* user, int first, int count, real_t* p_t) {
+	const tlas_query_t* query = (const tlas_query_t*)user;
+
+	int hit = -1;
+
+	for (int i = first; i < first + count; i++) {
+		int index = query->tlas->bvh.indices[i];
+		const rte_instance_t* instance = &query->tlas->instances[index];
+
+		rte_ray_t local;
+		tlas_object_ray(&local, query->ray, instance);
+
+		if (mesh_ray_intersect(instance->mesh, &local, p_t, query->intersect)) {
+			hit = index;
+		}
+	}
+
+	return hit;
+}
+
+static int tlas_leaf_any(const void* user, int first, int count, real_t t_max) {
+	const tlas_query_t* query = (const tlas_query_t*)user;
+
+	for (int i = first; i < first + count; i++) {
+		const rte_instance_t* instance = &query->tlas->instances[query->tlas->bvh.indices[i]];
+
+		rte_ray_t local;
+		tlas_object_ray(&local, query->ray, instance);
+
+		if (mesh_ray_occluded(instance->mesh, &local, t_max)) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+int tlas_ray_intersect(const rte_tlas_t* tlas, const rte_ray_t* ray, real_t* p_t, mesh_intersect_t* intersect) {
+	tlas_query_t query;
+
+	query.tlas = tlas;
+	query.ray = ray;
+	query.intersect = intersect;
+
+	int index = bvh_intersect_leaves(&tlas->bvh, ray, p_t, tlas_leaf_closest, &query);
+
+	if (index == -1) {
+		return -1;
+	}
+
+	// Back to world space, normals go through the inverse transpose so scaling doesn't skew them
+	const rte_instance_t* instance = &tlas->instances[index];
+	rvec3_t normal;
+
+	for (int a = 0; a < 3; a++) {
+		normal[a] = instance->inv_transform[0][a] * intersect->normal[0]
+			+ instance->inv_transform[1][a] * intersect->normal[1]
+			+ instance->inv_transform[2][a] * intersect->normal[2];
+	}
+
+	rvec3_normalize(RVEC_OUT(normal));
+
+	if (rvec3_dot(normal, ray->direction) > 0) {
+		rvec3_mul_scalar(RVEC_OUT(normal), normal, REAL(-1.0));
+	}
+
+	rvec3_copy(RVEC_OUT(intersect->normal), normal);
+
+	rvec3_mul_scalar(RVEC_OUT(intersect->point), ray->direction, intersect->distance);
+	rvec3_add(RVEC_OUT(intersect->point), ray->origin, intersect->point);
+
+	return index;
+}
+
+int tlas_ray_occluded(const rte_tlas_t* tlas, const rte_ray_t* ray, real_t t_max) {
+	tlas_query_t query;
+
+	query.tlas = tlas;
+	query.ray = ray;
+	query.intersect = NULL;
+
+	return bvh_occluded_leaves(&tlas->bvh, ray, t_max, tlas_leaf_any, &query);
+}
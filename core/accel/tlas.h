@@ -0,0 +1,67 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#ifndef RTEVERYWHERE_TLAS_H
+#define RTEVERYWHERE_TLAS_H
+
+#include "../math/real.h"
+#include "../math/vectors.h"
+#include "../math/matrices.h"
+#include "../math/aabb.h"
+#include "../math/ray.h"
+
+#include "../shapes/mesh.h"
+
+#include "bvh.h"
+
+//
+// Two level acceleration structure
+// Every instance places a built mesh (and its BVH) in the world through a transform, the top level BVH is built over the instances
+// Moving an instance only refits the top level, the meshes themselves are left alone
+//
+typedef struct rte_instance {
+	const rte_mesh_t* mesh;
+
+	// Object to world, and its inverse for bringing rays into object space
+	rmat4_t transform;
+	rmat4_t inv_transform;
+} rte_instance_t;
+
+typedef struct rte_tlas {
+	rte_instance_t* instances;
+	int instance_count;
+	int instance_capacity;
+
+	// World space bounds of each instance, indexed like the instances
+	rte_aabb_t* bounds;
+
+	rte_bvh_t bvh;
+
+	// Set when instances were added or removed, the next update rebuilds instead of refitting
+	int dirty;
+
+	// Root surface area right after the last rebuild, refits that grow it too much trigger a rebuild
+	real_t built_area;
+} rte_tlas_t;
+
+extern void tlas_init(rte_tlas_t* tlas);
+extern void tlas_free(rte_tlas_t* tlas);
+
+// Returns the index of the new instance, or -1 on allocation failure
+// The mesh must stay alive and built for as long as the instance exists
+extern int tlas_add_instance(rte_tlas_t* tlas, const rte_mesh_t* mesh, const rmat4_t transform);
+extern void tlas_remove_instance(rte_tlas_t* tlas, int index);
+
+extern void tlas_set_transform(rte_tlas_t* tlas, int index, const rmat4_t transform);
+
+// Brings the top level up to date with the instances, call after changing transforms or refitting meshes
+// Rebuilds when the instance list changed (or the tree degraded too far) and refits otherwise, returns 0 on allocation failure
+extern int tlas_update(rte_tlas_t* tlas);
+
+// Nearest hit closer than *p_t, the intersection is in world space
+// Returns the instance index or -1
+extern int tlas_ray_intersect(const rte_tlas_t* tlas, const rte_ray_t* ray, real_t* p_t, mesh_intersect_t* intersect);
+extern int tlas_ray_occluded(const rte_tlas_t* tlas, const rte_ray_t* ray, real_t t_max);
+
+#endif //RTEVERYWHERE_TLAS_H
@@ -4,36 +4,87 @@
 
 #include "bmp.h"
 
+#include <stddef.h>
 #include <stdio.h>
+#include <string.h>
 
-void write_bmp(const char* path, uint16_t width, uint16_t height, char* rgb) {
+// Rows are padded out to 4 bytes
+static uint32_t bmp_row_padding(uint16_t width) {
+    return (4 - (width * 3) % 4) % 4;
+}
+
+static void bmp_fill_headers(bmp_header_t* header, bmp_info_t* info, uint16_t width, uint16_t height) {
+    uint32_t row_size = width * 3;
+
+    header->ident = 'B' | 'M' << 8;
+    header->offset = sizeof(bmp_header_t) + sizeof(bmp_info_t);
+    header->size = header->offset + (row_size + bmp_row_padding(width)) * height;
+    header->reserved0 = 0;
+    header->reversed1 = 0;
+
+    info->size = sizeof(bmp_info_t);
+    info->width = width;
+    info->height = height;
+    info->planes = 1;
+    info->bits = 24;
+    info->compression = 0;
+    info->image_size = 0;
+    info->x_per_m = 100;
+    info->y_per_m = 100;
+    info->color_usage = 0;
+    info->importance = 0;
+}
+
+int write_bmp(const char* path, uint16_t width, uint16_t height, char* rgb) {
     FILE* file = fopen(path, "wb");
 
     if (file == NULL)
-        return;
+        return 0;
 
     bmp_header_t header;
     bmp_info_t info;
 
-    header.ident = 'B' | 'M' << 8;
-    header.offset = sizeof(header) + sizeof(info);
-    header.size = width * height * 3;
-
-    info.size = sizeof(info);
-    info.width = width;
-    info.height = height;
-    info.bits = 24;
-    info.compression = 0;
-    info.image_size = 0;
-    info.x_per_m = 100;
-    info.y_per_m = 100;
-    info.color_usage = 0;
-    info.importance = 0;
+    bmp_fill_headers(&header, &info, width, height);
 
     fwrite(&header, sizeof(header), 1, file);
     fwrite(&info, sizeof(info), 1, file);
 
-    fwrite(rgb, width * height * 3, 1, file);
+    uint32_t row_size = width * 3;
+    uint32_t row_padding = bmp_row_padding(width);
+
+    const char padding[3] = {0, 0, 0};
+
+    for (uint16_t y = 0; y < height; y++) {
+        fwrite(rgb + (size_t)y * row_size, row_size, 1, file);
+        fwrite(padding, row_padding, 1, file);
+    }
+
+    return fclose(file) == 0;
+}
+
+size_t bmp_encoded_size(uint16_t width, uint16_t height) {
+    return sizeof(bmp_header_t) + sizeof(bmp_info_t) + ((size_t)width * 3 + bmp_row_padding(width)) * height;
+}
+
+void encode_bmp(char* dst, uint16_t width, uint16_t height, const char* rgb) {
+    bmp_header_t header;
+    bmp_info_t info;
+
+    bmp_fill_headers(&header, &info, width, height);
+
+    memcpy(dst, &header, sizeof(header));
+    dst += sizeof(header);
+
+    memcpy(dst, &info, sizeof(info));
+    dst += sizeof(info);
+
+    uint32_t row_size = width * 3;
+    uint32_t row_padding = bmp_row_padding(width);
+
+    for (uint16_t y = 0; y < height; y++) {
+        memcpy(dst, rgb + (size_t)y * row_size, row_size);
+        memset(dst + row_size, 0, row_padding);
 
-    fclose(file);
-}
\ No newline at end of file
+        dst += row_size + row_padding;
+    }
+}
@@ -5,6 +5,7 @@
 #ifndef RTEVERYWHERE_BMP_H
 #define RTEVERYWHERE_BMP_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 #pragma pack(push, 1)
@@ -33,6 +34,13 @@ typedef struct bmp_info_s {
 } bmp_info_t;
 #pragma pack(pop)
 
-extern void write_bmp(const char* path, uint16_t width, uint16_t height, char* rgb);
+// Rgb holds bottom-up rows of BGR triplets, returns 0 if the file couldn't be written
+extern int write_bmp(const char* path, uint16_t width, uint16_t height, char* rgb);
+
+// Size of the whole file encode_bmp produces
+extern size_t bmp_encoded_size(uint16_t width, uint16_t height);
+
+// Same as write_bmp but into memory, dst must hold bmp_encoded_size bytes
+extern void encode_bmp(char* dst, uint16_t width, uint16_t height, const char* rgb);
 
 #endif //RTEVERYWHERE_BMP_H
@@ -0,0 +1,293 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#include "writer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "bmp.h"
+#include "../threading/thread.h"
+
+struct rte_writer {
+	rte_thread_t* thread; // NULL when submits are written on the spot
+
+	// Everything below is guarded by mutex
+	rte_mutex_t* mutex;
+	rte_cond_t* changed; // Broadcast when an image is queued or the writer is told to stop
+
+	rte_image_buffer_t* free;
+	rte_image_buffer_t* queue_head;
+	rte_image_buffer_t* queue_tail;
+
+	int buffer_count;
+	int max_buffers;
+	int pending;
+	int quit;
+
+	int dropped;
+	int failed;
+
+	// Only touched by whoever writes, grown to the largest image
+	unsigned char* scratch;
+	size_t scratch_size;
+};
+
+// BMPs are bottom-up BGR, so rows are flipped and the unused channel is dropped
+static int rte_writer_write(rte_writer_t* writer, const rte_image_buffer_t* buffer) {
+	size_t size = (size_t)buffer->width * buffer->height * 3;
+
+	if (size > writer->scratch_size) {
+		unsigned char* scratch = (unsigned char*)realloc(writer->scratch, size);
+
+		if (scratch == NULL) {
+			return 0;
+		}
+
+		writer->scratch = scratch;
+		writer->scratch_size = size;
+	}
+
+	for (int y = 0; y < buffer->height; y++) {
+		const unsigned char* src = &buffer->pixels[(size_t)y * buffer->width * buffer->channels];
+		unsigned char* dst = &writer->scratch[(size_t)(buffer->height - 1 - y) * buffer->width * 3];
+
+		if (buffer->channels == 3) {
+			memcpy(dst, src, (size_t)buffer->width * 3);
+			continue;
+		}
+
+		for (int x = 0; x < buffer->width; x++) {
+			dst[x * 3 + 0] = src[x * buffer->channels + 0];
+			dst[x * 3 + 1] = src[x * buffer->channels + 1];
+			dst[x * 3 + 2] = src[x * buffer->channels + 2];
+		}
+	}
+
+	return write_bmp(buffer->path, (uint16_t)buffer->width, (uint16_t)buffer->height, (char*)writer->scratch);
+}
+
+// Expects the mutex to be held
+static void rte_writer_recycle(rte_writer_t* writer, rte_image_buffer_t* buffer) {
+	buffer->next = writer->free;
+	writer->free = buffer;
+}
+
+static int rte_writer_thread(void* user) {
+	rte_writer_t* writer = (rte_writer_t*)user;
+
+	rte_mutex_lock(writer->mutex);
+
+	for (;;) {
+		while (writer->queue_head == NULL && !writer->quit) {
+			rte_cond_wait(writer->changed, writer->mutex);
+		}
+
+		// Quitting still drains the queue first
+		rte_image_buffer_t* buffer = writer->queue_head;
+
+		if (buffer == NULL) {
+			break;
+		}
+
+		writer->queue_head = buffer->next;
+
+		if (writer->queue_head == NULL) {
+			writer->queue_tail = NULL;
+		}
+
+		rte_mutex_unlock(writer->mutex);
+		int written = rte_writer_write(writer, buffer);
+		rte_mutex_lock(writer->mutex);
+
+		if (!written) {
+			writer->failed++;
+		}
+
+		writer->pending--;
+		rte_writer_recycle(writer, buffer);
+	}
+
+	rte_mutex_unlock(writer->mutex);
+	return 0;
+}
+
+rte_writer_t* rte_writer_create(int max_buffers) {
+	rte_writer_t* writer = (rte_writer_t*)calloc(1, sizeof(rte_writer_t));
+
+	if (writer == NULL) {
+		return NULL;
+	}
+
+	writer->max_buffers = max_buffers > 0 ? max_buffers : 1;
+	writer->mutex = rte_mutex_create();
+	writer->changed = rte_cond_create();
+
+	if (writer->mutex == NULL || writer->changed == NULL) {
+		rte_writer_destroy(writer);
+		return NULL;
+	}
+
+#if !defined(RTE_NO_THREADS)
+	// A writer that can't get a thread still works, it just writes on the spot
+	writer->thread = rte_thread_create(rte_writer_thread, writer);
+#endif
+
+	return writer;
+}
+
+void rte_writer_destroy(rte_writer_t* writer) {
+	if (writer == NULL) {
+		return;
+	}
+
+	if (writer->thread != NULL) {
+		rte_mutex_lock(writer->mutex);
+
+		writer->quit = 1;
+		rte_cond_broadcast(writer->changed);
+
+		rte_mutex_unlock(writer->mutex);
+
+		rte_thread_join(writer->thread);
+	}
+
+	while (writer->free != NULL) {
+		rte_image_buffer_t* next = writer->free->next;
+
+		free(writer->free->pixels);
+		free(writer->free);
+
+		writer->free = next;
+	}
+
+	free(writer->scratch);
+
+	if (writer->changed != NULL) {
+		rte_cond_destroy(writer->changed);
+	}
+
+	if (writer->mutex != NULL) {
+		rte_mutex_destroy(writer->mutex);
+	}
+
+	free(writer);
+}
+
+rte_image_buffer_t* rte_writer_acquire(rte_writer_t* writer, int width, int height, int channels) {
+	if (width <= 0 || height <= 0 || (channels != 3 && channels != 4)) {
+		return NULL;
+	}
+
+	rte_mutex_lock(writer->mutex);
+
+	rte_image_buffer_t* buffer = writer->free;
+
+	if (buffer != NULL) {
+		writer->free = buffer->next;
+	} else if (writer->buffer_count < writer->max_buffers) {
+		buffer = (rte_image_buffer_t*)calloc(1, sizeof(rte_image_buffer_t));
+		writer->buffer_count += buffer != NULL;
+	}
+
+	if (buffer == NULL) {
+		writer->dropped++;
+	}
+
+	rte_mutex_unlock(writer->mutex);
+
+	if (buffer == NULL) {
+		return NULL;
+	}
+
+	// Buffers keep the largest size they've held, so a steady stream of images allocates nothing
+	size_t size = (size_t)width * height * channels;
+
+	if (size > buffer->capacity) {
+		unsigned char* pixels = (unsigned char*)realloc(buffer->pixels, size);
+
+		if (pixels == NULL) {
+			rte_mutex_lock(writer->mutex);
+
+			writer->dropped++;
+			rte_writer_recycle(writer, buffer);
+
+			rte_mutex_unlock(writer->mutex);
+			return NULL;
+		}
+
+		buffer->pixels = pixels;
+		buffer->capacity = size;
+	}
+
+	buffer->width = width;
+	buffer->height = height;
+	buffer->channels = channels;
+	buffer->next = NULL;
+
+	return buffer;
+}
+
+void rte_writer_submit(rte_writer_t* writer, rte_image_buffer_t* buffer, const char* path) {
+	strncpy(buffer->path, path, RTE_WRITER_MAX_PATH - 1);
+	buffer->path[RTE_WRITER_MAX_PATH - 1] = '\0';
+
+	if (writer->thread == NULL) {
+		int written = rte_writer_write(writer, buffer);
+
+		rte_mutex_lock(writer->mutex);
+
+		writer->failed += !written;
+		rte_writer_recycle(writer, buffer);
+
+		rte_mutex_unlock(writer->mutex);
+		return;
+	}
+
+	rte_mutex_lock(writer->mutex);
+
+	buffer->next = NULL;
+
+	if (writer->queue_tail != NULL) {
+		writer->queue_tail->next = buffer;
+	} else {
+		writer->queue_head = buffer;
+	}
+
+	writer->queue_tail = buffer;
+	writer->pending++;
+
+	rte_cond_broadcast(writer->changed);
+	rte_mutex_unlock(writer->mutex);
+}
+
+void rte_writer_release(rte_writer_t* writer, rte_image_buffer_t* buffer) {
+	rte_mutex_lock(writer->mutex);
+	rte_writer_recycle(writer, buffer);
+	rte_mutex_unlock(writer->mutex);
+}
+
+int rte_writer_pending(rte_writer_t* writer) {
+	rte_mutex_lock(writer->mutex);
+	int pending = writer->pending;
+	rte_mutex_unlock(writer->mutex);
+
+	return pending;
+}
+
+int rte_writer_dropped(rte_writer_t* writer) {
+	rte_mutex_lock(writer->mutex);
+	int dropped = writer->dropped;
+	rte_mutex_unlock(writer->mutex);
+
+	return dropped;
+}
+
+int rte_writer_failed(rte_writer_t* writer) {
+	rte_mutex_lock(writer->mutex);
+	int failed = writer->failed;
+	rte_mutex_unlock(writer->mutex);
+
+	return failed;
+}
@@ -0,0 +1,64 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#ifndef RTEVERYWHERE_WRITER_H
+#define RTEVERYWHERE_WRITER_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Asynchronous image output
+// Images are copied into a recycled buffer and handed to a writer thread, which converts and writes them as BMPs
+// Nothing in here waits on the disk except rte_writer_destroy, which writes out whatever is still queued
+// Without threads every submit is written on the spot
+//
+
+#define RTE_WRITER_MAX_PATH 512
+
+typedef struct rte_writer rte_writer_t;
+
+typedef struct rte_image_buffer {
+	unsigned char* pixels; // Top-down rows, channels bytes per pixel in B, G, R (, unused) order
+	int width;
+	int height;
+	int channels;
+
+	// Owned by the writer
+	size_t capacity;
+	char path[RTE_WRITER_MAX_PATH];
+	struct rte_image_buffer* next;
+} rte_image_buffer_t;
+
+// Keeps at most max_buffers images in memory at once, returns NULL on failure
+extern rte_writer_t* rte_writer_create(int max_buffers);
+
+// Writes out every queued image, then stops the thread and frees the buffers
+extern void rte_writer_destroy(rte_writer_t* writer);
+
+// Returns a buffer with room for the image, channels is 3 or 4
+// Returns NULL instead of waiting when every buffer is still queued or memory ran out, the caller drops the image
+extern rte_image_buffer_t* rte_writer_acquire(rte_writer_t* writer, int width, int height, int channels);
+
+// Queues the filled buffer to be written to path, the buffer goes back to the writer either way
+extern void rte_writer_submit(rte_writer_t* writer, rte_image_buffer_t* buffer, const char* path);
+
+// Returns an acquired buffer unwritten
+extern void rte_writer_release(rte_writer_t* writer, rte_image_buffer_t* buffer);
+
+// Images queued but not written yet
+extern int rte_writer_pending(rte_writer_t* writer);
+
+// Images that couldn't be acquired or written so far
+extern int rte_writer_dropped(rte_writer_t* writer);
+extern int rte_writer_failed(rte_writer_t* writer);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif //RTEVERYWHERE_WRITER_H
@@ -0,0 +1,72 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#include "aabb.h"
+
+#include <float.h>
+
+#ifndef REAL_IS_DOUBLE
+#define AABB_HUGE FLT_MAX
+#else
+#define AABB_HUGE DBL_MAX
+#endif
+
+void aabb_empty(rte_aabb_t* aabb) {
+	rvec3_copy_scalar(RVEC_OUT(aabb->min), AABB_HUGE);
+	rvec3_copy_scalar(RVEC_OUT(aabb->max), -AABB_HUGE);
+}
+
+void aabb_grow(rte_aabb_t* aabb, const rte_aabb_t* other) {
+	for (int a = 0; a < 3; a++) {
+		aabb->min[a] = real_min(aabb->min[a], other->min[a]);
+		aabb->max[a] = real_max(aabb->max[a], other->max[a]);
+	}
+}
+
+void aabb_grow_point(rte_aabb_t* aabb, const rvec3_t point) {
+	for (int a = 0; a < 3; a++) {
+		aabb->min[a] = real_min(aabb->min[a], point[a]);
+		aabb->max[a] = real_max(aabb->max[a], point[a]);
+	}
+}
+
+void aabb_centroid(rvec3_out_t dst, const rte_aabb_t* aabb) {
+	rvec3_add(dst, aabb->min, aabb->max);
+	rvec3_mul_scalar(dst, RVEC_OUT_DEREF(dst), REAL(0.5));
+}
+
+real_t aabb_surface_area(const rte_aabb_t* aabb) {
+	real_t x = aabb->max[0] - aabb->min[0];
+	real_t y = aabb->max[1] - aabb->min[1];
+	real_t z = aabb->max[2] - aabb->min[2];
+
+	// Empty boxes are inverted, they shouldn't contribute any cost
+	if (x < 0 || y < 0 || z < 0) {
+		return REAL(0.0);
+	}
+
+	return REAL(2.0) * (x * y + y * z + z * x);
+}
+
+int aabb_ray_intersect(const rte_aabb_t* aabb, const rvec3_t origin, const rvec3_t inv_direction, real_t t_max, real_t* p_near) {
+	real_t t_near = REAL(0.0);
+	real_t t_far = t_max;
+
+	for (int a = 0; a < 3; a++) {
+		real_t t0 = (aabb->min[a] - origin[a]) * inv_direction[a];
+		real_t t1 = (aabb->max[a] - origin[a]) * inv_direction[a];
+
+		if (t0 > t1) {
+			real_t swap = t0;
+			t0 = t1;
+			t1 = swap;
+		}
+
+		t_near = t0 > t_near ? t0 : t_near;
+		t_far = t1 < t_far ? t1 : t_far;
+	}
+
+	*p_near = t_near;
+	return t_near <= t_far;
+}
@@ -0,0 +1,29 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#ifndef RTEVERYWHERE_AABB_H
+#define RTEVERYWHERE_AABB_H
+
+#include "real.h"
+#include "vectors.h"
+
+typedef struct rte_aabb {
+	rvec3_t min;
+	rvec3_t max;
+} rte_aabb_t;
+
+extern void aabb_empty(rte_aabb_t* aabb);
+
+extern void aabb_grow(rte_aabb_t* aabb, const rte_aabb_t* other);
+extern void aabb_grow_point(rte_aabb_t* aabb, const rvec3_t point);
+
+extern void aabb_centroid(rvec3_out_t dst, const rte_aabb_t* aabb);
+
+extern real_t aabb_surface_area(const rte_aabb_t* aabb);
+
+// Slab test, inv_direction is 1 / ray direction
+// Returns the entry distance through p_near when the box is hit within [0, t_max)
+extern int aabb_ray_intersect(const rte_aabb_t* aabb, const rvec3_t origin, const rvec3_t inv_direction, real_t t_max, real_t* p_near);
+
+#endif //RTEVERYWHERE_AABB_H
@@ -4,20 +4,32 @@
 
 #include "crand.h"
 
-unsigned long state = 0xDEADBEEF;
+static crand_state_t shared_state = { CRAND_DEFAULT_SEED };
 
-void crand_seed(unsigned long seed) {
-    state = seed;
+void crand_state_seed(crand_state_t* rand, unsigned long seed) {
+    rand->state = seed;
 }
 
-long crand_next() {
-    state = (state * 1103515245 + 12345) % CRAND_MAX;
-    return state;
+long crand_state_next(crand_state_t* rand) {
+    rand->state = (rand->state * 1103515245 + 12345) % CRAND_MAX;
+    return rand->state;
 }
 
-real_t crand_range(real_t min, real_t max) {
-    long val = crand_next();
+real_t crand_state_range(crand_state_t* rand, real_t min, real_t max) {
+    long val = crand_state_next(rand);
 
     real_t r = (real_t)val / (real_t)CRAND_MAX;
     return real_remap(r, min, max);
-}
\ No newline at end of file
+}
+
+void crand_seed(unsigned long seed) {
+    crand_state_seed(&shared_state, seed);
+}
+
+long crand_next() {
+    return crand_state_next(&shared_state);
+}
+
+real_t crand_range(real_t min, real_t max) {
+    return crand_state_range(&shared_state, min, max);
+}
@@ -9,11 +9,26 @@
 
 #define CRAND_MAX 2147483647
 
+// State the generator starts from before any crand_seed call
+#define CRAND_DEFAULT_SEED 0xDEADBEEF
+
 //
 // CRAND = Custom rand
 //
 
 // https://stackoverflow.com/questions/47191747/generating-random-numbers-without-using-cstdlib
+// The crand_state_* functions work on caller owned state, so separate generators never interfere across threads
+typedef struct crand_state {
+    unsigned long state;
+} crand_state_t;
+
+extern void crand_state_seed(crand_state_t* rand, unsigned long seed);
+
+extern long crand_state_next(crand_state_t* rand);
+
+extern real_t crand_state_range(crand_state_t* rand, real_t min, real_t max);
+
+// Shared process wide generator, not thread safe
 extern void crand_seed(unsigned long seed);
 
 extern long crand_next();
@@ -86,7 +86,7 @@ void rmat4_inverse(rmat4_t dst, const rmat4_t src) {
 	rvec4_mul(RVEC_OUT(p01), vec2, fac1);
 	rvec4_mul(RVEC_OUT(p02), vec3, fac2);
 
-	rvec4_add(RVEC_OUT(p03), p01, p02);
+	rvec4_sub(RVEC_OUT(p03), p01, p02);
 	rvec4_sub(RVEC_OUT(inv0), p00, p03);
 
 	//rvec4_t inv1 = (vec0 * fac0 - vec2 * fac3 + vec3 * fac4);
@@ -96,7 +96,7 @@ void rmat4_inverse(rmat4_t dst, const rmat4_t src) {
 	rvec4_mul(RVEC_OUT(p01), vec2, fac3);
 	rvec4_mul(RVEC_OUT(p02), vec3, fac4);
 
-	rvec4_add(RVEC_OUT(p03), p01, p02);
+	rvec4_sub(RVEC_OUT(p03), p01, p02);
 	rvec4_sub(RVEC_OUT(inv1), p00, p03);
 
 	//rvec4_t inv2 = (vec0 * fac1 - vec1 * fac3 + vec3 * fac5);
@@ -106,7 +106,7 @@ void rmat4_inverse(rmat4_t dst, const rmat4_t src) {
 	rvec4_mul(RVEC_OUT(p01), vec1, fac3);
 	rvec4_mul(RVEC_OUT(p02), vec3, fac5);
 
-	rvec4_add(RVEC_OUT(p03), p01, p02);
+	rvec4_sub(RVEC_OUT(p03), p01, p02);
 	rvec4_sub(RVEC_OUT(inv2), p00, p03);
 
 	//rvec4_t inv3 = (vec0 * fac2 - vec1 * fac4 + vec2 * fac5);
@@ -116,7 +116,7 @@ void rmat4_inverse(rmat4_t dst, const rmat4_t src) {
 	rvec4_mul(RVEC_OUT(p01), vec1, fac4);
 	rvec4_mul(RVEC_OUT(p02), vec2, fac5);
 
-	rvec4_add(RVEC_OUT(p03), p01, p02);
+	rvec4_sub(RVEC_OUT(p03), p01, p02);
 	rvec4_sub(RVEC_OUT(inv3), p00, p03);
 
 	rvec4_t sign_a = {REAL(1.0), -REAL(1.0), REAL(1.0), -REAL(1.0)};
@@ -138,7 +138,7 @@ void rmat4_inverse(rmat4_t dst, const rmat4_t src) {
 	rmat4_copy_rows(inv, row0, row1, row2, row3);
 
 	rvec4_t r0 = {inv[0][0], inv[1][0], inv[2][0], inv[3][0]};
-	rvec4_t src_r0 = {src[0][0], src[1][0], src[2][0], src[3][0]};
+	rvec4_t src_r0 = {src[0][0], src[0][1], src[0][2], src[0][3]};
 
 	rvec4_t dot0;
 	rvec4_mul(RVEC_OUT(dot0), src_r0, r0);
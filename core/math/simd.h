@@ -0,0 +1,241 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#ifndef RTEVERYWHERE_SIMD_H
+#define RTEVERYWHERE_SIMD_H
+
+#include "real.h"
+
+//
+// Thin wrappers over the widest float SIMD the compiler is targeting
+// RSIMD_WIDTH is left undefined when no SIMD path is available, callers must provide a scalar fallback
+//
+// The ISA is picked at compile time, build with -mavx2 / -mavx512f (or RT_EVERYWHERE_NATIVE) to get the wider kernels
+//
+
+#if !defined(RTE_NO_SIMD) && !defined(REAL_IS_DOUBLE)
+
+#if defined(__AVX512F__)
+
+#include <immintrin.h>
+
+#define RSIMD_WIDTH 16
+#define RSIMD_ISA "AVX-512"
+
+typedef __m512 rsimd_t;
+typedef __mmask16 rsimd_mask_t;
+
+static inline rsimd_t rsimd_set1(real_t r) { return _mm512_set1_ps(r); }
+static inline rsimd_t rsimd_load(const real_t* src) { return _mm512_loadu_ps(src); }
+static inline void rsimd_store(real_t* dst, rsimd_t a) { _mm512_storeu_ps(dst, a); }
+
+static inline rsimd_t rsimd_add(rsimd_t a, rsimd_t b) { return _mm512_add_ps(a, b); }
+static inline rsimd_t rsimd_sub(rsimd_t a, rsimd_t b) { return _mm512_sub_ps(a, b); }
+static inline rsimd_t rsimd_mul(rsimd_t a, rsimd_t b) { return _mm512_mul_ps(a, b); }
+static inline rsimd_t rsimd_div(rsimd_t a, rsimd_t b) { return _mm512_div_ps(a, b); }
+static inline rsimd_t rsimd_min(rsimd_t a, rsimd_t b) { return _mm512_min_ps(a, b); }
+static inline rsimd_t rsimd_max(rsimd_t a, rsimd_t b) { return _mm512_max_ps(a, b); }
+static inline rsimd_t rsimd_sqrt(rsimd_t a) { return _mm512_sqrt_ps(a); }
+
+static inline rsimd_mask_t rsimd_cmp_lt(rsimd_t a, rsimd_t b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+static inline rsimd_mask_t rsimd_cmp_le(rsimd_t a, rsimd_t b) { return _mm512_cmp_ps_mask(a, b, _CMP_LE_OQ); }
+static inline rsimd_mask_t rsimd_cmp_gt(rsimd_t a, rsimd_t b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+
+static inline rsimd_mask_t rsimd_mask_and(rsimd_mask_t a, rsimd_mask_t b) { return a & b; }
+static inline rsimd_mask_t rsimd_mask_or(rsimd_mask_t a, rsimd_mask_t b) { return a | b; }
+static inline rsimd_mask_t rsimd_mask_from_bits(unsigned int bits) { return (rsimd_mask_t)bits; }
+static inline unsigned int rsimd_mask_bits(rsimd_mask_t m) { return (unsigned int)m; }
+
+// Picks b where the mask is set, a elsewhere
+static inline rsimd_t rsimd_select(rsimd_mask_t m, rsimd_t a, rsimd_t b) { return _mm512_mask_blend_ps(m, a, b); }
+
+#elif defined(__AVX2__)
+
+#include <immintrin.h>
+
+#define RSIMD_WIDTH 8
+#define RSIMD_ISA "AVX2"
+
+typedef __m256 rsimd_t;
+typedef __m256 rsimd_mask_t;
+
+static inline rsimd_t rsimd_set1(real_t r) { return _mm256_set1_ps(r); }
+static inline rsimd_t rsimd_load(const real_t* src) { return _mm256_loadu_ps(src); }
+static inline void rsimd_store(real_t* dst, rsimd_t a) { _mm256_storeu_ps(dst, a); }
+
+static inline rsimd_t rsimd_add(rsimd_t a, rsimd_t b) { return _mm256_add_ps(a, b); }
+static inline rsimd_t rsimd_sub(rsimd_t a, rsimd_t b) { return _mm256_sub_ps(a, b); }
+static inline rsimd_t rsimd_mul(rsimd_t a, rsimd_t b) { return _mm256_mul_ps(a, b); }
+static inline rsimd_t rsimd_div(rsimd_t a, rsimd_t b) { return _mm256_div_ps(a, b); }
+static inline rsimd_t rsimd_min(rsimd_t a, rsimd_t b) { return _mm256_min_ps(a, b); }
+static inline rsimd_t rsimd_max(rsimd_t a, rsimd_t b) { return _mm256_max_ps(a, b); }
+static inline rsimd_t rsimd_sqrt(rsimd_t a) { return _mm256_sqrt_ps(a); }
+
+static inline rsimd_mask_t rsimd_cmp_lt(rsimd_t a, rsimd_t b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+static inline rsimd_mask_t rsimd_cmp_le(rsimd_t a, rsimd_t b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+static inline rsimd_mask_t rsimd_cmp_gt(rsimd_t a, rsimd_t b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+
+static inline rsimd_mask_t rsimd_mask_and(rsimd_mask_t a, rsimd_mask_t b) { return _mm256_and_ps(a, b); }
+static inline rsimd_mask_t rsimd_mask_or(rsimd_mask_t a, rsimd_mask_t b) { return _mm256_or_ps(a, b); }
+static inline unsigned int rsimd_mask_bits(rsimd_mask_t m) { return (unsigned int)_mm256_movemask_ps(m); }
+
+static inline rsimd_mask_t rsimd_mask_from_bits(unsigned int bits) {
+	const __m256i lanes = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+	__m256i set = _mm256_and_si256(_mm256_set1_epi32((int)bits), lanes);
+
+	return _mm256_castsi256_ps(_mm256_cmpeq_epi32(set, lanes));
+}
+
+static inline rsimd_t rsimd_select(rsimd_mask_t m, rsimd_t a, rsimd_t b) { return _mm256_blendv_ps(a, b, m); }
+
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+
+#include <emmintrin.h>
+
+#define RSIMD_WIDTH 4
+#define RSIMD_ISA "SSE2"
+
+typedef __m128 rsimd_t;
+typedef __m128 rsimd_mask_t;
+
+static inline rsimd_t rsimd_set1(real_t r) { return _mm_set1_ps(r); }
+static inline rsimd_t rsimd_load(const real_t* src) { return _mm_loadu_ps(src); }
+static inline void rsimd_store(real_t* dst, rsimd_t a) { _mm_storeu_ps(dst, a); }
+
+static inline rsimd_t rsimd_add(rsimd_t a, rsimd_t b) { return _mm_add_ps(a, b); }
+static inline rsimd_t rsimd_sub(rsimd_t a, rsimd_t b) { return _mm_sub_ps(a, b); }
+static inline rsimd_t rsimd_mul(rsimd_t a, rsimd_t b) { return _mm_mul_ps(a, b); }
+static inline rsimd_t rsimd_div(rsimd_t a, rsimd_t b) { return _mm_div_ps(a, b); }
+static inline rsimd_t rsimd_min(rsimd_t a, rsimd_t b) { return _mm_min_ps(a, b); }
+static inline rsimd_t rsimd_max(rsimd_t a, rsimd_t b) { return _mm_max_ps(a, b); }
+static inline rsimd_t rsimd_sqrt(rsimd_t a) { return _mm_sqrt_ps(a); }
+
+static inline rsimd_mask_t rsimd_cmp_lt(rsimd_t a, rsimd_t b) { return _mm_cmplt_ps(a, b); }
+static inline rsimd_mask_t rsimd_cmp_le(rsimd_t a, rsimd_t b) { return _mm_cmple_ps(a, b); }
+static inline rsimd_mask_t rsimd_cmp_gt(rsimd_t a, rsimd_t b) { return _mm_cmpgt_ps(a, b); }
+
+static inline rsimd_mask_t rsimd_mask_and(rsimd_mask_t a, rsimd_mask_t b) { return _mm_and_ps(a, b); }
+static inline rsimd_mask_t rsimd_mask_or(rsimd_mask_t a, rsimd_mask_t b) { return _mm_or_ps(a, b); }
+static inline unsigned int rsimd_mask_bits(rsimd_mask_t m) { return (unsigned int)_mm_movemask_ps(m); }
+
+static inline rsimd_mask_t rsimd_mask_from_bits(unsigned int bits) {
+	const __m128i lanes = _mm_setr_epi32(1, 2, 4, 8);
+	__m128i set = _mm_and_si128(_mm_set1_epi32((int)bits), lanes);
+
+	return _mm_castsi128_ps(_mm_cmpeq_epi32(set, lanes));
+}
+
+static inline rsimd_t rsimd_select(rsimd_mask_t m, rsimd_t a, rsimd_t b) { return _mm_or_ps(_mm_and_ps(m, b), _mm_andnot_ps(m, a)); }
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+
+#include <arm_neon.h>
+
+#define RSIMD_WIDTH 4
+#define RSIMD_ISA "NEON"
+
+typedef float32x4_t rsimd_t;
+typedef uint32x4_t rsimd_mask_t;
+
+static inline rsimd_t rsimd_set1(real_t r) { return vdupq_n_f32(r); }
+static inline rsimd_t rsimd_load(const real_t* src) { return vld1q_f32(src); }
+static inline void rsimd_store(real_t* dst, rsimd_t a) { vst1q_f32(dst, a); }
+
+static inline rsimd_t rsimd_add(rsimd_t a, rsimd_t b) { return vaddq_f32(a, b); }
+static inline rsimd_t rsimd_sub(rsimd_t a, rsimd_t b) { return vsubq_f32(a, b); }
+static inline rsimd_t rsimd_mul(rsimd_t a, rsimd_t b) { return vmulq_f32(a, b); }
+static inline rsimd_t rsimd_div(rsimd_t a, rsimd_t b) { return vdivq_f32(a, b); }
+static inline rsimd_t rsimd_min(rsimd_t a, rsimd_t b) { return vminq_f32(a, b); }
+static inline rsimd_t rsimd_max(rsimd_t a, rsimd_t b) { return vmaxq_f32(a, b); }
+static inline rsimd_t rsimd_sqrt(rsimd_t a) { return vsqrtq_f32(a); }
+
+static inline rsimd_mask_t rsimd_cmp_lt(rsimd_t a, rsimd_t b) { return vcltq_f32(a, b); }
+static inline rsimd_mask_t rsimd_cmp_le(rsimd_t a, rsimd_t b) { return vcleq_f32(a, b); }
+static inline rsimd_mask_t rsimd_cmp_gt(rsimd_t a, rsimd_t b) { return vcgtq_f32(a, b); }
+
+static inline rsimd_mask_t rsimd_mask_and(rsimd_mask_t a, rsimd_mask_t b) { return vandq_u32(a, b); }
+static inline rsimd_mask_t rsimd_mask_or(rsimd_mask_t a, rsimd_mask_t b) { return vorrq_u32(a, b); }
+
+static inline unsigned int rsimd_mask_bits(rsimd_mask_t m) {
+	const uint32x4_t lanes = {1, 2, 4, 8};
+	return vaddvq_u32(vandq_u32(m, lanes));
+}
+
+static inline rsimd_mask_t rsimd_mask_from_bits(unsigned int bits) {
+	const uint32x4_t lanes = {1, 2, 4, 8};
+	return vtstq_u32(vdupq_n_u32(bits), lanes);
+}
+
+static inline rsimd_t rsimd_select(rsimd_mask_t m, rsimd_t a, rsimd_t b) { return vbslq_f32(m, b, a); }
+
+#endif
+
+//
+// Fixed four lane ops, for data that is four wide whatever the widest ISA is (the quantized BVH nodes)
+// RSIMD4 is defined when they are available
+//
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+
+#include <emmintrin.h>
+#include <stdint.h>
+
+#define RSIMD4
+
+typedef __m128 rsimd4_t;
+typedef __m128 rsimd4_mask_t;
+
+static inline rsimd4_t rsimd4_set1(real_t r) { return _mm_set1_ps(r); }
+static inline void rsimd4_store(real_t* dst, rsimd4_t a) { _mm_storeu_ps(dst, a); }
+
+// Widens four bytes to floats
+static inline rsimd4_t rsimd4_load_u8(const unsigned char* src) {
+	uint32_t bits = src[0] | (src[1] << 8) | (src[2] << 16) | ((uint32_t)src[3] << 24);
+	__m128i zero = _mm_setzero_si128();
+	__m128i words = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int)bits), zero);
+
+	return _mm_cvtepi32_ps(_mm_unpacklo_epi16(words, zero));
+}
+
+static inline rsimd4_t rsimd4_add(rsimd4_t a, rsimd4_t b) { return _mm_add_ps(a, b); }
+static inline rsimd4_t rsimd4_mul(rsimd4_t a, rsimd4_t b) { return _mm_mul_ps(a, b); }
+static inline rsimd4_t rsimd4_min(rsimd4_t a, rsimd4_t b) { return _mm_min_ps(a, b); }
+static inline rsimd4_t rsimd4_max(rsimd4_t a, rsimd4_t b) { return _mm_max_ps(a, b); }
+
+static inline rsimd4_mask_t rsimd4_cmp_le(rsimd4_t a, rsimd4_t b) { return _mm_cmple_ps(a, b); }
+static inline unsigned int rsimd4_mask_bits(rsimd4_mask_t m) { return (unsigned int)_mm_movemask_ps(m); }
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+
+#define RSIMD4
+
+typedef float32x4_t rsimd4_t;
+typedef uint32x4_t rsimd4_mask_t;
+
+static inline rsimd4_t rsimd4_set1(real_t r) { return vdupq_n_f32(r); }
+static inline void rsimd4_store(real_t* dst, rsimd4_t a) { vst1q_f32(dst, a); }
+
+static inline rsimd4_t rsimd4_load_u8(const unsigned char* src) {
+	uint32_t bits = src[0] | (src[1] << 8) | (src[2] << 16) | ((uint32_t)src[3] << 24);
+	uint16x8_t words = vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(bits)));
+
+	return vcvtq_f32_u32(vmovl_u16(vget_low_u16(words)));
+}
+
+static inline rsimd4_t rsimd4_add(rsimd4_t a, rsimd4_t b) { return vaddq_f32(a, b); }
+static inline rsimd4_t rsimd4_mul(rsimd4_t a, rsimd4_t b) { return vmulq_f32(a, b); }
+static inline rsimd4_t rsimd4_min(rsimd4_t a, rsimd4_t b) { return vminq_f32(a, b); }
+static inline rsimd4_t rsimd4_max(rsimd4_t a, rsimd4_t b) { return vmaxq_f32(a, b); }
+
+static inline rsimd4_mask_t rsimd4_cmp_le(rsimd4_t a, rsimd4_t b) { return vcleq_f32(a, b); }
+
+static inline unsigned int rsimd4_mask_bits(rsimd4_mask_t m) {
+	const uint32x4_t lanes = {1, 2, 4, 8};
+	return vaddvq_u32(vandq_u32(m, lanes));
+}
+
+#endif
+
+#endif
+
+#endif //RTEVERYWHERE_SIMD_H
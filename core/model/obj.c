@@ -0,0 +1,163 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#include "obj.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define OBJ_LINE_MAX 1024
+
+// Faces with more corners than this are cut short
+#define OBJ_FACE_MAX 64
+
+static const char* obj_skip_space(const char* c) {
+	while (*c == ' ' || *c == '\t') {
+		c++;
+	}
+
+	return c;
+}
+
+static int obj_read_vec3(const char* c, rvec3_out_t dst) {
+	for (int a = 0; a < 3; a++) {
+		char* end;
+		double value = strtod(c, &end);
+
+		if (end == c) {
+			return 0;
+		}
+
+		RVEC_OUT_DEREF(dst)[a] = (real_t)value;
+		c = end;
+	}
+
+	return 1;
+}
+
+// Resolves a 1 based (or negative, relative) OBJ index, returns -1 if it is out of range
+static int obj_resolve_index(long index, int count) {
+	if (index > 0 && index <= count) {
+		return (int)index - 1;
+	}
+
+	if (index < 0 && -index <= count) {
+		return count + (int)index;
+	}
+
+	return -1;
+}
+
+// Parses one "p", "p/t", "p//n" or "p/t/n" corner, returns the position past it or NULL at the end of the line
+static const char* obj_read_corner(const char* c, const rte_mesh_t* mesh, int* p_position, int* p_normal) {
+	c = obj_skip_space(c);
+
+	char* end;
+	long position = strtol(c, &end, 10);
+
+	if (end == c) {
+		return NULL;
+	}
+
+	c = end;
+
+	long normal = 0;
+
+	if (*c == '/') {
+		c++;
+
+		// Texture coordinate, unused
+		strtol(c, &end, 10);
+		c = end;
+
+		if (*c == '/') {
+			c++;
+
+			normal = strtol(c, &end, 10);
+			c = end;
+		}
+	}
+
+	*p_position = obj_resolve_index(position, mesh->position_count);
+	*p_normal = normal != 0 ? obj_resolve_index(normal, mesh->normal_count) : -1;
+
+	return c;
+}
+
+static int obj_read_face(const char* c, rte_mesh_t* mesh) {
+	int positions[OBJ_FACE_MAX];
+	int normals[OBJ_FACE_MAX];
+	int corners = 0;
+
+	while (corners < OBJ_FACE_MAX) {
+		c = obj_read_corner(c, mesh, &positions[corners], &normals[corners]);
+
+		if (c == NULL) {
+			break;
+		}
+
+		// Faces that point at missing vertices are dropped rather than failing the whole file
+		if (positions[corners] == -1) {
+			return 1;
+		}
+
+		corners++;
+	}
+
+	for (int i = 2; i < corners; i++) {
+		int triangle_positions[3] = {positions[0], positions[i - 1], positions[i]};
+		int triangle_normals[3] = {normals[0], normals[i - 1], normals[i]};
+
+		if (mesh_add_triangle(mesh, triangle_positions, triangle_normals) == -1) {
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+int obj_load(rte_mesh_t* mesh, const char* path) {
+	FILE* file = fopen(path, "r");
+
+	if (file == NULL) {
+		return 0;
+	}
+
+	char line[OBJ_LINE_MAX];
+	int success = 1;
+
+	while (success && fgets(line, sizeof(line), file) != NULL) {
+		int length = 0;
+		while (line[length] != '\0') {
+			length++;
+		}
+
+		// Overlong lines are parsed as far as they fit, the rest is thrown away
+		if (length > 0 && line[length - 1] != '\n' && !feof(file)) {
+			int next;
+
+			do {
+				next = fgetc(file);
+			} while (next != '\n' && next != EOF);
+		}
+
+		const char* c = obj_skip_space(line);
+		rvec3_t value;
+
+		if (c[0] == 'v' && (c[1] == ' ' || c[1] == '\t')) {
+			if (obj_read_vec3(c + 2, RVEC_OUT(value))) {
+				success = mesh_add_position(mesh, value) != -1;
+			}
+		} else if (c[0] == 'v' && c[1] == 'n' && (c[2] == ' ' || c[2] == '\t')) {
+			if (obj_read_vec3(c + 3, RVEC_OUT(value))) {
+				success = mesh_add_normal(mesh, value) != -1;
+			}
+		} else if (c[0] == 'f' && (c[1] == ' ' || c[1] == '\t')) {
+			success = obj_read_face(c + 2, mesh);
+		}
+	}
+
+	fclose(file);
+	return success;
+}
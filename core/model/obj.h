@@ -0,0 +1,28 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#ifndef RTEVERYWHERE_OBJ_H
+#define RTEVERYWHERE_OBJ_H
+
+#include "../shapes/mesh.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Wavefront OBJ loader
+// The file is streamed line by line straight into the mesh, only positions, normals and faces are read
+// Polygons are fan triangulated, materials, groups and texture coordinates are ignored
+//
+
+// Appends the file to the mesh (mesh_init it first), does not call mesh_build
+// Returns 0 if the file couldn't be read or memory ran out
+extern int obj_load(rte_mesh_t* mesh, const char* path);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif //RTEVERYWHERE_OBJ_H
@@ -0,0 +1,424 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#include "socket.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(RTE_NO_SOCKETS)
+#elif defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+typedef SOCKET rte_socket_handle_t;
+#define RTE_SOCKET_INVALID INVALID_SOCKET
+#define rte_socket_close_handle closesocket
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <errno.h>
+
+typedef int rte_socket_handle_t;
+#define RTE_SOCKET_INVALID (-1)
+#define rte_socket_close_handle close
+#endif
+
+// Longest "host:port" or "unix:/path" accepted
+#define RTE_SOCKET_MAX_ADDRESS 256
+
+#if !defined(RTE_NO_SOCKETS)
+
+struct rte_socket {
+	rte_socket_handle_t handle;
+
+	// Set on unix listeners, the socket file is removed again when they close
+	char* unlink_path;
+};
+
+#if defined(_WIN32)
+static volatile LONG winsock_started = 0;
+
+static int rte_socket_startup() {
+	// Started once for the whole process and never cleaned up, like the threads of the shared pool
+	if (InterlockedCompareExchange(&winsock_started, 1, 0) == 0) {
+		WSADATA data;
+
+		if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+			winsock_started = 0;
+			return 0;
+		}
+	}
+
+	return 1;
+}
+#else
+static int rte_socket_startup() {
+	return 1;
+}
+#endif
+
+static rte_socket_t* rte_socket_wrap(rte_socket_handle_t handle) {
+	rte_socket_t* sock = (rte_socket_t*)malloc(sizeof(rte_socket_t));
+
+	if (sock == NULL) {
+		rte_socket_close_handle(handle);
+		return NULL;
+	}
+
+	sock->handle = handle;
+	sock->unlink_path = NULL;
+
+#if defined(SO_NOSIGPIPE)
+	// No MSG_NOSIGNAL on Apple platforms, the socket itself opts out of SIGPIPE instead
+	int no_sigpipe = 1;
+	setsockopt(handle, SOL_SOCKET, SO_NOSIGPIPE, &no_sigpipe, sizeof(no_sigpipe));
+#endif
+
+	return sock;
+}
+
+static int rte_socket_is_unix(const char* address) {
+	return strncmp(address, "unix:", 5) == 0;
+}
+
+// Opens a socket for the address, bound when listening and connected otherwise
+static rte_socket_handle_t rte_socket_open(const char* address, int listening) {
+	if (!rte_socket_startup() || strlen(address) >= RTE_SOCKET_MAX_ADDRESS) {
+		return RTE_SOCKET_INVALID;
+	}
+
+	if (rte_socket_is_unix(address)) {
+#if defined(_WIN32)
+		return RTE_SOCKET_INVALID;
+#else
+		struct sockaddr_un addr;
+		const char* path = address + 5;
+
+		if (strlen(path) >= sizeof(addr.sun_path)) {
+			return RTE_SOCKET_INVALID;
+		}
+
+		memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		strcpy(addr.sun_path, path);
+
+		rte_socket_handle_t handle = socket(AF_UNIX, SOCK_STREAM, 0);
+
+		if (handle == RTE_SOCKET_INVALID) {
+			return RTE_SOCKET_INVALID;
+		}
+
+		int result;
+
+		if (listening) {
+			// Only a socket left behind by an earlier listener is replaced, any other file at the path is kept
+			struct stat info;
+
+			if (lstat(path, &info) == 0) {
+				if (!S_ISSOCK(info.st_mode) || unlink(path) != 0) {
+					rte_socket_close_handle(handle);
+					return RTE_SOCKET_INVALID;
+				}
+			} else if (errno != ENOENT) {
+				rte_socket_close_handle(handle);
+				return RTE_SOCKET_INVALID;
+			}
+
+			result = bind(handle, (struct sockaddr*)&addr, sizeof(addr));
+		} else {
+			result = connect(handle, (struct sockaddr*)&addr, sizeof(addr));
+		}
+
+		if (result != 0) {
+			rte_socket_close_handle(handle);
+			return RTE_SOCKET_INVALID;
+		}
+
+		return handle;
+#endif
+	}
+
+	// Split "host:port" on the last colon
+	char host[RTE_SOCKET_MAX_ADDRESS];
+	const char* colon = strrchr(address, ':');
+
+	if (colon == NULL) {
+		return RTE_SOCKET_INVALID;
+	}
+
+	memcpy(host, address, colon - address);
+	host[colon - address] = '\0';
+
+	struct addrinfo hints;
+	struct addrinfo* results = NULL;
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = listening ? AI_PASSIVE : 0;
+
+	if (getaddrinfo(host[0] != '\0' ? host : NULL, colon + 1, &hints, &results) != 0) {
+		return RTE_SOCKET_INVALID;
+	}
+
+	rte_socket_handle_t handle = RTE_SOCKET_INVALID;
+
+	for (struct addrinfo* info = results; info != NULL; info = info->ai_next) {
+		handle = socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+
+		if (handle == RTE_SOCKET_INVALID) {
+			continue;
+		}
+
+		int result;
+
+		if (listening) {
+			int reuse = 1;
+			setsockopt(handle, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+
+			result = bind(handle, info->ai_addr, (int)info->ai_addrlen);
+		} else {
+			result = connect(handle, info->ai_addr, (int)info->ai_addrlen);
+		}
+
+		if (result == 0) {
+			break;
+		}
+
+		rte_socket_close_handle(handle);
+		handle = RTE_SOCKET_INVALID;
+	}
+
+	freeaddrinfo(results);
+
+	if (handle != RTE_SOCKET_INVALID && !listening) {
+		// Small messages go out immediately instead of waiting on the ack of the last one
+		int no_delay = 1;
+		setsockopt(handle, IPPROTO_TCP, TCP_NODELAY, (const char*)&no_delay, sizeof(no_delay));
+	}
+
+	return handle;
+}
+
+rte_socket_t* rte_socket_listen(const char* address) {
+	rte_socket_handle_t handle = rte_socket_open(address, 1);
+
+	if (handle == RTE_SOCKET_INVALID) {
+		return NULL;
+	}
+
+	if (listen(handle, SOMAXCONN) != 0) {
+		rte_socket_close_handle(handle);
+		return NULL;
+	}
+
+	rte_socket_t* sock = rte_socket_wrap(handle);
+
+#if !defined(_WIN32)
+	if (sock != NULL && rte_socket_is_unix(address)) {
+		const char* path = address + 5;
+
+		sock->unlink_path = (char*)malloc(strlen(path) + 1);
+
+		if (sock->unlink_path == NULL) {
+			rte_socket_close(sock);
+			return NULL;
+		}
+
+		strcpy(sock->unlink_path, path);
+	}
+#endif
+
+	return sock;
+}
+
+rte_socket_t* rte_socket_accept(rte_socket_t* listener) {
+	rte_socket_handle_t handle = accept(listener->handle, NULL, NULL);
+
+	if (handle == RTE_SOCKET_INVALID) {
+		return NULL;
+	}
+
+	return rte_socket_wrap(handle);
+}
+
+rte_socket_t* rte_socket_connect(const char* address) {
+	rte_socket_handle_t handle = rte_socket_open(address, 0);
+
+	if (handle == RTE_SOCKET_INVALID) {
+		return NULL;
+	}
+
+	return rte_socket_wrap(handle);
+}
+
+void rte_socket_close(rte_socket_t* socket) {
+	if (socket == NULL) {
+		return;
+	}
+
+	rte_socket_close_handle(socket->handle);
+
+#if !defined(_WIN32)
+	if (socket->unlink_path != NULL) {
+		unlink(socket->unlink_path);
+	}
+#endif
+
+	free(socket->unlink_path);
+	free(socket);
+}
+
+int rte_socket_send_all(rte_socket_t* socket, const void* data, size_t size) {
+	const char* bytes = (const char*)data;
+
+	// A peer that went away must fail the send, not raise SIGPIPE
+#if defined(MSG_NOSIGNAL)
+	int flags = MSG_NOSIGNAL;
+#else
+	int flags = 0;
+#endif
+
+	while (size > 0) {
+		int chunk = size > 0x40000000 ? 0x40000000 : (int)size;
+		int sent = (int)send(socket->handle, bytes, chunk, flags);
+
+		if (sent <= 0) {
+#if !defined(_WIN32)
+			if (sent < 0 && errno == EINTR) {
+				continue;
+			}
+#endif
+			return 0;
+		}
+
+		bytes += sent;
+		size -= (size_t)sent;
+	}
+
+	return 1;
+}
+
+int rte_socket_recv(rte_socket_t* socket, void* data, size_t size) {
+	int chunk = size > 0x40000000 ? 0x40000000 : (int)size;
+
+	for (;;) {
+		int received = (int)recv(socket->handle, (char*)data, chunk, 0);
+
+#if !defined(_WIN32)
+		if (received < 0 && errno == EINTR) {
+			continue;
+		}
+#endif
+
+		return received < 0 ? -1 : received;
+	}
+}
+
+int rte_socket_recv_all(rte_socket_t* socket, void* data, size_t size) {
+	char* bytes = (char*)data;
+
+	while (size > 0) {
+		int received = rte_socket_recv(socket, bytes, size);
+
+		if (received <= 0) {
+			return 0;
+		}
+
+		bytes += received;
+		size -= (size_t)received;
+	}
+
+	return 1;
+}
+
+int rte_socket_wait(rte_socket_t* socket, int timeout_ms) {
+	fd_set readable;
+	FD_ZERO(&readable);
+	FD_SET(socket->handle, &readable);
+
+	struct timeval timeout;
+	timeout.tv_sec = timeout_ms / 1000;
+	timeout.tv_usec = (timeout_ms % 1000) * 1000;
+
+	int result = select((int)socket->handle + 1, &readable, NULL, NULL, &timeout);
+
+	if (result < 0) {
+#if !defined(_WIN32)
+		if (errno == EINTR) {
+			return 0;
+		}
+#endif
+		return -1;
+	}
+
+	return result > 0;
+}
+
+void rte_socket_set_timeout(rte_socket_t* socket, int timeout_ms) {
+#if defined(_WIN32)
+	DWORD timeout = (DWORD)timeout_ms;
+#else
+	struct timeval timeout;
+	timeout.tv_sec = timeout_ms / 1000;
+	timeout.tv_usec = (timeout_ms % 1000) * 1000;
+#endif
+
+	setsockopt(socket->handle, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
+}
+
+#else
+
+//
+// No sockets, everything fails
+//
+struct rte_socket {
+	int unused;
+};
+
+rte_socket_t* rte_socket_listen(const char* address) {
+	return NULL;
+}
+
+rte_socket_t* rte_socket_accept(rte_socket_t* listener) {
+	return NULL;
+}
+
+rte_socket_t* rte_socket_connect(const char* address) {
+	return NULL;
+}
+
+void rte_socket_close(rte_socket_t* socket) {
+}
+
+int rte_socket_send_all(rte_socket_t* socket, const void* data, size_t size) {
+	return 0;
+}
+
+int rte_socket_recv_all(rte_socket_t* socket, void* data, size_t size) {
+	return 0;
+}
+
+int rte_socket_recv(rte_socket_t* socket, void* data, size_t size) {
+	return -1;
+}
+
+int rte_socket_wait(rte_socket_t* socket, int timeout_ms) {
+	return -1;
+}
+
+void rte_socket_set_timeout(rte_socket_t* socket, int timeout_ms) {
+}
+
+#endif
@@ -0,0 +1,51 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#ifndef RTEVERYWHERE_SOCKET_H
+#define RTEVERYWHERE_SOCKET_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Minimal blocking stream sockets over BSD sockets / Winsock
+// Addresses are "host:port" for TCP, an empty host meaning every interface when listening and localhost when connecting,
+// or "unix:/path" for a Unix domain socket
+// Define RTE_NO_SOCKETS on targets without either, every call then fails
+//
+
+typedef struct rte_socket rte_socket_t;
+
+// Returns NULL on failure, a stale Unix socket file at the same path is replaced but any other file there is an error
+// Unix listeners remove their socket file when closed
+extern rte_socket_t* rte_socket_listen(const char* address);
+
+// Blocks until a connection arrives, returns NULL on failure
+extern rte_socket_t* rte_socket_accept(rte_socket_t* listener);
+
+extern rte_socket_t* rte_socket_connect(const char* address);
+
+extern void rte_socket_close(rte_socket_t* socket);
+
+// Transfers exactly size bytes, returns 0 if the connection failed, closed or timed out first
+extern int rte_socket_send_all(rte_socket_t* socket, const void* data, size_t size);
+extern int rte_socket_recv_all(rte_socket_t* socket, void* data, size_t size);
+
+// Receives whatever is available, up to size bytes. Returns the byte count, 0 once closed and -1 on failure
+extern int rte_socket_recv(rte_socket_t* socket, void* data, size_t size);
+
+// Returns 1 once the socket is readable (or a listener has a connection waiting), 0 on timeout and -1 on failure
+extern int rte_socket_wait(rte_socket_t* socket, int timeout_ms);
+
+// Receives that stall for longer than timeout_ms fail, 0 waits forever
+extern void rte_socket_set_timeout(rte_socket_t* socket, int timeout_ms);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif //RTEVERYWHERE_SOCKET_H
@@ -0,0 +1,335 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#include "adaptive.h"
+
+#include "../accel/packet.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+// Tiles are refined in blocks this wide, plus a one pixel border so edges between blocks are still found
+#define ADAPTIVE_BLOCK 16
+#define ADAPTIVE_GRID (ADAPTIVE_BLOCK + 2)
+
+// Pixels are visited in groups this wide so neighbouring rays end up in the same packet
+#define ADAPTIVE_GROUP 4
+
+#define ADAPTIVE_BATCH (PACKET_SIZE * 4)
+
+typedef struct adaptive_pixel {
+	rvec3_t sum;
+	rvec3_t display;
+
+	// Luminance of each sample after tonemapping, for the spread of the samples
+	real_t luma_sum;
+	real_t luma_sq_sum;
+
+	int count;
+	int mirror;
+	int refine;
+} adaptive_pixel_t;
+
+typedef struct adaptive_block {
+	adaptive_pixel_t pixels[ADAPTIVE_GRID * ADAPTIVE_GRID];
+	unsigned int x;
+	unsigned int y;
+	unsigned int width; // Of the grid, the block plus its border
+	unsigned int height;
+
+	rte_ray_t rays[ADAPTIVE_BATCH];
+	int owners[ADAPTIVE_BATCH];
+	int pending;
+
+	int traced;
+} adaptive_block_t;
+
+rte_adaptive_t rte_adaptive_defaults() {
+	rte_adaptive_t settings;
+
+	settings.max_samples = RTE_ADAPTIVE_MAX_SAMPLES;
+	settings.threshold = REAL(0.08);
+
+	return settings;
+}
+
+// The same transform trace_pixel_block applies before writing a color out
+static void adaptive_display(rvec3_out_t dst, const rvec3_t color, rte_tonemap_e tonemapping) {
+	rvec3_copy(dst, color);
+
+	if (tonemapping == RTE_TONEMAP_ACES)
+		tonemap_aces(dst);
+
+	rvec3_saturate(dst);
+}
+
+static void adaptive_flush(adaptive_block_t* block, const trace_t* trace) {
+	rvec3_t colors[ADAPTIVE_BATCH];
+	int mirrors[ADAPTIVE_BATCH];
+
+	trace_ray_batch(colors, mirrors, NULL, block->rays, block->pending, trace->scene);
+
+	for (int r = 0; r < block->pending; r++) {
+		adaptive_pixel_t* pixel = &block->pixels[block->owners[r]];
+
+		rvec3_add(RVEC_OUT(pixel->sum), pixel->sum, colors[r]);
+
+		rvec3_t display;
+		adaptive_display(RVEC_OUT(display), colors[r], trace->tonemapping);
+
+		real_t luma = display[0] * REAL(0.2126) + display[1] * REAL(0.7152) + display[2] * REAL(0.0722);
+
+		pixel->luma_sum += luma;
+		pixel->luma_sq_sum += luma * luma;
+		pixel->count++;
+		pixel->mirror |= mirrors[r];
+	}
+
+	block->traced += block->pending;
+	block->pending = 0;
+}
+
+static void adaptive_push(adaptive_block_t* block, const trace_t* trace, int owner, int sample) {
+	unsigned int gx = (unsigned int)owner % block->width;
+	unsigned int gy = (unsigned int)owner / block->width;
+
+	rte_point_t point;
+	point.x = block->x + gx - 1;
+	point.y = block->y + gy - 1;
+
+	real_t offset_x;
+	real_t offset_y;
+	camera_sample_offset(sample, &offset_x, &offset_y);
+
+	camera_offset_ray(&block->rays[block->pending], &trace->camera, point, offset_x, offset_y);
+	block->owners[block->pending] = owner;
+	block->pending++;
+
+	if (block->pending == ADAPTIVE_BATCH) {
+		adaptive_flush(block, trace);
+	}
+}
+
+static int adaptive_inside(const adaptive_block_t* block, unsigned int gx, unsigned int gy) {
+	return gx > 0 && gy > 0 && gx < block->width - 1 && gy < block->height - 1;
+}
+
+// Adds samples to every pixel flagged for refinement until it holds the target for its current count
+static void adaptive_refine(adaptive_block_t* block, const trace_t* trace, int max_samples) {
+	for (unsigned int group_y = 0; group_y < block->height; group_y += ADAPTIVE_GROUP) {
+		for (unsigned int group_x = 0; group_x < block->width; group_x += ADAPTIVE_GROUP) {
+			for (unsigned int gy = group_y; gy < group_y + ADAPTIVE_GROUP && gy < block->height; gy++) {
+				for (unsigned int gx = group_x; gx < group_x + ADAPTIVE_GROUP && gx < block->width; gx++) {
+					int owner = (int)(gy * block->width + gx);
+					adaptive_pixel_t* pixel = &block->pixels[owner];
+
+					if (!pixel->refine) {
+						continue;
+					}
+
+					// 1 sample for the base pass, then 4 and doubling from there
+					int target = pixel->count == 0 ? 1 : pixel->count == 1 ? 4 : pixel->count * 2;
+
+					if (target > max_samples) {
+						target = max_samples;
+					}
+
+					for (int s = pixel->count; s < target; s++) {
+						adaptive_push(block, trace, owner, s);
+					}
+				}
+			}
+		}
+	}
+
+	if (block->pending > 0) {
+		adaptive_flush(block, trace);
+	}
+}
+
+static void trace_block_adaptive(adaptive_block_t* block, const trace_t* trace, const rte_adaptive_t* settings) {
+	unsigned int cell_count = block->width * block->height;
+	unsigned int viewport_w = trace->camera.viewport.width;
+	unsigned int viewport_h = trace->camera.viewport.height;
+
+	// The border is only needed to compare against, none of it is traced without refinement
+	int border = settings->max_samples > 1;
+
+	for (unsigned int c = 0; c < cell_count; c++) {
+		unsigned int gx = c % block->width;
+		unsigned int gy = c / block->width;
+
+		adaptive_pixel_t* pixel = &block->pixels[c];
+		rvec3_copy(RVEC_OUT(pixel->sum), (rvec3_t) {0, 0, 0});
+
+		pixel->luma_sum = 0;
+		pixel->luma_sq_sum = 0;
+		pixel->count = 0;
+		pixel->mirror = 0;
+
+		// Border pixels outside of the viewport are left out of the comparison entirely
+		int in_view = block->x + gx >= 1 && block->y + gy >= 1 && block->x + gx - 1 < viewport_w && block->y + gy - 1 < viewport_h;
+		pixel->refine = in_view && (border || adaptive_inside(block, gx, gy));
+	}
+
+	//
+	// Base pass
+	//
+	adaptive_refine(block, trace, 1);
+
+	if (settings->max_samples <= 1) {
+		return;
+	}
+
+	for (unsigned int c = 0; c < cell_count; c++) {
+		adaptive_pixel_t* pixel = &block->pixels[c];
+
+		if (pixel->count > 0) {
+			adaptive_display(RVEC_OUT(pixel->display), pixel->sum, trace->tonemapping);
+		}
+	}
+
+	//
+	// Contrast against the neighbours
+	//
+	for (unsigned int gy = 1; gy < block->height - 1; gy++) {
+		for (unsigned int gx = 1; gx < block->width - 1; gx++) {
+			adaptive_pixel_t* pixel = &block->pixels[gy * block->width + gx];
+			pixel->refine = 0;
+
+			if (pixel->count == 0) {
+				continue;
+			}
+
+			real_t threshold = pixel->mirror ? settings->threshold * REAL(0.5) : settings->threshold;
+
+			for (unsigned int ny = gy - 1; ny <= gy + 1 && !pixel->refine; ny++) {
+				for (unsigned int nx = gx - 1; nx <= gx + 1; nx++) {
+					const adaptive_pixel_t* neighbour = &block->pixels[ny * block->width + nx];
+
+					if (neighbour->count == 0) {
+						continue;
+					}
+
+					real_t contrast = 0;
+
+					for (int i = 0; i < 3; i++) {
+						real_t difference = (real_t)fabs(pixel->display[i] - neighbour->display[i]);
+						contrast = difference > contrast ? difference : contrast;
+					}
+
+					if (contrast > threshold) {
+						pixel->refine = 1;
+						break;
+					}
+				}
+			}
+		}
+	}
+
+	// Border pixels belong to the neighbouring blocks
+	for (unsigned int c = 0; c < cell_count; c++) {
+		if (!adaptive_inside(block, c % block->width, c / block->width)) {
+			block->pixels[c].refine = 0;
+		}
+	}
+
+	//
+	// Refinement
+	// Pixels keep doubling their samples while those samples disagree
+	//
+	for (;;) {
+		adaptive_refine(block, trace, settings->max_samples);
+
+		int refining = 0;
+
+		for (unsigned int c = 0; c < cell_count; c++) {
+			adaptive_pixel_t* pixel = &block->pixels[c];
+
+			if (!pixel->refine) {
+				continue;
+			}
+
+			real_t threshold = pixel->mirror ? settings->threshold * REAL(0.5) : settings->threshold;
+
+			real_t mean = pixel->luma_sum / (real_t)pixel->count;
+			real_t variance = pixel->luma_sq_sum / (real_t)pixel->count - mean * mean;
+
+			pixel->refine = pixel->count < settings->max_samples && variance > threshold * threshold;
+			refining |= pixel->refine;
+		}
+
+		if (!refining) {
+			break;
+		}
+	}
+}
+
+int trace_tile_adaptive(rvec3_t* dst_cols, const trace_t trace, rte_tile_t tile, const rte_adaptive_t* settings) {
+	rte_adaptive_t clamped = *settings;
+
+	if (clamped.max_samples < 1) {
+		clamped.max_samples = 1;
+	}
+
+	if (clamped.max_samples > RTE_ADAPTIVE_MAX_SAMPLES) {
+		clamped.max_samples = RTE_ADAPTIVE_MAX_SAMPLES;
+	}
+
+	// Tens of kilobytes, kept off the stack of the worker threads
+	adaptive_block_t* block = (adaptive_block_t*)malloc(sizeof(adaptive_block_t));
+
+	if (block == NULL) {
+		// No room for the refinement state, the tile still gets a plain 1 spp trace instead of being left unwritten
+		trace_t single = trace;
+
+		single.camera.samples = CAMERA_SAMPLES_ONE;
+		single.point.x = tile.x;
+		single.point.y = tile.y;
+
+		trace_pixel_block(dst_cols, single, tile.width, tile.height);
+		return (int)(tile.width * tile.height);
+	}
+
+	int traced = 0;
+
+	for (unsigned int y = 0; y < tile.height; y += ADAPTIVE_BLOCK) {
+		for (unsigned int x = 0; x < tile.width; x += ADAPTIVE_BLOCK) {
+			unsigned int block_w = tile.width - x < ADAPTIVE_BLOCK ? tile.width - x : ADAPTIVE_BLOCK;
+			unsigned int block_h = tile.height - y < ADAPTIVE_BLOCK ? tile.height - y : ADAPTIVE_BLOCK;
+
+			block->x = tile.x + x;
+			block->y = tile.y + y;
+			block->width = block_w + 2;
+			block->height = block_h + 2;
+			block->pending = 0;
+			block->traced = 0;
+
+			trace_block_adaptive(block, &trace, &clamped);
+
+			traced += block->traced;
+
+			//
+			// Final pass
+			//
+			for (unsigned int by = 0; by < block_h; by++) {
+				for (unsigned int bx = 0; bx < block_w; bx++) {
+					const adaptive_pixel_t* pixel = &block->pixels[(by + 1) * block->width + bx + 1];
+					unsigned int p = (y + by) * tile.width + x + bx;
+
+					rvec3_mul_scalar(RVEC_OUT(dst_cols[p]), pixel->sum, REAL(1.0) / (real_t)pixel->count);
+
+					if (trace.tonemapping == RTE_TONEMAP_ACES)
+						tonemap_aces(RVEC_OUT(dst_cols[p]));
+
+					rvec3_saturate(RVEC_OUT(dst_cols[p]));
+				}
+			}
+		}
+	}
+
+	free(block);
+
+	return traced;
+}
@@ -0,0 +1,40 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#ifndef RTEVERYWHERE_ADAPTIVE_H
+#define RTEVERYWHERE_ADAPTIVE_H
+
+#include "../rt_everywhere.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Adaptive supersampling
+// Every pixel starts with a single sample at its center, pixels that differ from a neighbour by more than the
+// threshold (after tonemapping) are refined to 4 samples, then keep doubling up to max_samples while their own
+// samples still disagree. Mirror hits are refined at half the threshold since reflections alias more than the base pass
+// Flat regions stay at 1 sample, so edges can get up to 16 for less than fixed 4x MSAA costs over the whole frame
+//
+
+#define RTE_ADAPTIVE_MAX_SAMPLES 16
+
+typedef struct rte_adaptive {
+	int max_samples; // 1 to RTE_ADAPTIVE_MAX_SAMPLES, 1 matches CAMERA_SAMPLES_ONE exactly
+	real_t threshold; // Largest difference in any display channel (0 to 1) left unrefined
+} rte_adaptive_t;
+
+extern rte_adaptive_t rte_adaptive_defaults();
+
+// Writes the tile row-major into dst_cols, trace.camera.samples is ignored in favor of the settings
+// Returns how many camera rays were traced, for comparing against width * height * samples
+// Falls back to 1 spp when the refinement state can't be allocated
+extern int trace_tile_adaptive(rvec3_t* dst_cols, const trace_t trace, rte_tile_t tile, const rte_adaptive_t* settings);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif //RTEVERYWHERE_ADAPTIVE_H
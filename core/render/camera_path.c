@@ -0,0 +1,176 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#include "camera_path.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CAMERA_PATH_LINE_MAX 512
+
+void rte_camera_path_init(rte_camera_path_t* path) {
+	path->keyframes = NULL;
+	path->keyframe_count = 0;
+	path->keyframe_capacity = 0;
+}
+
+void rte_camera_path_free(rte_camera_path_t* path) {
+	free(path->keyframes);
+	rte_camera_path_init(path);
+}
+
+int rte_camera_path_add(rte_camera_path_t* path, real_t time, const rvec3_t position, const rvec3_t rotation) {
+	if (path->keyframe_count == path->keyframe_capacity) {
+		int capacity = path->keyframe_capacity > 0 ? path->keyframe_capacity * 2 : 16;
+		rte_keyframe_t* keyframes = (rte_keyframe_t*)realloc(path->keyframes, sizeof(rte_keyframe_t) * capacity);
+
+		if (keyframes == NULL) {
+			return 0;
+		}
+
+		path->keyframes = keyframes;
+		path->keyframe_capacity = capacity;
+	}
+
+	// Keyframes mostly arrive in order, so the insertion point is found from the back
+	int k = path->keyframe_count;
+
+	while (k > 0 && path->keyframes[k - 1].time > time) {
+		path->keyframes[k] = path->keyframes[k - 1];
+		k--;
+	}
+
+	path->keyframes[k].time = time;
+	rvec3_copy(RVEC_OUT(path->keyframes[k].position), position);
+	rvec3_copy(RVEC_OUT(path->keyframes[k].rotation), rotation);
+
+	path->keyframe_count++;
+	return 1;
+}
+
+static int camera_path_read_vec3(const char** p_c, rvec3_out_t dst) {
+	const char* c = *p_c;
+
+	for (int a = 0; a < 3; a++) {
+		char* end;
+		double value = strtod(c, &end);
+
+		if (end == c) {
+			return 0;
+		}
+
+		RVEC_OUT_DEREF(dst)[a] = (real_t)value;
+		c = end;
+
+		if (a < 2) {
+			if (*c != ',') {
+				return 0;
+			}
+
+			c++;
+		}
+	}
+
+	*p_c = c;
+	return 1;
+}
+
+int rte_camera_path_load(rte_camera_path_t* path, const char* file) {
+	FILE* stream = fopen(file, "r");
+
+	if (stream == NULL) {
+		return 0;
+	}
+
+	char line[CAMERA_PATH_LINE_MAX];
+	int success = 1;
+
+	while (success && fgets(line, sizeof(line), stream) != NULL) {
+		char* comment = strchr(line, '#');
+
+		if (comment != NULL) {
+			*comment = '\0';
+		}
+
+		const char* c = line;
+		char* end;
+
+		double time = strtod(c, &end);
+
+		// Blank and comment only lines
+		if (end == c) {
+			while (*c == ' ' || *c == '\t' || *c == '\r' || *c == '\n') {
+				c++;
+			}
+
+			success = *c == '\0';
+			continue;
+		}
+
+		c = end;
+
+		rvec3_t position;
+		rvec3_t rotation;
+
+		success = camera_path_read_vec3(&c, RVEC_OUT(position))
+			&& camera_path_read_vec3(&c, RVEC_OUT(rotation))
+			&& rte_camera_path_add(path, (real_t)time, position, rotation);
+	}
+
+	fclose(stream);
+	return success;
+}
+
+real_t rte_camera_path_start(const rte_camera_path_t* path) {
+	return path->keyframe_count > 0 ? path->keyframes[0].time : 0;
+}
+
+real_t rte_camera_path_end(const rte_camera_path_t* path) {
+	return path->keyframe_count > 0 ? path->keyframes[path->keyframe_count - 1].time : 0;
+}
+
+// Uniform Catmull-Rom between b and c, a and d are the neighbouring keyframes
+static real_t camera_path_spline(real_t a, real_t b, real_t c, real_t d, real_t t) {
+	real_t t2 = t * t;
+	real_t t3 = t2 * t;
+
+	return REAL(0.5) * ((2 * b) + (c - a) * t + (2 * a - 5 * b + 4 * c - d) * t2 + (3 * b - a - 3 * c + d) * t3);
+}
+
+void rte_camera_path_sample(const rte_camera_path_t* path, real_t time, rvec3_out_t position, rvec3_out_t rotation) {
+	const rte_keyframe_t* keyframes = path->keyframes;
+	int last = path->keyframe_count - 1;
+
+	if (time <= keyframes[0].time || last == 0) {
+		rvec3_copy(position, keyframes[0].position);
+		rvec3_copy(rotation, keyframes[0].rotation);
+		return;
+	}
+
+	if (time >= keyframes[last].time) {
+		rvec3_copy(position, keyframes[last].position);
+		rvec3_copy(rotation, keyframes[last].rotation);
+		return;
+	}
+
+	// Segment from b to c, the ends reuse their own keyframe as the missing neighbour
+	int b = 0;
+
+	while (b < last - 1 && keyframes[b + 1].time <= time) {
+		b++;
+	}
+
+	int a = b > 0 ? b - 1 : b;
+	int c = b + 1;
+	int d = c < last ? c + 1 : c;
+
+	real_t span = keyframes[c].time - keyframes[b].time;
+	real_t t = span > 0 ? (time - keyframes[b].time) / span : 0;
+
+	for (int e = 0; e < 3; e++) {
+		RVEC_OUT_DEREF(position)[e] = camera_path_spline(keyframes[a].position[e], keyframes[b].position[e], keyframes[c].position[e], keyframes[d].position[e], t);
+		RVEC_OUT_DEREF(rotation)[e] = camera_path_spline(keyframes[a].rotation[e], keyframes[b].rotation[e], keyframes[c].rotation[e], keyframes[d].rotation[e], t);
+	}
+}
@@ -0,0 +1,53 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#ifndef RTEVERYWHERE_CAMERA_PATH_H
+#define RTEVERYWHERE_CAMERA_PATH_H
+
+#include "../math/vectors.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Camera paths
+// Keyframes of a camera position and rotation (pitch, yaw, roll in degrees) at points in time
+// Both are interpolated with a Catmull-Rom spline so the camera moves smoothly through every keyframe
+//
+
+typedef struct rte_keyframe {
+	real_t time;
+	rvec3_t position;
+	rvec3_t rotation;
+} rte_keyframe_t;
+
+typedef struct rte_camera_path {
+	rte_keyframe_t* keyframes; // Sorted by time
+	int keyframe_count;
+	int keyframe_capacity;
+} rte_camera_path_t;
+
+extern void rte_camera_path_init(rte_camera_path_t* path);
+extern void rte_camera_path_free(rte_camera_path_t* path);
+
+// Inserts a keyframe in time order, returns 0 if memory ran out
+extern int rte_camera_path_add(rte_camera_path_t* path, real_t time, const rvec3_t position, const rvec3_t rotation);
+
+// Appends the keyframes of a text file, one "time x,y,z pitch,yaw,roll" per line, # starts a comment
+// Returns 0 if the file couldn't be read, a line didn't parse or memory ran out
+extern int rte_camera_path_load(rte_camera_path_t* path, const char* file);
+
+extern real_t rte_camera_path_start(const rte_camera_path_t* path);
+extern real_t rte_camera_path_end(const rte_camera_path_t* path);
+
+// Interpolates the camera at the given time, clamped to the first and last keyframe
+// The path must have at least one keyframe
+extern void rte_camera_path_sample(const rte_camera_path_t* path, real_t time, rvec3_out_t position, rvec3_out_t rotation);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif //RTEVERYWHERE_CAMERA_PATH_H
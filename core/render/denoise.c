@@ -0,0 +1,423 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#include "denoise.h"
+
+#include "../accel/packet.h"
+#include "../math/simd.h"
+#include "../threading/thread.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define DENOISE_BATCH (PACKET_SIZE * 4)
+
+// Lighting differences are brought back to the albedo of the pixel being filtered, so noise weighs the same on dark
+// and bright surfaces. The first pass is the most forgiving, every pass after it halves sigma squared
+#define DENOISE_COLOR_SIGMA REAL(0.2)
+
+// Depth differences are relative to the distance of the pixel, like the upscaler's
+#define DENOISE_DEPTH_SIGMA REAL(0.05)
+
+#define DENOISE_ALBEDO_SIGMA REAL(0.1)
+
+// Keeps dark surfaces from blowing their lighting up when divided by the albedo
+#define DENOISE_MIN_ALBEDO REAL(0.01)
+
+// Keeps the sky (depth 0) from dividing by 0, anything at a depth only matches the sky this way
+#define DENOISE_DEPTH_EPSILON REAL(0.0001)
+
+enum {
+	DENOISE_NORMAL_X,
+	DENOISE_NORMAL_Y,
+	DENOISE_NORMAL_Z,
+	DENOISE_ALBEDO_R,
+	DENOISE_ALBEDO_G,
+	DENOISE_ALBEDO_B,
+	DENOISE_DEPTH, // 0 for the sky
+
+	// Lighting, filtered from one set into the other every pass
+	DENOISE_COLOR_R,
+	DENOISE_COLOR_G,
+	DENOISE_COLOR_B,
+	DENOISE_SCRATCH_R,
+	DENOISE_SCRATCH_G,
+	DENOISE_SCRATCH_B,
+
+	DENOISE_PLANE_COUNT
+};
+
+// B3 spline, by distance from the center tap
+static const real_t denoise_kernel[3] = {REAL(0.375), REAL(0.25), REAL(0.0625)};
+
+typedef struct denoise_job {
+	rte_denoise_t* denoise;
+	const trace_t* trace;
+
+	int src; // First plane of the lighting read
+	int dst; // First plane of the lighting written
+	int step;
+
+	real_t color_scale; // 1 / sigma^2 of this pass
+} denoise_job_t;
+
+static real_t* denoise_plane(const rte_denoise_t* denoise, int plane) {
+	return denoise->planes + (size_t)plane * denoise->width * denoise->height;
+}
+
+int denoise_init(rte_denoise_t* denoise, unsigned int width, unsigned int height) {
+	memset(denoise, 0, sizeof(rte_denoise_t));
+
+	denoise->planes = (real_t*)malloc(sizeof(real_t) * DENOISE_PLANE_COUNT * width * height);
+
+	if (denoise->planes == NULL) {
+		return 0;
+	}
+
+	denoise->width = width;
+	denoise->height = height;
+
+	return 1;
+}
+
+void denoise_free(rte_denoise_t* denoise) {
+	free(denoise->planes);
+
+	memset(denoise, 0, sizeof(rte_denoise_t));
+}
+
+//
+// Guide pass
+//
+static void denoise_guide_rows(void* user, int begin, int end) {
+	denoise_job_t* job = (denoise_job_t*)user;
+	rte_denoise_t* denoise = job->denoise;
+
+	rte_ray_t rays[DENOISE_BATCH];
+	rte_fragment_t frags[DENOISE_BATCH];
+	int hits[DENOISE_BATCH];
+
+	real_t* normal[3] = {denoise_plane(denoise, DENOISE_NORMAL_X), denoise_plane(denoise, DENOISE_NORMAL_Y), denoise_plane(denoise, DENOISE_NORMAL_Z)};
+	real_t* albedo[3] = {denoise_plane(denoise, DENOISE_ALBEDO_R), denoise_plane(denoise, DENOISE_ALBEDO_G), denoise_plane(denoise, DENOISE_ALBEDO_B)};
+	real_t* depth = denoise_plane(denoise, DENOISE_DEPTH);
+
+	for (int y = begin; y < end; y++) {
+		for (unsigned int first = 0; first < denoise->width; first += DENOISE_BATCH) {
+			int count = denoise->width - first < DENOISE_BATCH ? (int)(denoise->width - first) : DENOISE_BATCH;
+
+			for (int r = 0; r < count; r++) {
+				rte_point_t point;
+				point.x = first + r;
+				point.y = y;
+
+				camera_offset_ray(&rays[r], &job->trace->camera, point, 0, 0);
+			}
+
+			trace_scene_packet(frags, hits, rays, count, job->trace->scene);
+
+			for (int r = 0; r < count; r++) {
+				size_t index = (size_t)y * denoise->width + first + r;
+
+				rte_fragment_t frag = frags[r];
+				rte_ray_t ray = rays[r];
+				int hit = hits[r];
+
+				rvec3_t tint = {1, 1, 1};
+				real_t distance = 0;
+
+				// Mirrors show whatever they reflect, so the guides come from the first surface that isn't one
+				// Otherwise every reflection would be blurred together with the rest of the mirror
+				for (int b = 0; hit && frag.material_type == MATERIAL_TYPE_MIRROR && b < job->trace->scene.mirror_bounces; b++) {
+					rvec3_t offset;
+					rvec3_sub(RVEC_OUT(offset), frag.position, ray.origin);
+
+					distance += rvec3_length(offset);
+					rvec3_mul(RVEC_OUT(tint), tint, frag.albedo);
+
+					// Same bounce as shade_sample
+					rvec3_t bias;
+					rvec3_mul_scalar(RVEC_OUT(bias), frag.normal, REAL(0.001));
+
+					rvec3_t incidence;
+					rvec3_reflect(RVEC_OUT(incidence), ray.direction, frag.normal);
+					rvec3_normalize(RVEC_OUT(incidence));
+
+					rvec3_add(RVEC_OUT(ray.origin), frag.position, bias);
+					rvec3_copy(RVEC_OUT(ray.direction), incidence);
+
+					hit = trace_scene(&frag, ray, job->trace->scene);
+				}
+
+				// The sky faces back along the ray, so neighbouring sky pixels agree with each other
+				if (!hit) {
+					for (int c = 0; c < 3; c++) {
+						normal[c][index] = -ray.direction[c];
+						albedo[c][index] = tint[c];
+					}
+
+					depth[index] = 0;
+					continue;
+				}
+
+				rvec3_t offset;
+				rvec3_sub(RVEC_OUT(offset), frag.position, ray.origin);
+
+				for (int c = 0; c < 3; c++) {
+					normal[c][index] = frag.normal[c];
+					albedo[c][index] = tint[c] * frag.albedo[c];
+				}
+
+				depth[index] = distance + rvec3_length(offset);
+			}
+		}
+	}
+}
+
+void denoise_trace_guides(rte_denoise_t* denoise, const trace_t trace) {
+	denoise_job_t job;
+	job.denoise = denoise;
+	job.trace = &trace;
+
+	rte_parallel_for((int)denoise->height, 1, denoise_guide_rows, &job);
+}
+
+//
+// Filter passes
+// Every weight is folded into one division, 1 / ((1 + color) * (1 + depth) * (1 + albedo)), the SIMD path has no exp
+// The SIMD and scalar paths do the same math in the same order so either may filter any pixel
+//
+
+// Filters one pixel, taps that fall off the frame are skipped
+static void denoise_pixel(const denoise_job_t* job, int x, int y) {
+	const rte_denoise_t* denoise = job->denoise;
+
+	int width = (int)denoise->width;
+	int height = (int)denoise->height;
+
+	const real_t* normal[3] = {denoise_plane(denoise, DENOISE_NORMAL_X), denoise_plane(denoise, DENOISE_NORMAL_Y), denoise_plane(denoise, DENOISE_NORMAL_Z)};
+	const real_t* albedo[3] = {denoise_plane(denoise, DENOISE_ALBEDO_R), denoise_plane(denoise, DENOISE_ALBEDO_G), denoise_plane(denoise, DENOISE_ALBEDO_B)};
+	const real_t* depth = denoise_plane(denoise, DENOISE_DEPTH);
+	const real_t* src[3] = {denoise_plane(denoise, job->src), denoise_plane(denoise, job->src + 1), denoise_plane(denoise, job->src + 2)};
+
+	size_t index = (size_t)y * width + x;
+	real_t depth_scale = REAL(1.0) / (depth[index] * DENOISE_DEPTH_SIGMA + DENOISE_DEPTH_EPSILON);
+	real_t albedo_scale = REAL(1.0) / (DENOISE_ALBEDO_SIGMA * DENOISE_ALBEDO_SIGMA);
+
+	real_t sum[3] = {0, 0, 0};
+	real_t total = 0;
+
+	for (int dy = -2; dy <= 2; dy++) {
+		int ty = y + dy * job->step;
+
+		if (ty < 0 || ty >= height) {
+			continue;
+		}
+
+		for (int dx = -2; dx <= 2; dx++) {
+			int tx = x + dx * job->step;
+
+			if (tx < 0 || tx >= width) {
+				continue;
+			}
+
+			size_t tap = (size_t)ty * width + tx;
+
+			real_t facing = normal[0][index] * normal[0][tap] + normal[1][index] * normal[1][tap] + normal[2][index] * normal[2][tap];
+			facing = facing > 0 ? facing : 0;
+			facing *= facing;
+			facing *= facing;
+			facing *= facing;
+
+			real_t color = 0;
+			real_t tint = 0;
+
+			for (int c = 0; c < 3; c++) {
+				real_t difference = (src[c][tap] - src[c][index]) * albedo[c][index];
+				color += difference * difference;
+
+				difference = albedo[c][tap] - albedo[c][index];
+				tint += difference * difference;
+			}
+
+			real_t distance = (depth[tap] - depth[index]) * depth_scale;
+
+			real_t falloff = (REAL(1.0) + color * job->color_scale) * (REAL(1.0) + distance * distance) * (REAL(1.0) + tint * albedo_scale);
+			real_t weight = denoise_kernel[abs(dx)] * denoise_kernel[abs(dy)] * facing / falloff;
+
+			for (int c = 0; c < 3; c++) {
+				sum[c] += src[c][tap] * weight;
+			}
+
+			total += weight;
+		}
+	}
+
+	// The center tap always agrees with itself, so total is never 0
+	for (int c = 0; c < 3; c++) {
+		denoise_plane(denoise, job->dst + c)[index] = sum[c] / total;
+	}
+}
+
+#ifdef RSIMD_WIDTH
+// Filters RSIMD_WIDTH pixels of a row starting at x, every tap column has to be on the frame
+static void denoise_span(const denoise_job_t* job, int x, int y) {
+	const rte_denoise_t* denoise = job->denoise;
+
+	int width = (int)denoise->width;
+	int height = (int)denoise->height;
+
+	const real_t* normal[3] = {denoise_plane(denoise, DENOISE_NORMAL_X), denoise_plane(denoise, DENOISE_NORMAL_Y), denoise_plane(denoise, DENOISE_NORMAL_Z)};
+	const real_t* albedo[3] = {denoise_plane(denoise, DENOISE_ALBEDO_R), denoise_plane(denoise, DENOISE_ALBEDO_G), denoise_plane(denoise, DENOISE_ALBEDO_B)};
+	const real_t* depth = denoise_plane(denoise, DENOISE_DEPTH);
+	const real_t* src[3] = {denoise_plane(denoise, job->src), denoise_plane(denoise, job->src + 1), denoise_plane(denoise, job->src + 2)};
+
+	size_t index = (size_t)y * width + x;
+
+	const rsimd_t zero = rsimd_set1(REAL(0.0));
+	const rsimd_t one = rsimd_set1(REAL(1.0));
+	const rsimd_t color_scale = rsimd_set1(job->color_scale);
+	const rsimd_t albedo_scale = rsimd_set1(REAL(1.0) / (DENOISE_ALBEDO_SIGMA * DENOISE_ALBEDO_SIGMA));
+
+	rsimd_t center_normal[3];
+	rsimd_t center_albedo[3];
+	rsimd_t center_color[3];
+
+	for (int c = 0; c < 3; c++) {
+		center_normal[c] = rsimd_load(normal[c] + index);
+		center_albedo[c] = rsimd_load(albedo[c] + index);
+		center_color[c] = rsimd_load(src[c] + index);
+	}
+
+	rsimd_t center_depth = rsimd_load(depth + index);
+	rsimd_t depth_scale = rsimd_div(one, rsimd_add(rsimd_mul(center_depth, rsimd_set1(DENOISE_DEPTH_SIGMA)), rsimd_set1(DENOISE_DEPTH_EPSILON)));
+
+	rsimd_t sum[3] = {zero, zero, zero};
+	rsimd_t total = zero;
+
+	for (int dy = -2; dy <= 2; dy++) {
+		int ty = y + dy * job->step;
+
+		if (ty < 0 || ty >= height) {
+			continue;
+		}
+
+		for (int dx = -2; dx <= 2; dx++) {
+			size_t tap = (size_t)ty * width + x + dx * job->step;
+
+			rsimd_t facing = rsimd_mul(center_normal[0], rsimd_load(normal[0] + tap));
+			facing = rsimd_add(facing, rsimd_mul(center_normal[1], rsimd_load(normal[1] + tap)));
+			facing = rsimd_add(facing, rsimd_mul(center_normal[2], rsimd_load(normal[2] + tap)));
+			facing = rsimd_max(facing, zero);
+			facing = rsimd_mul(facing, facing);
+			facing = rsimd_mul(facing, facing);
+			facing = rsimd_mul(facing, facing);
+
+			rsimd_t tap_color[3];
+			rsimd_t color = zero;
+			rsimd_t tint = zero;
+
+			for (int c = 0; c < 3; c++) {
+				tap_color[c] = rsimd_load(src[c] + tap);
+
+				rsimd_t difference = rsimd_mul(rsimd_sub(tap_color[c], center_color[c]), center_albedo[c]);
+				color = rsimd_add(color, rsimd_mul(difference, difference));
+
+				difference = rsimd_sub(rsimd_load(albedo[c] + tap), center_albedo[c]);
+				tint = rsimd_add(tint, rsimd_mul(difference, difference));
+			}
+
+			rsimd_t distance = rsimd_mul(rsimd_sub(rsimd_load(depth + tap), center_depth), depth_scale);
+
+			rsimd_t falloff = rsimd_mul(rsimd_add(one, rsimd_mul(color, color_scale)), rsimd_add(one, rsimd_mul(distance, distance)));
+			falloff = rsimd_mul(falloff, rsimd_add(one, rsimd_mul(tint, albedo_scale)));
+
+			rsimd_t weight = rsimd_div(rsimd_mul(rsimd_set1(denoise_kernel[abs(dx)] * denoise_kernel[abs(dy)]), facing), falloff);
+
+			for (int c = 0; c < 3; c++) {
+				sum[c] = rsimd_add(sum[c], rsimd_mul(tap_color[c], weight));
+			}
+
+			total = rsimd_add(total, weight);
+		}
+	}
+
+	for (int c = 0; c < 3; c++) {
+		rsimd_store(denoise_plane(denoise, job->dst + c) + index, rsimd_div(sum[c], total));
+	}
+}
+#endif
+
+static void denoise_filter_rows(void* user, int begin, int end) {
+	denoise_job_t* job = (denoise_job_t*)user;
+	int width = (int)job->denoise->width;
+
+	for (int y = begin; y < end; y++) {
+		int x = 0;
+
+#ifdef RSIMD_WIDTH
+		// Pixels closer to the sides than the widest tap have some of theirs skipped, they're left to the scalar path
+		int margin = job->step * 2;
+
+		for (; x < margin && x < width; x++) {
+			denoise_pixel(job, x, y);
+		}
+
+		for (; x + RSIMD_WIDTH + margin <= width; x += RSIMD_WIDTH) {
+			denoise_span(job, x, y);
+		}
+#endif
+
+		for (; x < width; x++) {
+			denoise_pixel(job, x, y);
+		}
+	}
+}
+
+void denoise_filter(rte_denoise_t* denoise, rvec3_t* colors, int passes) {
+	size_t pixels = (size_t)denoise->width * denoise->height;
+
+	real_t* albedo[3] = {denoise_plane(denoise, DENOISE_ALBEDO_R), denoise_plane(denoise, DENOISE_ALBEDO_G), denoise_plane(denoise, DENOISE_ALBEDO_B)};
+	real_t* lighting[3] = {denoise_plane(denoise, DENOISE_COLOR_R), denoise_plane(denoise, DENOISE_COLOR_G), denoise_plane(denoise, DENOISE_COLOR_B)};
+
+	if (passes > RTE_DENOISE_MAX_PASSES) {
+		passes = RTE_DENOISE_MAX_PASSES;
+	}
+
+	for (size_t p = 0; p < pixels; p++) {
+		for (int c = 0; c < 3; c++) {
+			lighting[c][p] = colors[p][c] / (albedo[c][p] > DENOISE_MIN_ALBEDO ? albedo[c][p] : DENOISE_MIN_ALBEDO);
+		}
+	}
+
+	denoise_job_t job;
+	job.denoise = denoise;
+	job.trace = NULL;
+	job.src = DENOISE_COLOR_R;
+	job.dst = DENOISE_SCRATCH_R;
+	job.step = 1;
+	job.color_scale = REAL(1.0) / (DENOISE_COLOR_SIGMA * DENOISE_COLOR_SIGMA);
+
+	for (int pass = 0; pass < passes; pass++) {
+		rte_parallel_for((int)denoise->height, 1, denoise_filter_rows, &job);
+
+		int swap = job.src;
+		job.src = job.dst;
+		job.dst = swap;
+
+		job.step *= 2;
+		job.color_scale *= REAL(2.0);
+	}
+
+	for (int c = 0; c < 3; c++) {
+		lighting[c] = denoise_plane(denoise, job.src + c);
+	}
+
+	for (size_t p = 0; p < pixels; p++) {
+		for (int c = 0; c < 3; c++) {
+			colors[p][c] = lighting[c][p] * (albedo[c][p] > DENOISE_MIN_ALBEDO ? albedo[c][p] : DENOISE_MIN_ALBEDO);
+		}
+
+		rvec3_saturate(RVEC_OUT(colors[p]));
+	}
+}
@@ -0,0 +1,49 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#ifndef RTEVERYWHERE_DENOISE_H
+#define RTEVERYWHERE_DENOISE_H
+
+#include "../rt_everywhere.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Edge-avoiding a-trous denoiser
+// A post-pass over a finished frame, each pass blurs with a 5x5 B3 spline kernel whose taps are spread twice as far
+// as the pass before (1, 2, 4, ...), so a few passes cover a wide area for the cost of 25 taps each. Taps are weighted
+// down by how much their color, normal, depth and albedo differ from the pixel being filtered so edges stay sharp.
+// Colors are divided by their albedo first, only lighting is blurred and textures like the ground checkers survive
+//
+
+#define RTE_DENOISE_MAX_PASSES 5
+
+typedef struct rte_denoise {
+	// Planar so a row of pixels loads straight into SIMD lanes, see denoise.c for the order
+	real_t* planes;
+
+	unsigned int width;
+	unsigned int height;
+} rte_denoise_t;
+
+// Allocates the buffers for frames of the given size, returns 0 on failure
+extern int denoise_init(rte_denoise_t* denoise, unsigned int width, unsigned int height);
+extern void denoise_free(rte_denoise_t* denoise);
+
+// Traces the primary ray through every pixel center for its normal, albedo and depth on the shared pool
+// Mirrors are followed up to the scene's bounces, their pixels are guided by what they reflect
+// The camera viewport has to match the size the buffers were made for
+extern void denoise_trace_guides(rte_denoise_t* denoise, const trace_t trace);
+
+// Filters row-major colors in place on the shared pool, using the guides traced last
+// Colors are expected ready to display (like trace_pixel_block leaves them) and are saturated again once filtered
+extern void denoise_filter(rte_denoise_t* denoise, rvec3_t* colors, int passes);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif //RTEVERYWHERE_DENOISE_H
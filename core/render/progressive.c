@@ -0,0 +1,59 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#include "progressive.h"
+
+unsigned int rte_progressive_stride(int level) {
+	if (level < 0) {
+		level = 0;
+	}
+
+	if (level >= RTE_PROGRESSIVE_LEVELS) {
+		level = RTE_PROGRESSIVE_LEVELS - 1;
+	}
+
+	return RTE_PROGRESSIVE_MAX_STRIDE >> level;
+}
+
+void trace_tile_progressive(rvec3_t* frame, unsigned int frame_width, const trace_t trace, rte_tile_t tile, int level) {
+	unsigned int stride = rte_progressive_stride(level);
+	unsigned int coarse = stride * 2;
+
+	unsigned int end_x = tile.x + tile.width;
+	unsigned int end_y = tile.y + tile.height;
+
+	trace_t pixel_trace = trace;
+
+	// Origins are aligned, so the first pixel of the tile is always on the grid
+	for (unsigned int y = tile.y; y < end_y; y += stride) {
+		for (unsigned int x = tile.x; x < end_x; x += stride) {
+			// Already traced by a coarser level
+			if (level > 0 && x % coarse == 0 && y % coarse == 0) {
+				continue;
+			}
+
+			pixel_trace.point.x = x;
+			pixel_trace.point.y = y;
+
+			trace_pixel(RVEC_OUT(frame[y * frame_width + x]), pixel_trace);
+		}
+	}
+
+	if (stride == 1) {
+		return;
+	}
+
+	// Nearest fill, every traced pixel covers the stride x stride block below and to the right of it
+	for (unsigned int y = tile.y; y < end_y; y++) {
+		unsigned int anchor_y = y - y % stride;
+
+		for (unsigned int x = tile.x; x < end_x; x++) {
+			unsigned int anchor_x = x - x % stride;
+
+			if (anchor_x != x || anchor_y != y) {
+				rvec3_copy(RVEC_OUT(frame[y * frame_width + x]), frame[anchor_y * frame_width + anchor_x]);
+			}
+		}
+	}
+}
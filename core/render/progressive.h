@@ -0,0 +1,35 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#ifndef RTEVERYWHERE_PROGRESSIVE_H
+#define RTEVERYWHERE_PROGRESSIVE_H
+
+#include "../rt_everywhere.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Coarse to fine rendering
+// Level 0 traces every 8th pixel in both directions (1/64 of the frame), each following level halves the stride
+// A level only traces the pixels no coarser level already traced, then fills every pixel from the nearest traced one,
+// so after any level the frame is complete and presentable and the last level matches a plain render
+//
+
+#define RTE_PROGRESSIVE_LEVELS 4
+#define RTE_PROGRESSIVE_MAX_STRIDE 8
+
+// Distance between traced pixels once the level completes, 8 at level 0 down to 1 at the last level
+extern unsigned int rte_progressive_stride(int level);
+
+// Advances the tile of a frame_width wide, row-major frame to the given level
+// Levels must be run in order over the whole frame, tile origins must be multiples of RTE_PROGRESSIVE_MAX_STRIDE
+extern void trace_tile_progressive(rvec3_t* frame, unsigned int frame_width, const trace_t trace, rte_tile_t tile, int level);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif //RTEVERYWHERE_PROGRESSIVE_H
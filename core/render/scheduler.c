@@ -0,0 +1,212 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#include "scheduler.h"
+
+#include <stdlib.h>
+
+int rte_scheduler_init(rte_scheduler_t* scheduler, unsigned int width, unsigned int height, unsigned int tile_size, int worker_count) {
+	scheduler->tiles = NULL;
+	scheduler->tile_count = 0;
+	scheduler->deques = NULL;
+	scheduler->worker_count = 0;
+	scheduler->steals = 0;
+	scheduler->cancelled = 0;
+
+	if (tile_size == 0 || worker_count < 1) {
+		return 0;
+	}
+
+	unsigned int tiles_x = (width + tile_size - 1) / tile_size;
+	unsigned int tiles_y = (height + tile_size - 1) / tile_size;
+	int tile_count = (int)(tiles_x * tiles_y);
+
+	scheduler->tiles = (rte_tile_t*)malloc(sizeof(rte_tile_t) * (tile_count > 0 ? tile_count : 1));
+	scheduler->deques = (rte_tile_deque_t*)calloc(worker_count, sizeof(rte_tile_deque_t));
+
+	if (scheduler->tiles == NULL || scheduler->deques == NULL) {
+		rte_scheduler_free(scheduler);
+		return 0;
+	}
+
+	scheduler->worker_count = worker_count;
+
+	for (int w = 0; w < worker_count; w++) {
+		rte_tile_deque_t* deque = &scheduler->deques[w];
+
+		// Matches the run reset hands this worker
+		int capacity = (int)((long long)tile_count * (w + 1) / worker_count - (long long)tile_count * w / worker_count);
+
+		deque->tiles = (rte_tile_t*)malloc(sizeof(rte_tile_t) * (capacity > 0 ? capacity : 1));
+		deque->mutex = rte_mutex_create();
+
+		if (deque->tiles == NULL || deque->mutex == NULL) {
+			rte_scheduler_free(scheduler);
+			return 0;
+		}
+	}
+
+	scheduler->tile_count = tile_count;
+
+	// Tiles are kept in row-major order here, reset deals them out
+	int t = 0;
+	for (unsigned int y = 0; y < tiles_y; y++) {
+		for (unsigned int x = 0; x < tiles_x; x++) {
+			rte_tile_t* tile = &scheduler->tiles[t++];
+
+			tile->x = x * tile_size;
+			tile->y = y * tile_size;
+			tile->width = width - tile->x < tile_size ? width - tile->x : tile_size;
+			tile->height = height - tile->y < tile_size ? height - tile->y : tile_size;
+		}
+	}
+
+	rte_scheduler_reset(scheduler);
+	return 1;
+}
+
+void rte_scheduler_free(rte_scheduler_t* scheduler) {
+	if (scheduler->deques != NULL) {
+		for (int w = 0; w < scheduler->worker_count; w++) {
+			if (scheduler->deques[w].mutex != NULL) {
+				rte_mutex_destroy(scheduler->deques[w].mutex);
+			}
+
+			free(scheduler->deques[w].tiles);
+		}
+	}
+
+	free(scheduler->deques);
+	free(scheduler->tiles);
+
+	scheduler->tiles = NULL;
+	scheduler->tile_count = 0;
+	scheduler->deques = NULL;
+	scheduler->worker_count = 0;
+}
+
+void rte_scheduler_reset(rte_scheduler_t* scheduler) {
+	int count = scheduler->tile_count;
+	int workers = scheduler->worker_count;
+
+	scheduler->steals = 0;
+	rte_atomic_store(&scheduler->cancelled, 0);
+
+	for (int w = 0; w < workers; w++) {
+		rte_tile_deque_t* deque = &scheduler->deques[w];
+
+		// Each worker gets a contiguous run of tiles, neighbouring tiles share most of their BVH nodes
+		int begin = (int)((long long)count * w / workers);
+		int end = (int)((long long)count * (w + 1) / workers);
+
+		// Stored back to front so the owner, popping from the bottom, walks its run in row-major order
+		for (int t = begin; t < end; t++) {
+			deque->tiles[end - 1 - t] = scheduler->tiles[t];
+		}
+
+		deque->top = 0;
+		deque->bottom = end - begin;
+	}
+}
+
+int rte_scheduler_next(rte_scheduler_t* scheduler, int worker, rte_tile_t* p_tile) {
+	int workers = scheduler->worker_count;
+
+	if (workers == 0 || rte_atomic_load(&scheduler->cancelled)) {
+		return 0;
+	}
+
+	rte_tile_deque_t* own = &scheduler->deques[worker % workers];
+
+	rte_mutex_lock(own->mutex);
+
+	if (own->bottom > own->top) {
+		*p_tile = own->tiles[--own->bottom];
+		rte_mutex_unlock(own->mutex);
+
+		return 1;
+	}
+
+	rte_mutex_unlock(own->mutex);
+
+	// Steal from the far end of the other deques, those are the tiles their owners would get to last
+	for (int v = 1; v < workers; v++) {
+		rte_tile_deque_t* victim = &scheduler->deques[(worker + v) % workers];
+
+		rte_mutex_lock(victim->mutex);
+
+		if (victim->bottom > victim->top) {
+			*p_tile = victim->tiles[victim->top++];
+			rte_mutex_unlock(victim->mutex);
+
+			rte_atomic_add(&scheduler->steals, 1);
+			return 1;
+		}
+
+		rte_mutex_unlock(victim->mutex);
+	}
+
+	return 0;
+}
+
+void rte_scheduler_cancel(rte_scheduler_t* scheduler) {
+	rte_atomic_store(&scheduler->cancelled, 1);
+}
+
+int rte_scheduler_cancelled(rte_scheduler_t* scheduler) {
+	return rte_atomic_load(&scheduler->cancelled);
+}
+
+//
+// Blocking run
+//
+typedef struct rte_scheduler_work {
+	rte_scheduler_t* scheduler;
+	rte_tile_func_t func;
+	void* user;
+} rte_scheduler_work_t;
+
+static void rte_scheduler_worker(void* data, int index) {
+	rte_scheduler_work_t* work = (rte_scheduler_work_t*)data;
+	rte_tile_t tile;
+
+	while (rte_scheduler_next(work->scheduler, index, &tile)) {
+		work->func(work->user, index, tile);
+	}
+}
+
+// Pool runs are offset by one, worker 0 is the caller
+static void rte_scheduler_helper(void* data, int index) {
+	rte_scheduler_worker(data, index + 1);
+}
+
+void rte_scheduler_run(rte_scheduler_t* scheduler, rte_tile_func_t func, void* user) {
+	rte_scheduler_run_pool(scheduler, rte_pool_shared(), func, user);
+}
+
+void rte_scheduler_run_pool(rte_scheduler_t* scheduler, rte_pool_t* pool, rte_tile_func_t func, void* user) {
+	if (scheduler->worker_count == 0) {
+		return;
+	}
+
+	rte_scheduler_work_t work;
+	work.scheduler = scheduler;
+	work.func = func;
+	work.user = user;
+
+	int helpers = scheduler->worker_count - 1;
+
+	// Without a pool the caller steals every other deque empty by itself
+	rte_job_t job;
+
+	if (pool != NULL && helpers > 0) {
+		rte_pool_submit(pool, &job, rte_scheduler_helper, &work, helpers);
+	}
+
+	rte_scheduler_worker(&work, 0);
+
+	if (pool != NULL && helpers > 0) {
+		rte_job_wait(&job);
+	}
+}
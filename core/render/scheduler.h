@@ -0,0 +1,71 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#ifndef RTEVERYWHERE_SCHEDULER_H
+#define RTEVERYWHERE_SCHEDULER_H
+
+#include "../rt_everywhere.h"
+#include "../threading/thread.h"
+#include "../threading/pool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Tile scheduler
+// The frame is cut into small tiles, each worker starts with a contiguous run of them in its own deque
+// Workers pop from the bottom of their own deque and steal from the top of someone else's once it runs dry,
+// so expensive regions of the frame get shared out instead of holding up a single worker
+//
+
+typedef struct rte_tile_deque {
+	rte_tile_t* tiles;
+	int top;    // Next tile a thief takes
+	int bottom; // One past the next tile the owner takes
+	rte_mutex_t* mutex;
+} rte_tile_deque_t;
+
+typedef struct rte_scheduler {
+	rte_tile_t* tiles;
+	int tile_count;
+
+	rte_tile_deque_t* deques;
+	int worker_count;
+
+	volatile int steals;
+	volatile int cancelled;
+} rte_scheduler_t;
+
+// Worker is the index of the calling worker, in [0, worker_count)
+typedef void (*rte_tile_func_t)(void* user, int worker, rte_tile_t tile);
+
+// Cuts a width x height frame into tile_size tiles and deals them out to worker_count deques, returns 0 on failure
+extern int rte_scheduler_init(rte_scheduler_t* scheduler, unsigned int width, unsigned int height, unsigned int tile_size, int worker_count);
+extern void rte_scheduler_free(rte_scheduler_t* scheduler);
+
+// Deals every tile out again so the same frame can be rendered once more, no worker may be running
+// Also clears a cancel, so cancel, wait for the workers, reset and submit restarts a frame with new parameters
+extern void rte_scheduler_reset(rte_scheduler_t* scheduler);
+
+// Stops handing out tiles, tiles already being rendered still finish. Safe to call from any thread
+// Stale work is therefore dropped within a tile's worth of time
+extern void rte_scheduler_cancel(rte_scheduler_t* scheduler);
+extern int rte_scheduler_cancelled(rte_scheduler_t* scheduler);
+
+// Hands the worker its next tile, stealing one if its own deque is empty
+// Returns 0 once every deque is empty or the scheduler was cancelled, safe to call from any number of threads
+extern int rte_scheduler_next(rte_scheduler_t* scheduler, int worker, rte_tile_t* p_tile);
+
+// Runs func over every tile on the shared pool with worker_count workers, the caller included, and returns once all tiles are done
+extern void rte_scheduler_run(rte_scheduler_t* scheduler, rte_tile_func_t func, void* user);
+
+// Same as rte_scheduler_run on a pool of the caller's choosing, NULL runs every worker on the calling thread
+extern void rte_scheduler_run_pool(rte_scheduler_t* scheduler, rte_pool_t* pool, rte_tile_func_t func, void* user);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif //RTEVERYWHERE_SCHEDULER_H
@@ -0,0 +1,228 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#include "temporal.h"
+
+#include "../accel/packet.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEMPORAL_BATCH (PACKET_SIZE * 4)
+
+// History is kept when its depth is within this fraction of where the new hit was seen from the last camera
+#define TEMPORAL_DEPTH_TOLERANCE REAL(0.1)
+
+int temporal_init(rte_temporal_t* temporal, unsigned int width, unsigned int height) {
+	memset(temporal, 0, sizeof(rte_temporal_t));
+
+	size_t pixels = (size_t)width * height;
+
+	temporal->colors = (rvec3_t*)malloc(sizeof(rvec3_t) * pixels);
+	temporal->depths = (real_t*)malloc(sizeof(real_t) * pixels);
+	temporal->lengths = (int*)malloc(sizeof(int) * pixels);
+	temporal->history_colors = (rvec3_t*)malloc(sizeof(rvec3_t) * pixels);
+	temporal->history_depths = (real_t*)malloc(sizeof(real_t) * pixels);
+	temporal->history_lengths = (int*)malloc(sizeof(int) * pixels);
+
+	temporal->width = width;
+	temporal->height = height;
+
+	if (temporal->colors == NULL || temporal->depths == NULL || temporal->lengths == NULL
+		|| temporal->history_colors == NULL || temporal->history_depths == NULL || temporal->history_lengths == NULL) {
+		temporal_free(temporal);
+		return 0;
+	}
+
+	return 1;
+}
+
+void temporal_free(rte_temporal_t* temporal) {
+	free(temporal->colors);
+	free(temporal->depths);
+	free(temporal->lengths);
+	free(temporal->history_colors);
+	free(temporal->history_depths);
+	free(temporal->history_lengths);
+
+	memset(temporal, 0, sizeof(rte_temporal_t));
+}
+
+void temporal_reset(rte_temporal_t* temporal) {
+	temporal->frame = 0;
+}
+
+// Bilinear fetch of the last frame that skips every texel at the wrong depth, returns 0 if none of them fit
+static int temporal_fetch(const rte_temporal_t* temporal, rvec3_out_t dst_col, int* p_length, real_t x, real_t y, real_t expected_depth) {
+	// Texel centers sit at + 0.5
+	real_t fx = x - REAL(0.5);
+	real_t fy = y - REAL(0.5);
+
+	real_t base_x = (real_t)floor(fx);
+	real_t base_y = (real_t)floor(fy);
+
+	real_t weight_x = fx - base_x;
+	real_t weight_y = fy - base_y;
+
+	rvec3_copy(dst_col, (rvec3_t) {0, 0, 0});
+
+	real_t total = 0;
+	int length = RTE_TEMPORAL_MAX_HISTORY;
+
+	for (int t = 0; t < 4; t++) {
+		int tx = (int)base_x + (t & 1);
+		int ty = (int)base_y + (t >> 1);
+
+		if (tx < 0 || ty < 0 || tx >= (int)temporal->width || ty >= (int)temporal->height) {
+			continue;
+		}
+
+		size_t index = (size_t)ty * temporal->width + tx;
+		real_t depth = temporal->history_depths[index];
+
+		// The sky only ever matches the sky
+		if (expected_depth == 0 || depth == 0) {
+			if (expected_depth != depth) {
+				continue;
+			}
+		} else if ((real_t)fabs(depth - expected_depth) > expected_depth * TEMPORAL_DEPTH_TOLERANCE) {
+			continue;
+		}
+
+		real_t weight = ((t & 1) ? weight_x : REAL(1.0) - weight_x) * ((t >> 1) ? weight_y : REAL(1.0) - weight_y);
+
+		if (weight <= 0) {
+			continue;
+		}
+
+		rvec3_t texel;
+		rvec3_mul_scalar(RVEC_OUT(texel), temporal->history_colors[index], weight);
+		rvec3_add(dst_col, RVEC_OUT_DEREF(dst_col), texel);
+
+		total += weight;
+		length = temporal->history_lengths[index] < length ? temporal->history_lengths[index] : length;
+	}
+
+	// Mostly disoccluded, a sliver of history would only smear the edge it came from
+	if (total < REAL(0.25)) {
+		return 0;
+	}
+
+	rvec3_div_scalar(dst_col, RVEC_OUT_DEREF(dst_col), total);
+	*p_length = length;
+
+	return 1;
+}
+
+// Blends a new sample into whatever history of it survived
+// History is found through the ray of the pixel center, following the jittered ray would blur it a little every frame
+static void temporal_resolve(rte_temporal_t* temporal, const rte_ray_t* ray, size_t index, const rvec3_t sample, int short_history, real_t depth) {
+	rvec3_t history;
+	int length = 0;
+
+	if (temporal->frame > 0) {
+		rvec3_t point;
+		real_t expected_depth = 0;
+
+		// The sky is infinitely far away, only the direction reprojects
+		if (depth > 0) {
+			rvec3_mul_scalar(RVEC_OUT(point), ray->direction, depth);
+			rvec3_add(RVEC_OUT(point), point, ray->origin);
+
+			rvec3_t offset;
+			rvec3_sub(RVEC_OUT(offset), point, temporal->camera.position);
+			expected_depth = rvec3_length(offset);
+		} else {
+			rvec3_add(RVEC_OUT(point), temporal->camera.position, ray->direction);
+		}
+
+		real_t x, y;
+
+		if (!camera_project(&x, &y, &temporal->camera, point) || !temporal_fetch(temporal, RVEC_OUT(history), &length, x, y, expected_depth)) {
+			length = 0;
+		}
+	}
+
+	int max_length = short_history ? RTE_TEMPORAL_MIRROR_HISTORY : RTE_TEMPORAL_MAX_HISTORY;
+	length = length + 1 < max_length ? length + 1 : max_length;
+
+	if (length == 1) {
+		rvec3_copy(RVEC_OUT(temporal->colors[index]), sample);
+	} else {
+		// Running average until the history is full, an exponential one after that
+		rvec3_t delta;
+		rvec3_sub(RVEC_OUT(delta), sample, history);
+		rvec3_mul_scalar(RVEC_OUT(delta), delta, REAL(1.0) / (real_t)length);
+		rvec3_add(RVEC_OUT(temporal->colors[index]), history, delta);
+	}
+
+	temporal->depths[index] = depth;
+	temporal->lengths[index] = length;
+}
+
+void trace_tile_temporal(rte_temporal_t* temporal, rvec3_t* dst_cols, const trace_t trace, rte_tile_t tile) {
+	rte_ray_t rays[TEMPORAL_BATCH];
+	rte_ray_t centers[TEMPORAL_BATCH];
+	rvec3_t samples[TEMPORAL_BATCH];
+	int mirrors[TEMPORAL_BATCH];
+	real_t depths[TEMPORAL_BATCH];
+
+	// Every pixel shares the jitter of the frame, so consecutive frames cover the whole pixel between them
+	// The sequence restarts now and then before the frame count gets too large for the fraction to stay precise
+	real_t jitter_x;
+	real_t jitter_y;
+	camera_sample_offset(temporal->frame % 1024, &jitter_x, &jitter_y);
+
+	int moved = temporal->frame > 0 && (memcmp(temporal->camera.position, trace.camera.position, sizeof(rvec3_t)) != 0
+		|| memcmp(temporal->camera.rotation, trace.camera.rotation, sizeof(rvec3_t)) != 0);
+
+	int pixel_count = (int)(tile.width * tile.height);
+
+	for (int first = 0; first < pixel_count; first += TEMPORAL_BATCH) {
+		int count = pixel_count - first < TEMPORAL_BATCH ? pixel_count - first : TEMPORAL_BATCH;
+
+		for (int r = 0; r < count; r++) {
+			rte_point_t point;
+			point.x = tile.x + (unsigned int)(first + r) % tile.width;
+			point.y = tile.y + (unsigned int)(first + r) / tile.width;
+
+			camera_offset_ray(&rays[r], &trace.camera, point, jitter_x, jitter_y);
+			camera_offset_ray(&centers[r], &trace.camera, point, 0, 0);
+		}
+
+		trace_ray_batch(samples, mirrors, depths, rays, count, trace.scene);
+
+		for (int r = 0; r < count; r++) {
+			int p = first + r;
+			size_t index = (size_t)(tile.y + p / tile.width) * temporal->width + tile.x + p % tile.width;
+
+			temporal_resolve(temporal, &centers[r], index, samples[r], moved && mirrors[r], depths[r]);
+
+			rvec3_copy(RVEC_OUT(dst_cols[p]), temporal->colors[index]);
+
+			if (trace.tonemapping == RTE_TONEMAP_ACES)
+				tonemap_aces(RVEC_OUT(dst_cols[p]));
+
+			rvec3_saturate(RVEC_OUT(dst_cols[p]));
+		}
+	}
+}
+
+void temporal_end_frame(rte_temporal_t* temporal, const rte_camera_t* camera) {
+	rvec3_t* colors = temporal->history_colors;
+	real_t* depths = temporal->history_depths;
+	int* lengths = temporal->history_lengths;
+
+	temporal->history_colors = temporal->colors;
+	temporal->history_depths = temporal->depths;
+	temporal->history_lengths = temporal->lengths;
+
+	temporal->colors = colors;
+	temporal->depths = depths;
+	temporal->lengths = lengths;
+
+	temporal->camera = *camera;
+	temporal->frame++;
+}
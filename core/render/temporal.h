@@ -0,0 +1,61 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#ifndef RTEVERYWHERE_TEMPORAL_H
+#define RTEVERYWHERE_TEMPORAL_H
+
+#include "../rt_everywhere.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Temporal accumulation
+// Each frame traces one jittered sample per pixel and blends it into the previous frames, which are reprojected
+// into the new camera through the distance to each pixel's first hit. History that lands somewhere at a different
+// depth was disoccluded and is thrown away, so moving the camera only costs the newly revealed pixels their history
+//
+
+#define RTE_TEMPORAL_MAX_HISTORY 16
+
+// Reflections don't move with the surface they're seen on, so mirrors keep less history while the camera moves
+#define RTE_TEMPORAL_MIRROR_HISTORY 4
+
+typedef struct rte_temporal {
+	// Written by the frame being traced, swapped with the last frame once it ends
+	rvec3_t* colors;
+	real_t* depths; // 0 for the sky
+	int* lengths; // Frames blended into each color
+
+	rvec3_t* history_colors;
+	real_t* history_depths;
+	int* history_lengths;
+
+	unsigned int width;
+	unsigned int height;
+
+	rte_camera_t camera; // Of the last frame
+	int frame; // Frames since the history was reset, also picks the jitter
+} rte_temporal_t;
+
+// Allocates the buffers for frames of the given size, returns 0 on failure
+extern int temporal_init(rte_temporal_t* temporal, unsigned int width, unsigned int height);
+extern void temporal_free(rte_temporal_t* temporal);
+
+// Drops the history, needed whenever the scene changes under the camera
+extern void temporal_reset(rte_temporal_t* temporal);
+
+// Traces the tile and writes the accumulated colors row-major into dst_cols, ready to display
+// Tiles of the same frame can run in parallel, the camera viewport has to match the size the buffers were made for
+extern void trace_tile_temporal(rte_temporal_t* temporal, rvec3_t* dst_cols, const trace_t trace, rte_tile_t tile);
+
+// Call once every tile of the frame is done, the frame becomes the history of the next one
+extern void temporal_end_frame(rte_temporal_t* temporal, const rte_camera_t* camera);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif //RTEVERYWHERE_TEMPORAL_H
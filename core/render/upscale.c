@@ -0,0 +1,301 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#include "upscale.h"
+
+#include "../accel/packet.h"
+#include "../threading/thread.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define UPSCALE_BATCH (PACKET_SIZE * 4)
+
+// Depth differences are relative to the distance of the pixel, so the falloff holds up close and far away
+#define UPSCALE_DEPTH_SIGMA REAL(0.05)
+
+// Below this a pixel is treated as if none of its neighbours matched it
+#define UPSCALE_MIN_WEIGHT REAL(0.0001)
+
+typedef struct upscale_job {
+	rte_upscale_t* upscale;
+	rvec3_t* dst_cols;
+	const trace_t* trace;
+} upscale_job_t;
+
+int upscale_init(rte_upscale_t* upscale, unsigned int width, unsigned int height, int factor) {
+	memset(upscale, 0, sizeof(rte_upscale_t));
+
+	if (factor < 1) {
+		factor = 1;
+	}
+
+	if (factor > RTE_UPSCALE_MAX_FACTOR) {
+		factor = RTE_UPSCALE_MAX_FACTOR;
+	}
+
+	upscale->width = width;
+	upscale->height = height;
+	upscale->low_width = (width + factor - 1) / factor;
+	upscale->low_height = (height + factor - 1) / factor;
+	upscale->factor = factor;
+
+	upscale->guides = (rte_guide_t*)malloc(sizeof(rte_guide_t) * width * height);
+	upscale->samples = (rvec3_t*)malloc(sizeof(rvec3_t) * upscale->low_width * upscale->low_height);
+
+	if (upscale->guides == NULL || upscale->samples == NULL) {
+		upscale_free(upscale);
+		return 0;
+	}
+
+	return 1;
+}
+
+void upscale_free(rte_upscale_t* upscale) {
+	free(upscale->guides);
+	free(upscale->samples);
+
+	memset(upscale, 0, sizeof(rte_upscale_t));
+}
+
+// The shaded pixel of a block, blocks on the right and bottom edge may be cut short
+static unsigned int upscale_sample_x(const rte_upscale_t* upscale, unsigned int low_x) {
+	unsigned int x = low_x * upscale->factor + upscale->factor / 2;
+	return x < upscale->width ? x : upscale->width - 1;
+}
+
+static unsigned int upscale_sample_y(const rte_upscale_t* upscale, unsigned int low_y) {
+	unsigned int y = low_y * upscale->factor + upscale->factor / 2;
+	return y < upscale->height ? y : upscale->height - 1;
+}
+
+//
+// Guide pass
+// Primary rays only, no shading, shadows or reflections
+//
+static void upscale_guide_rows(void* user, int begin, int end) {
+	upscale_job_t* job = (upscale_job_t*)user;
+	rte_upscale_t* upscale = job->upscale;
+
+	rte_ray_t rays[UPSCALE_BATCH];
+	rte_fragment_t frags[UPSCALE_BATCH];
+	int hits[UPSCALE_BATCH];
+
+	for (int y = begin; y < end; y++) {
+		for (unsigned int first = 0; first < upscale->width; first += UPSCALE_BATCH) {
+			int count = upscale->width - first < UPSCALE_BATCH ? (int)(upscale->width - first) : UPSCALE_BATCH;
+
+			for (int r = 0; r < count; r++) {
+				rte_point_t point;
+				point.x = first + r;
+				point.y = y;
+
+				camera_offset_ray(&rays[r], &job->trace->camera, point, 0, 0);
+			}
+
+			trace_scene_packet(frags, hits, rays, count, job->trace->scene);
+
+			for (int r = 0; r < count; r++) {
+				rte_guide_t* guide = &upscale->guides[(size_t)y * upscale->width + first + r];
+
+				if (!hits[r]) {
+					rvec3_copy(RVEC_OUT(guide->normal), (rvec3_t) {0, 0, 0});
+					guide->depth = 0;
+					guide->primitive_id = RTE_PRIMITIVE_NONE;
+					continue;
+				}
+
+				rvec3_t offset;
+				rvec3_sub(RVEC_OUT(offset), frags[r].position, rays[r].origin);
+
+				rvec3_copy(RVEC_OUT(guide->normal), frags[r].normal);
+				guide->depth = rvec3_length(offset);
+				guide->primitive_id = frags[r].primitive_id;
+			}
+		}
+	}
+}
+
+//
+// Shading pass
+//
+static void upscale_sample_rows(void* user, int begin, int end) {
+	upscale_job_t* job = (upscale_job_t*)user;
+	rte_upscale_t* upscale = job->upscale;
+
+	rte_ray_t rays[UPSCALE_BATCH];
+
+	for (int low_y = begin; low_y < end; low_y++) {
+		for (unsigned int first = 0; first < upscale->low_width; first += UPSCALE_BATCH) {
+			int count = upscale->low_width - first < UPSCALE_BATCH ? (int)(upscale->low_width - first) : UPSCALE_BATCH;
+
+			for (int r = 0; r < count; r++) {
+				rte_point_t point;
+				point.x = upscale_sample_x(upscale, first + r);
+				point.y = upscale_sample_y(upscale, low_y);
+
+				camera_offset_ray(&rays[r], &job->trace->camera, point, 0, 0);
+			}
+
+			trace_ray_batch(&upscale->samples[(size_t)low_y * upscale->low_width + first], NULL, NULL, rays, count, job->trace->scene);
+		}
+	}
+}
+
+// How much a shaded pixel's guide says about another pixel, 0 when they're on different surfaces
+static real_t upscale_guide_weight(const rte_guide_t* pixel, const rte_guide_t* sample) {
+	if (pixel->primitive_id != sample->primitive_id) {
+		return 0;
+	}
+
+	// Both are the sky
+	if (pixel->depth == 0) {
+		return 1;
+	}
+
+	real_t difference = (sample->depth - pixel->depth) / (pixel->depth * UPSCALE_DEPTH_SIGMA);
+	real_t facing = rvec3_dot(pixel->normal, sample->normal);
+
+	if (facing <= 0) {
+		return 0;
+	}
+
+	// Raised to the 8th power, creases fall off quickly but curved surfaces still blend
+	facing *= facing;
+	facing *= facing;
+	facing *= facing;
+
+	return facing * (real_t)exp(-REAL(0.5) * difference * difference);
+}
+
+// Shades the pixels of a row that couldn't be rebuilt, owners holds their x
+static void upscale_fixup(upscale_job_t* job, int y, const rte_ray_t* rays, const unsigned int* owners, int count) {
+	rvec3_t colors[UPSCALE_BATCH];
+
+	trace_ray_batch(colors, NULL, NULL, rays, count, job->trace->scene);
+
+	for (int r = 0; r < count; r++) {
+		rvec3_copy(RVEC_OUT(job->dst_cols[(size_t)y * job->upscale->width + owners[r]]), colors[r]);
+	}
+}
+
+//
+// Reconstruction pass
+//
+static void upscale_resolve_rows(void* user, int begin, int end) {
+	upscale_job_t* job = (upscale_job_t*)user;
+	rte_upscale_t* upscale = job->upscale;
+
+	int factor = upscale->factor;
+	real_t radius = (real_t)(factor * 2);
+
+	rte_ray_t rays[UPSCALE_BATCH];
+	unsigned int owners[UPSCALE_BATCH];
+
+	for (int y = begin; y < end; y++) {
+		int pending = 0;
+		int fixups = 0;
+
+		int low_y = y / factor;
+
+		for (unsigned int x = 0; x < upscale->width; x++) {
+			size_t index = (size_t)y * upscale->width + x;
+			const rte_guide_t* guide = &upscale->guides[index];
+
+			int low_x = (int)x / factor;
+
+			rvec3_t sum = {0, 0, 0};
+			real_t total = 0;
+
+			// The block the pixel is in and the ones around it, anything further falls outside the tent anyway
+			for (int sy = low_y - 1; sy <= low_y + 1; sy++) {
+				if (sy < 0 || sy >= (int)upscale->low_height) {
+					continue;
+				}
+
+				unsigned int sample_y = upscale_sample_y(upscale, sy);
+				real_t weight_y = REAL(1.0) - (real_t)abs((int)sample_y - y) / radius;
+
+				for (int sx = low_x - 1; sx <= low_x + 1; sx++) {
+					if (sx < 0 || sx >= (int)upscale->low_width) {
+						continue;
+					}
+
+					unsigned int sample_x = upscale_sample_x(upscale, sx);
+					real_t weight_x = REAL(1.0) - (real_t)abs((int)sample_x - (int)x) / radius;
+
+					if (weight_x <= 0 || weight_y <= 0) {
+						continue;
+					}
+
+					const rte_guide_t* sample_guide = &upscale->guides[(size_t)sample_y * upscale->width + sample_x];
+					real_t weight = weight_x * weight_y * upscale_guide_weight(guide, sample_guide);
+
+					if (weight <= 0) {
+						continue;
+					}
+
+					rvec3_t color;
+					rvec3_mul_scalar(RVEC_OUT(color), upscale->samples[(size_t)sy * upscale->low_width + sx], weight);
+					rvec3_add(RVEC_OUT(sum), sum, color);
+
+					total += weight;
+				}
+			}
+
+			if (total >= UPSCALE_MIN_WEIGHT) {
+				rvec3_div_scalar(RVEC_OUT(job->dst_cols[index]), sum, total);
+				continue;
+			}
+
+			// Nothing shaded nearby is on the same surface, so it gets a sample of its own
+			rte_point_t point;
+			point.x = x;
+			point.y = y;
+
+			camera_offset_ray(&rays[pending], &job->trace->camera, point, 0, 0);
+			owners[pending] = x;
+			pending++;
+
+			if (pending == UPSCALE_BATCH) {
+				upscale_fixup(job, y, rays, owners, pending);
+
+				fixups += pending;
+				pending = 0;
+			}
+		}
+
+		if (pending > 0) {
+			upscale_fixup(job, y, rays, owners, pending);
+			fixups += pending;
+		}
+
+		if (fixups > 0) {
+			rte_atomic_add(&upscale->shaded, fixups);
+		}
+
+		for (unsigned int x = 0; x < upscale->width; x++) {
+			size_t index = (size_t)y * upscale->width + x;
+
+			if (job->trace->tonemapping == RTE_TONEMAP_ACES)
+				tonemap_aces(RVEC_OUT(job->dst_cols[index]));
+
+			rvec3_saturate(RVEC_OUT(job->dst_cols[index]));
+		}
+	}
+}
+
+void trace_frame_upscaled(rte_upscale_t* upscale, rvec3_t* dst_cols, const trace_t trace) {
+	upscale_job_t job;
+	job.upscale = upscale;
+	job.dst_cols = dst_cols;
+	job.trace = &trace;
+
+	upscale->shaded = (int)(upscale->low_width * upscale->low_height);
+
+	rte_parallel_for((int)upscale->height, 1, upscale_guide_rows, &job);
+	rte_parallel_for((int)upscale->low_height, 1, upscale_sample_rows, &job);
+	rte_parallel_for((int)upscale->height, 1, upscale_resolve_rows, &job);
+}
@@ -0,0 +1,55 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#ifndef RTEVERYWHERE_UPSCALE_H
+#define RTEVERYWHERE_UPSCALE_H
+
+#include "../rt_everywhere.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Edge-aware upscaling
+// Only one pixel out of every factor x factor block is shaded, every pixel still gets a primary ray for its guide
+// (what it hit, how far away and which way that faces). Each pixel is then rebuilt from the shaded pixels around it,
+// weighted by distance and by how well their guides agree with its own (joint bilateral upsampling), so colors don't
+// bleed over silhouettes. Pixels that no shaded neighbour agrees with, like thin objects, are shaded on their own
+//
+
+#define RTE_UPSCALE_MAX_FACTOR 4
+
+typedef struct rte_guide {
+	rvec3_t normal;
+	real_t depth; // 0 for the sky
+	int primitive_id;
+} rte_guide_t;
+
+typedef struct rte_upscale {
+	rte_guide_t* guides; // One per pixel
+	rvec3_t* samples; // Linear colors of the shaded pixels, one per block
+
+	unsigned int width;
+	unsigned int height;
+	unsigned int low_width;
+	unsigned int low_height;
+	int factor;
+
+	volatile int shaded; // Pixels shaded by the last frame, blocks plus the ones nothing matched
+} rte_upscale_t;
+
+// Allocates the buffers for frames of the given size shaded at 1 / (factor * factor) of the pixels, returns 0 on failure
+extern int upscale_init(rte_upscale_t* upscale, unsigned int width, unsigned int height, int factor);
+extern void upscale_free(rte_upscale_t* upscale);
+
+// Traces the whole frame on the shared pool and writes it row-major into dst_cols, ready to display
+// The camera viewport has to match the size the buffers were made for
+extern void trace_frame_upscaled(rte_upscale_t* upscale, rvec3_t* dst_cols, const trace_t trace);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif //RTEVERYWHERE_UPSCALE_H
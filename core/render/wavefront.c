@@ -0,0 +1,294 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#include "wavefront.h"
+
+#include "../accel/packet.h"
+
+#include <stdlib.h>
+
+#define WAVEFRONT_MAX_SAMPLES 4
+
+// Sort keys are 16 bits, octant (3) | direction cell (4) | origin morton cell (9)
+#define WAVEFRONT_ORIGIN_CELLS 8
+#define WAVEFRONT_DIRECTION_CELLS 4
+
+#define WAVEFRONT_RADIX_BITS 8
+#define WAVEFRONT_RADIX_BUCKETS (1 << WAVEFRONT_RADIX_BITS)
+
+int wavefront_init(rte_wavefront_t* wavefront, int max_pixels) {
+	int capacity = max_pixels * WAVEFRONT_MAX_SAMPLES;
+
+	wavefront->capacity = capacity;
+
+	wavefront->queue = (rte_wavefront_ray_t*)malloc(sizeof(rte_wavefront_ray_t) * capacity);
+	wavefront->scratch = (rte_wavefront_ray_t*)malloc(sizeof(rte_wavefront_ray_t) * capacity);
+	wavefront->fragments = (rte_fragment_t*)malloc(sizeof(rte_fragment_t) * capacity);
+	wavefront->hits = (int*)malloc(sizeof(int) * capacity);
+	wavefront->paths = (rte_wavefront_path_t*)malloc(sizeof(rte_wavefront_path_t) * capacity);
+
+	if (wavefront->queue == NULL || wavefront->scratch == NULL || wavefront->fragments == NULL || wavefront->hits == NULL || wavefront->paths == NULL) {
+		wavefront_free(wavefront);
+		return 0;
+	}
+
+	return 1;
+}
+
+void wavefront_free(rte_wavefront_t* wavefront) {
+	free(wavefront->queue);
+	free(wavefront->scratch);
+	free(wavefront->fragments);
+	free(wavefront->hits);
+	free(wavefront->paths);
+
+	wavefront->queue = NULL;
+	wavefront->scratch = NULL;
+	wavefront->fragments = NULL;
+	wavefront->hits = NULL;
+	wavefront->paths = NULL;
+	wavefront->capacity = 0;
+}
+
+//
+// Sorting
+//
+static unsigned int wavefront_quantize(real_t value, real_t min, real_t extent, unsigned int cells) {
+	if (extent <= REAL(0.0)) {
+		return 0;
+	}
+
+	int cell = (int)((value - min) / extent * (real_t)cells);
+
+	if (cell < 0) {
+		return 0;
+	}
+
+	if (cell >= (int)cells) {
+		return cells - 1;
+	}
+
+	return (unsigned int)cell;
+}
+
+static unsigned int wavefront_part_bits(unsigned int v) {
+	// Spreads 3 bits out so they can be interleaved with the other two axes
+	return (v & 1) | ((v & 2) << 2) | ((v & 4) << 4);
+}
+
+static void wavefront_compute_keys(rte_wavefront_ray_t* queue, int count) {
+	rte_aabb_t bounds;
+	aabb_empty(&bounds);
+
+	for (int i = 0; i < count; i++) {
+		aabb_grow_point(&bounds, queue[i].ray.origin);
+	}
+
+	for (int i = 0; i < count; i++) {
+		const rte_ray_t* ray = &queue[i].ray;
+
+		unsigned int octant = (ray->direction[0] < 0) | ((ray->direction[1] < 0) << 1) | ((ray->direction[2] < 0) << 2);
+
+		unsigned int dir_x = wavefront_quantize(real_max(ray->direction[0], -ray->direction[0]), REAL(0.0), REAL(1.0), WAVEFRONT_DIRECTION_CELLS);
+		unsigned int dir_y = wavefront_quantize(real_max(ray->direction[1], -ray->direction[1]), REAL(0.0), REAL(1.0), WAVEFRONT_DIRECTION_CELLS);
+
+		unsigned int morton = 0;
+
+		for (int a = 0; a < 3; a++) {
+			unsigned int cell = wavefront_quantize(ray->origin[a], bounds.min[a], bounds.max[a] - bounds.min[a], WAVEFRONT_ORIGIN_CELLS);
+			morton |= wavefront_part_bits(cell) << a;
+		}
+
+		queue[i].key = (octant << 13) | (dir_x << 11) | (dir_y << 9) | morton;
+	}
+}
+
+// Two pass LSD radix sort on the 16 bit keys, stable so equal keys keep their pixel order
+static void wavefront_sort(rte_wavefront_t* wavefront, int count) {
+	rte_wavefront_ray_t* src = wavefront->queue;
+	rte_wavefront_ray_t* dst = wavefront->scratch;
+
+	for (int shift = 0; shift < 16; shift += WAVEFRONT_RADIX_BITS) {
+		int offsets[WAVEFRONT_RADIX_BUCKETS] = {0};
+
+		for (int i = 0; i < count; i++) {
+			offsets[(src[i].key >> shift) & (WAVEFRONT_RADIX_BUCKETS - 1)]++;
+		}
+
+		int sum = 0;
+		for (int b = 0; b < WAVEFRONT_RADIX_BUCKETS; b++) {
+			int bucket = offsets[b];
+			offsets[b] = sum;
+			sum += bucket;
+		}
+
+		for (int i = 0; i < count; i++) {
+			dst[offsets[(src[i].key >> shift) & (WAVEFRONT_RADIX_BUCKETS - 1)]++] = src[i];
+		}
+
+		rte_wavefront_ray_t* swap = src;
+		src = dst;
+		dst = swap;
+	}
+
+	// An even number of passes leaves the result back in the queue
+}
+
+//
+// Integrator
+//
+static void wavefront_intersect(rte_wavefront_t* wavefront, int count, const rte_scene_t scene) {
+	for (int first = 0; first < count; first += PACKET_SIZE) {
+		int lanes = count - first < PACKET_SIZE ? count - first : PACKET_SIZE;
+
+		rte_ray_t rays[PACKET_SIZE];
+
+		for (int l = 0; l < lanes; l++) {
+			rays[l] = wavefront->queue[first + l].ray;
+		}
+
+		trace_scene_packet(&wavefront->fragments[first], &wavefront->hits[first], rays, lanes, scene);
+	}
+}
+
+void trace_tile_wavefront(rte_wavefront_t* wavefront, rvec3_t* dst_cols, const trace_t trace, rte_tile_t tile) {
+	int samples = camera_sample_count(&trace.camera);
+	int rows_per_pass = wavefront->capacity / (samples * (int)tile.width);
+
+	// Split tiles that don't fit into horizontal bands
+	if (rows_per_pass < (int)tile.height) {
+		if (rows_per_pass < 1) {
+			return;
+		}
+
+		for (unsigned int y = 0; y < tile.height; y += rows_per_pass) {
+			rte_tile_t band = tile;
+
+			band.y = tile.y + y;
+			band.height = tile.height - y < (unsigned int)rows_per_pass ? tile.height - y : (unsigned int)rows_per_pass;
+
+			trace_tile_wavefront(wavefront, &dst_cols[y * tile.width], trace, band);
+		}
+
+		return;
+	}
+
+	int pixel_count = (int)(tile.width * tile.height);
+	int count = pixel_count * samples;
+
+	//
+	// Generate every primary ray of the tile up front
+	//
+	for (int p = 0; p < pixel_count; p++) {
+		rte_point_t point;
+		point.x = tile.x + (unsigned int)p % tile.width;
+		point.y = tile.y + (unsigned int)p / tile.width;
+
+		for (int s = 0; s < samples; s++) {
+			int path = p * samples + s;
+
+			camera_sample_ray(&wavefront->queue[path].ray, &trace.camera, point, s, samples);
+			wavefront->queue[path].path = path;
+		}
+	}
+
+	// Bounce -1 is the base pass
+	for (int bounce = -1; bounce < trace.scene.mirror_bounces && count > 0; bounce++) {
+		wavefront_intersect(wavefront, count, trace.scene);
+
+		int alive = 0;
+
+		for (int i = 0; i < count; i++) {
+			rte_wavefront_ray_t entry = wavefront->queue[i];
+			rte_wavefront_path_t* path = &wavefront->paths[entry.path];
+
+			const rte_fragment_t* frag = &wavefront->fragments[i];
+			int hit = wavefront->hits[i];
+
+			if (bounce == -1) {
+				rvec3_copy_scalar(RVEC_OUT(path->reflection), REAL(0.0));
+
+				if (!hit) {
+					shade_sky(RVEC_OUT(path->base), entry.ray);
+					continue;
+				}
+
+				shade_fragment(RVEC_OUT(path->base), *frag, entry.ray, trace.scene);
+
+				if (frag->material_type != MATERIAL_TYPE_MIRROR) {
+					continue;
+				}
+
+				rvec3_copy(RVEC_OUT(path->energy), frag->albedo);
+			} else {
+				rvec3_t local_reflection;
+				rvec3_t local_energy;
+
+				if (hit) {
+					shade_fragment(RVEC_OUT(local_reflection), *frag, entry.ray, trace.scene);
+					rvec3_copy(RVEC_OUT(local_energy), frag->albedo);
+				} else {
+					shade_sky(RVEC_OUT(local_reflection), entry.ray);
+					rvec3_copy_scalar(RVEC_OUT(local_energy), REAL(0.0));
+				}
+
+				rvec3_mul(RVEC_OUT(local_reflection), local_reflection, path->energy);
+				rvec3_add(RVEC_OUT(path->reflection), path->reflection, local_reflection);
+
+				rvec3_mul(RVEC_OUT(path->energy), path->energy, local_energy);
+
+				if (!hit) {
+					continue;
+				}
+			}
+
+			// Same cutoff as shade_sample, so both tracers stop every path at the same bounce
+			if (bounce + 1 >= trace.scene.mirror_bounces || reflection_exhausted(path->energy, trace.scene.min_energy)) {
+				continue;
+			}
+
+			// Spawn the reflected ray and compact it into the front of the queue
+			rvec3_t bias;
+			rvec3_mul_scalar(RVEC_OUT(bias), frag->normal, REAL(0.001));
+
+			rvec3_t incidence;
+			rvec3_reflect(RVEC_OUT(incidence), entry.ray.direction, frag->normal);
+			rvec3_normalize(RVEC_OUT(incidence));
+
+			rvec3_add(RVEC_OUT(entry.ray.origin), frag->position, bias);
+			rvec3_copy(RVEC_OUT(entry.ray.direction), incidence);
+
+			wavefront->queue[alive++] = entry;
+		}
+
+		count = alive;
+
+		if (count > 1) {
+			wavefront_compute_keys(wavefront->queue, count);
+			wavefront_sort(wavefront, count);
+		}
+	}
+
+	//
+	// Resolve, in sample order so the result matches trace_pixel exactly
+	//
+	for (int p = 0; p < pixel_count; p++) {
+		rvec3_copy_scalar(RVEC_OUT(dst_cols[p]), REAL(0.0));
+
+		for (int s = 0; s < samples; s++) {
+			const rte_wavefront_path_t* path = &wavefront->paths[p * samples + s];
+
+			rvec3_t sample;
+			rvec3_add(RVEC_OUT(sample), path->base, path->reflection);
+			rvec3_mul_scalar(RVEC_OUT(sample), sample, REAL(1.0) / (real_t)samples);
+
+			rvec3_add(RVEC_OUT(dst_cols[p]), dst_cols[p], sample);
+		}
+
+		if (trace.tonemapping == RTE_TONEMAP_ACES)
+			tonemap_aces(RVEC_OUT(dst_cols[p]));
+
+		rvec3_saturate(RVEC_OUT(dst_cols[p]));
+	}
+}
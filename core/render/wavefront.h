@@ -0,0 +1,55 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#ifndef RTEVERYWHERE_WAVEFRONT_H
+#define RTEVERYWHERE_WAVEFRONT_H
+
+#include "../rt_everywhere.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Breadth-first alternative to trace_pixel
+// Every path of a tile advances one bounce per pass, the rays still alive after a pass are
+// compacted and sorted by direction and origin cell so the next pass walks the BVH coherently
+//
+
+typedef struct rte_wavefront_ray {
+	rte_ray_t ray;
+	int path;
+	unsigned int key;
+} rte_wavefront_ray_t;
+
+typedef struct rte_wavefront_path {
+	rvec3_t base;
+	rvec3_t reflection;
+	rvec3_t energy;
+} rte_wavefront_path_t;
+
+typedef struct rte_wavefront {
+	rte_wavefront_ray_t* queue;
+	rte_wavefront_ray_t* scratch;
+
+	rte_fragment_t* fragments;
+	int* hits;
+
+	rte_wavefront_path_t* paths;
+
+	int capacity; // Paths per tile, i.e. pixels * samples
+} rte_wavefront_t;
+
+// Allocates queues for tiles of up to max_pixels pixels, returns 0 on failure
+extern int wavefront_init(rte_wavefront_t* wavefront, int max_pixels);
+extern void wavefront_free(rte_wavefront_t* wavefront);
+
+// Produces the same colors as trace_pixel for every pixel of the tile, written row-major into dst_cols
+extern void trace_tile_wavefront(rte_wavefront_t* wavefront, rvec3_t* dst_cols, const trace_t trace, rte_tile_t tile);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif //RTEVERYWHERE_WAVEFRONT_H
@@ -4,7 +4,10 @@
 
 #include "rt_everywhere.h"
 
+#include "accel/packet.h"
+
 #include <math.h>
+#include <stdlib.h>
 
 #define SKY_COLOR RVEC3_RGB(51, 0, 255)
 #define AMBIENT_COLOR RVEC3_RGB(44, 44, 44)
@@ -19,40 +22,54 @@
 
 #ifndef RTE_SIMPLE_SCENE
 
+#ifndef SPHERE_COUNT
 #define SPHERE_COUNT 64
+#endif
+
 #define SPHERE_SIZE_MIN REAL(0.001)
 #define SPHERE_SIZE_MAX REAL(0.3)
 
 #else
 
+#ifndef SPHERE_COUNT
 #define SPHERE_COUNT 16
+#endif
+
 #define SPHERE_SIZE_MIN REAL(0.05)
 #define SPHERE_SIZE_MAX REAL(0.5)
 
 #endif
 
+// Half the width of the square the spheres are scattered over
+#ifndef SPHERE_SPREAD
+#define SPHERE_SPREAD REAL(2.0)
+#endif
+
 #define SPHERE_Z_OFFSET REAL(2.0)
 
-int spheres_generated = 0;
-sphere_t spheres[SPHERE_COUNT];
+#define SPHERE_BVH_LEAF_SIZE 4
 
-void generate_spheres() {
-    int sphere_count = sizeof(spheres) / sizeof(sphere_t);
+// Treelet passes used by RTE_BUILDER_LBVH_TREELETS
+#define SPHERE_LBVH_TREELET_PASSES 2
+
+void generate_spheres(rte_context_t* context) {
+    sphere_t* spheres = context->spheres;
+    int sphere_count = context->sphere_count;
 
     // Generate a batch of spheres that do not intersect
     for (int s = 0; s < sphere_count; s++) {
         sphere_t sphere;
 
-        real_t red = crand_range(REAL(0.0), REAL(1.0));
-        real_t green = crand_range(REAL(0.0), REAL(1.0));
-        real_t blue = crand_range(REAL(0.0), REAL(1.0));
+        real_t red = crand_state_range(&context->rand, REAL(0.0), REAL(1.0));
+        real_t green = crand_state_range(&context->rand, REAL(0.0), REAL(1.0));
+        real_t blue = crand_state_range(&context->rand, REAL(0.0), REAL(1.0));
 
         rvec3_copy(RVEC_OUT(sphere.color), (rvec3_t){red, green, blue});
 
-        sphere.radius = crand_range(SPHERE_SIZE_MIN, SPHERE_SIZE_MAX);
+        sphere.radius = crand_state_range(&context->rand, SPHERE_SIZE_MIN, SPHERE_SIZE_MAX);
         //sphere.radius = REAL(0.1);
 
-        if (crand_range(0, 1) > 0.5) {
+        if (crand_state_range(&context->rand, 0, 1) > 0.5) {
             sphere.type = MATERIAL_TYPE_MIRROR;
         } else {
             sphere.type = MATERIAL_TYPE_PLASTIC;
@@ -64,8 +81,8 @@ void generate_spheres() {
         rvec3_t position;
 
         while (!clear) {
-            real_t x = crand_range(REAL(-2.0), REAL(2.0));
-            real_t z = crand_range(REAL(-2.0), REAL(2.0));
+            real_t x = crand_state_range(&context->rand, -SPHERE_SPREAD, SPHERE_SPREAD);
+            real_t z = crand_state_range(&context->rand, -SPHERE_SPREAD, SPHERE_SPREAD);
 
             z += SPHERE_Z_OFFSET;
 
@@ -100,6 +117,110 @@ void generate_spheres() {
     }
 }
 
+int build_sphere_bvh(rte_context_t* context) {
+    int sphere_count = context->sphere_count;
+
+    rte_aabb_t* bounds = (rte_aabb_t*)malloc(sizeof(rte_aabb_t) * sphere_count);
+
+    if (bounds == NULL) {
+        return 0;
+    }
+
+    for (int s = 0; s < sphere_count; s++) {
+        sphere_bounds(&bounds[s], &context->spheres[s]);
+    }
+
+    int built;
+
+    if (context->builder == RTE_BUILDER_SAH) {
+        built = bvh_build(&context->sphere_bvh, bounds, sphere_count, SPHERE_BVH_LEAF_SIZE);
+    } else {
+        rte_lbvh_options_t options = lbvh_default_options();
+
+        options.max_leaf_size = SPHERE_BVH_LEAF_SIZE;
+
+        if (context->builder == RTE_BUILDER_LBVH_TREELETS) {
+            options.treelet_passes = SPHERE_LBVH_TREELET_PASSES;
+        }
+
+        built = lbvh_build(&context->sphere_bvh, bounds, sphere_count, &options);
+    }
+
+    free(bounds);
+
+    if (!built) {
+        return 0;
+    }
+
+    // The SoA copy follows the BVH order so every leaf is a contiguous run of slots
+    if (!sphere_set_build(&context->sphere_set, context->spheres, context->sphere_bvh.indices, context->sphere_bvh.index_count)) {
+        return 0;
+    }
+
+    return qbvh_build(&context->sphere_qbvh, &context->sphere_bvh);
+}
+
+//
+// Context
+//
+void rte_context_init(rte_context_t* context) {
+    context->seed = CRAND_DEFAULT_SEED;
+    context->builder = RTE_BUILDER_SAH;
+    context->sphere_count = SPHERE_COUNT;
+
+    context->spheres = NULL;
+
+    context->sphere_bvh.nodes = NULL;
+    context->sphere_bvh.node_count = 0;
+    context->sphere_bvh.indices = NULL;
+    context->sphere_bvh.index_count = 0;
+
+    context->sphere_qbvh.nodes = NULL;
+    context->sphere_qbvh.node_count = 0;
+    context->sphere_qbvh.block = NULL;
+
+    context->sphere_set.center_x = NULL;
+    context->sphere_set.count = 0;
+    context->sphere_set.capacity = 0;
+
+    crand_state_seed(&context->rand, context->seed);
+    context->built = 0;
+}
+
+void rte_context_free(rte_context_t* context) {
+    free(context->spheres);
+
+    bvh_free(&context->sphere_bvh);
+    qbvh_free(&context->sphere_qbvh);
+    sphere_set_free(&context->sphere_set);
+
+    context->spheres = NULL;
+    context->built = 0;
+}
+
+int rte_context_build(rte_context_t* context) {
+    rte_context_free(context);
+
+    context->spheres = (sphere_t*)malloc(sizeof(sphere_t) * context->sphere_count);
+
+    if (context->spheres == NULL) {
+        return 0;
+    }
+
+    // Reseeding every build keeps a context's scene a pure function of its settings
+    crand_state_seed(&context->rand, context->seed);
+
+    generate_spheres(context);
+
+    if (!build_sphere_bvh(context)) {
+        rte_context_free(context);
+        return 0;
+    }
+
+    context->built = 1;
+    return 1;
+}
+
 void screen_to_viewport(rvec2_out_t dst, rte_viewport_t viewport, rte_point_t point) {
 	// Note: When x == 0, x / width = 0, but x never hits width
 	// Therefore we must add half the texel size to x to account for this
@@ -156,9 +277,125 @@ rte_camera_t rte_default_camera(rte_viewport_t viewport) {
 	return rte_setup_camera(viewport, origin, (rvec3_t) {pitch, -yaw, 0});
 }
 
-rte_scene_t rte_default_scene() {
+void camera_offset_ray(rte_ray_t* p_ray, const rte_camera_t* camera, rte_point_t point, real_t offset_x, real_t offset_y) {
+	real_t sub_tex_x = REAL(1.0) / (real_t)camera->viewport.width;
+	real_t sub_tex_y = REAL(1.0) / (real_t)camera->viewport.height;
+
+	// A pixel spans two texels of the -1 to 1 viewport
+	rvec2_t view_coord;
+	screen_to_viewport(RVEC_OUT(view_coord), camera->viewport, point);
+
+	view_coord[0] += sub_tex_x * (offset_x * REAL(2.0));
+	view_coord[1] += sub_tex_y * (offset_y * REAL(2.0));
+
+	rvec3_copy(RVEC_OUT(p_ray->direction), (rvec3_t) {view_coord[0], -view_coord[1], 1});
+
+#ifdef RTE_FLIP_Y
+	p_ray->direction[1] *= -1;
+#endif
+
+	rvec4_t pre_t;
+	rvec4_t post_t;
+
+	rvec4_copy_rvec3_w(RVEC_OUT(pre_t), p_ray->direction, REAL(1.0));
+	rmat4_mul_rvec4(RVEC_OUT(post_t), camera->mat_vp_i, pre_t);
+
+	rvec3_copy_rvec4(RVEC_OUT(p_ray->direction), post_t);
+	rvec3_normalize(RVEC_OUT(p_ray->direction));
+
+	rvec4_copy_rvec3_w(RVEC_OUT(pre_t), (rvec3_t) {0, 0, 0}, REAL(1.0));
+	rmat4_mul_rvec4(RVEC_OUT(post_t), camera->mat_v, pre_t);
+
+	rvec3_copy_rvec4(RVEC_OUT(p_ray->origin), post_t);
+}
+
+void camera_sample_ray(rte_ray_t* p_ray, const rte_camera_t* camera, rte_point_t point, int sample, int samples) {
+	real_t offset_x = 0;
+	real_t offset_y = 0;
+
+	// MSAA jitters each sample a quarter pixel towards one corner
+	if (samples == 4) {
+		offset_x = sample <= 1 ? REAL(0.25) : REAL(-0.25);
+		offset_y = sample % 2 == 0 ? REAL(0.25) : REAL(-0.25);
+	}
+
+	camera_offset_ray(p_ray, camera, point, offset_x, offset_y);
+}
+
+void camera_sample_offset(int sample, real_t* p_x, real_t* p_y) {
+	// R2 low discrepancy sequence
+	real_t x = REAL(0.5) + (real_t)sample * REAL(0.7548776662466927);
+	real_t y = REAL(0.5) + (real_t)sample * REAL(0.5698402909980532);
+
+	*p_x = x - (real_t)floor(x) - REAL(0.5);
+	*p_y = y - (real_t)floor(y) - REAL(0.5);
+}
+
+int camera_project(real_t* p_x, real_t* p_y, const rte_camera_t* camera, const rvec3_t point) {
+	// Inverts camera_offset_ray, before normalizing its direction is affine in the viewport coordinate
+	rvec4_t basis_x;
+	rvec4_t basis_y;
+	rvec4_t base;
+	rvec4_t origin;
+
+	rmat4_mul_rvec4(RVEC_OUT(basis_x), camera->mat_vp_i, (rvec4_t) {1, 0, 0, 0});
+	rmat4_mul_rvec4(RVEC_OUT(basis_y), camera->mat_vp_i, (rvec4_t) {0, 1, 0, 0});
+	rmat4_mul_rvec4(RVEC_OUT(base), camera->mat_vp_i, (rvec4_t) {0, 0, 1, 1});
+	rmat4_mul_rvec4(RVEC_OUT(origin), camera->mat_v, (rvec4_t) {0, 0, 0, 1});
+
+	rvec3_t a, b, c, r;
+	rvec3_copy_rvec4(RVEC_OUT(a), basis_x);
+	rvec3_copy_rvec4(RVEC_OUT(b), basis_y);
+	rvec3_copy_rvec4(RVEC_OUT(r), base);
+	rvec3_copy_rvec4(RVEC_OUT(c), origin);
+
+	// Solves view_x * a + view_y * b - k * (point - origin) = -base for the viewport coordinate and k
+	rvec3_sub(RVEC_OUT(c), c, point);
+	rvec3_mul_scalar(RVEC_OUT(r), r, REAL(-1.0));
+
+	rvec3_t bc, rc, br;
+	rvec3_cross(RVEC_OUT(bc), b, c);
+	rvec3_cross(RVEC_OUT(rc), r, c);
+	rvec3_cross(RVEC_OUT(br), b, r);
+
+	real_t det = rvec3_dot(a, bc);
+
+	if (det == 0) {
+		return 0;
+	}
+
+	real_t view_x = rvec3_dot(r, bc) / det;
+	real_t view_y = rvec3_dot(a, rc) / det;
+	real_t k = rvec3_dot(a, br) / det;
+
+	// Behind the camera
+	if (k <= 0) {
+		return 0;
+	}
+
+#ifndef RTE_FLIP_Y
+	view_y = -view_y;
+#endif
+
+	*p_x = (view_x + REAL(1.0)) * REAL(0.5) * (real_t)camera->viewport.width;
+	*p_y = (view_y + REAL(1.0)) * REAL(0.5) * (real_t)camera->viewport.height;
+
+	return 1;
+}
+
+int camera_sample_count(const rte_camera_t* camera) {
+	if (camera->samples == CAMERA_SAMPLES_FOUR) {
+		return 4;
+	}
+
+	return 1;
+}
+
+rte_scene_t rte_default_scene(const rte_context_t* context) {
     rte_scene_t scene;
 
+    scene.context = context;
+
     rvec3_copy(RVEC_OUT(scene.sun_light.color), RVEC3_RGB(255, 255, 255));
 
     rvec3_copy(RVEC_OUT(scene.sun_light.forward), (rvec3_t){REAL(0.5), REAL(1.0), REAL(-1.0)});
@@ -167,6 +404,13 @@ rte_scene_t rte_default_scene() {
     scene.sun_light.intensity = 1;
 
     scene.mirror_bounces = 3;
+    scene.min_energy = RTE_DEFAULT_MIN_ENERGY;
+
+    scene.accel = RTE_ACCEL_BVH;
+
+    scene.meshes = NULL;
+    scene.mesh_count = 0;
+    scene.tlas = NULL;
 
     return scene;
 }
@@ -471,79 +715,262 @@ void trace_pixel(rvec3_out_t dst_col, const trace_t trace) {
 
 #else
 
-int trace_scene(rte_fragment_t *p_fragment, const rte_ray_t ray, const rte_scene_t scene) {
-	int hit = 0;
+void ground_fragment(rte_fragment_t *p_fragment, const rte_ray_t ray, real_t ground_t) {
+	const real_t GROUND_CHECKER_SIZE = REAL(3.0);
+
+	// Position
+	rvec3_mul_scalar(RVEC_OUT(p_fragment->position), ray.direction, ground_t);
+	rvec3_add(RVEC_OUT(p_fragment->position), p_fragment->position, ray.origin);
+
+	rvec3_copy(RVEC_OUT(p_fragment->normal), (rvec3_t){0, 1, 0});
+
+	// Checkerboard pattern
+	rvec3_t checker;
+	rvec3_copy(RVEC_OUT(checker), p_fragment->position);
+
+	checker[0] = real_floor(checker[0] * GROUND_CHECKER_SIZE);
+	checker[2] = real_floor(checker[2] * GROUND_CHECKER_SIZE);
+
+	real_t mod = real_mod(checker[0] + real_mod(checker[2], REAL(2.0)), REAL(2.0));
+
+	rvec3_copy(RVEC_OUT(p_fragment->albedo), RVEC3_RGB(0, 0, 0));
 
+	if (mod) {
+		rvec3_copy(RVEC_OUT(p_fragment->albedo), RVEC3_RGB(255, 0, 137));
+	} else {
+		rvec3_copy(RVEC_OUT(p_fragment->albedo), RVEC3_RGB(5, 5, 5));
+	}
+
+	rvec3_copy(RVEC_OUT(p_fragment->glow), p_fragment->albedo);
+	rvec3_mul_scalar(RVEC_OUT(p_fragment->glow), p_fragment->glow, REAL(0.5));
+
+	// The ground is a mirror
+	p_fragment->material_type = MATERIAL_TYPE_MIRROR;
+	p_fragment->primitive_id = RTE_PRIMITIVE_GROUND;
+}
+
+void sphere_fragment(rte_fragment_t *p_fragment, const sphere_intersect_t* intersect, const sphere_t* sphere) {
+
+    rvec3_copy(RVEC_OUT(p_fragment->position), intersect->point);
+    rvec3_copy(RVEC_OUT(p_fragment->normal), intersect->normal);
+    rvec3_copy(RVEC_OUT(p_fragment->albedo), sphere->color);
+    rvec3_copy(RVEC_OUT(p_fragment->glow), RVEC3_RGB(0, 0, 0));
+
+    p_fragment->material_type = sphere->type;
+}
+
+void mesh_fragment(rte_fragment_t *p_fragment, const mesh_intersect_t* intersect, const rte_mesh_t* mesh) {
+    rvec3_copy(RVEC_OUT(p_fragment->position), intersect->point);
+    rvec3_copy(RVEC_OUT(p_fragment->normal), intersect->normal);
+    rvec3_copy(RVEC_OUT(p_fragment->albedo), mesh->albedo);
+    rvec3_copy(RVEC_OUT(p_fragment->glow), RVEC3_RGB(0, 0, 0));
+
+    p_fragment->material_type = mesh->material;
+}
+
+// Meshes always go through their own BVH, the scene accel setting only applies to the spheres
+// Writes the fragment and returns 1 if a mesh is hit closer than *p_t
+int trace_meshes(rte_fragment_t *p_fragment, const rte_ray_t* ray, real_t* p_t, const rte_scene_t* scene) {
+    int hit = 0;
+
+    for (int m = 0; m < scene->mesh_count; m++) {
+        mesh_intersect_t intersect;
+
+        if (mesh_ray_intersect(&scene->meshes[m], ray, p_t, &intersect)) {
+            mesh_fragment(p_fragment, &intersect, &scene->meshes[m]);
+            p_fragment->primitive_id = RTE_PRIMITIVE_GROUND + 1 + scene->context->sphere_count + m;
+            hit = 1;
+        }
+    }
+
+    if (scene->tlas != NULL) {
+        mesh_intersect_t intersect;
+        int instance = tlas_ray_intersect(scene->tlas, ray, p_t, &intersect);
+
+        if (instance != -1) {
+            mesh_fragment(p_fragment, &intersect, scene->tlas->instances[instance].mesh);
+            p_fragment->primitive_id = RTE_PRIMITIVE_GROUND + 1 + scene->context->sphere_count + scene->mesh_count + instance;
+            hit = 1;
+        }
+    }
+
+    return hit;
+}
+
+int trace_scene(rte_fragment_t *p_fragment, const rte_ray_t ray, const rte_scene_t scene) {
 	p_fragment->material_type = MATERIAL_TYPE_PLASTIC;
+	p_fragment->primitive_id = RTE_PRIMITIVE_NONE;
 
 	// Intersect the ground
-	const real_t GROUND_CHECKER_SIZE = REAL(3.0);
-
+	// Its surface is only evaluated if nothing closer is found
 	real_t closest_t = CAMERA_FAR;
 	real_t ground_t = -ray.origin[1] / ray.direction[1];
-	if (ground_t > 0 && ground_t < closest_t) {
+
+	int ground_hit = ground_t > 0 && ground_t < closest_t;
+
+	if (ground_hit) {
 		closest_t = ground_t;
+	}
+
+    const rte_context_t* context = scene.context;
+
+    int sphere_index = -1;
+    sphere_intersect_t sphere_intersect;
+
+    if (!context->built) {
+        // A failed build leaves no spheres behind, only the ground and meshes are hit
+    } else if (scene.accel == RTE_ACCEL_BVH || scene.accel == RTE_ACCEL_QBVH) {
+        real_t sphere_distance = closest_t;
+        int slot;
 
-		// Position
-		rvec3_mul_scalar(RVEC_OUT(p_fragment->position), ray.direction, ground_t);
-		rvec3_add(RVEC_OUT(p_fragment->position), p_fragment->position, ray.origin);
+        if (scene.accel == RTE_ACCEL_QBVH) {
+            slot = qbvh_intersect_sphere_set(&context->sphere_qbvh, &context->sphere_set, &ray, &sphere_distance);
+        } else {
+            slot = bvh_intersect_sphere_set(&context->sphere_bvh, &context->sphere_set, &ray, &sphere_distance);
+        }
 
-		rvec3_copy(RVEC_OUT(p_fragment->normal), (rvec3_t){0, 1, 0});
+        // Only the winning sphere gets its point and normal computed
+        if (slot != -1) {
+            sphere_set_resolve(&context->sphere_set, slot, &ray, sphere_distance, &sphere_intersect);
+            sphere_index = context->sphere_set.sphere_index[slot];
+            closest_t = sphere_distance;
+        }
+    } else {
+        for (int s = 0; s < context->sphere_count; s++) {
+            sphere_intersect_t intersect;
 
-		// Checkerboard pattern
-		rvec3_t checker;
-		rvec3_copy(RVEC_OUT(checker), p_fragment->position);
+            if (sphere_ray_intersect(context->spheres[s], ray, &intersect)) {
+                if (intersect.distance < closest_t) {
+                    closest_t = intersect.distance;
 
-		checker[0] = real_floor(checker[0] * GROUND_CHECKER_SIZE);
-		checker[2] = real_floor(checker[2] * GROUND_CHECKER_SIZE);
+                    sphere_intersect = intersect;
+                    sphere_index = s;
+                }
+            }
+        }
+    }
 
-		real_t mod = real_mod(checker[0] + real_mod(checker[2], REAL(2.0)), REAL(2.0));
+    if (trace_meshes(p_fragment, &ray, &closest_t, &scene)) {
+        return 1;
+    }
 
-		rvec3_copy(RVEC_OUT(p_fragment->albedo), RVEC3_RGB(0, 0, 0));
+    if (sphere_index != -1) {
+        sphere_fragment(p_fragment, &sphere_intersect, &context->spheres[sphere_index]);
+        p_fragment->primitive_id = RTE_PRIMITIVE_GROUND + 1 + sphere_index;
+        return 1;
+    }
 
-		if (mod) {
-			rvec3_copy(RVEC_OUT(p_fragment->albedo), RVEC3_RGB(255, 0, 137));
-		} else {
-			rvec3_copy(RVEC_OUT(p_fragment->albedo), RVEC3_RGB(5, 5, 5));
-		}
+    if (ground_hit) {
+        ground_fragment(p_fragment, ray, ground_t);
+        return 1;
+    }
 
-		rvec3_copy(RVEC_OUT(p_fragment->glow), p_fragment->albedo);
-		rvec3_mul_scalar(RVEC_OUT(p_fragment->glow), p_fragment->glow, REAL(0.5));
+	return 0;
+}
 
-		// The ground is a mirror
-		p_fragment->material_type = MATERIAL_TYPE_MIRROR;
+void trace_scene_packet(rte_fragment_t *p_fragments, int *p_hits, const rte_ray_t *rays, int count, const rte_scene_t scene) {
+    // Packets only run through the binary BVH, the quantized one is already four wide per ray
+    if (scene.accel != RTE_ACCEL_BVH || !scene.context->built) {
+        for (int r = 0; r < count; r++) {
+            p_hits[r] = trace_scene(&p_fragments[r], rays[r], scene);
+        }
 
-		hit = 1;
-	}
+        return;
+    }
 
-	// If the spheres are not initialized, initialize then
-	if (!spheres_generated) {
-		generate_spheres();
-        spheres_generated = 1;
-	}
+    const rte_context_t* context = scene.context;
 
-    int sphere_count = sizeof(spheres) / sizeof(sphere_t);
-	for (int s = 0; s < sphere_count; s++) {
-		sphere_t sphere = spheres[s];
-		sphere_intersect_t intersect;
+    for (int first = 0; first < count; first += PACKET_SIZE) {
+        int lanes = count - first < PACKET_SIZE ? count - first : PACKET_SIZE;
 
-		if (sphere_ray_intersect(sphere, ray, &intersect)) {
-			if (intersect.distance < closest_t) {
-				closest_t = intersect.distance;
+        real_t ground_t[PACKET_SIZE];
+        real_t closest_t[PACKET_SIZE];
 
-				rvec3_copy(RVEC_OUT(p_fragment->position), intersect.point);
-				rvec3_copy(RVEC_OUT(p_fragment->normal), intersect.normal);
-                rvec3_copy(RVEC_OUT(p_fragment->albedo), sphere.color);
-                rvec3_copy(RVEC_OUT(p_fragment->glow), RVEC3_RGB(0, 0, 0));
+        for (int l = 0; l < lanes; l++) {
+            const rte_ray_t* ray = &rays[first + l];
 
-                p_fragment->material_type = sphere.type;
+            ground_t[l] = -ray->origin[1] / ray->direction[1];
+            closest_t[l] = CAMERA_FAR;
 
-				hit = 1;
-			}
-		}
-	}
+            if (ground_t[l] > 0 && ground_t[l] < closest_t[l]) {
+                closest_t[l] = ground_t[l];
+            }
+        }
+
+        rte_packet_t packet;
+        packet_setup(&packet, &rays[first], closest_t, lanes);
+
+        bvh_intersect_packet_sphere_set(&context->sphere_bvh, &context->sphere_set, &packet);
+
+        for (int l = 0; l < lanes; l++) {
+            rte_fragment_t* p_fragment = &p_fragments[first + l];
+            const rte_ray_t* ray = &rays[first + l];
 
-	return hit;
+            p_fragment->material_type = MATERIAL_TYPE_PLASTIC;
+            p_fragment->primitive_id = RTE_PRIMITIVE_NONE;
+            p_hits[first + l] = 1;
+
+            real_t mesh_t = packet.slot[l] != -1 ? packet.t[l] : closest_t[l];
+
+            if (trace_meshes(p_fragment, ray, &mesh_t, &scene)) {
+                continue;
+            }
+
+            if (packet.slot[l] != -1) {
+                sphere_intersect_t intersect;
+                sphere_set_resolve(&context->sphere_set, packet.slot[l], ray, packet.t[l], &intersect);
+
+                int sphere_index = context->sphere_set.sphere_index[packet.slot[l]];
+
+                sphere_fragment(p_fragment, &intersect, &context->spheres[sphere_index]);
+                p_fragment->primitive_id = RTE_PRIMITIVE_GROUND + 1 + sphere_index;
+            } else if (closest_t[l] < CAMERA_FAR) {
+                ground_fragment(p_fragment, *ray, ground_t[l]);
+            } else {
+                p_hits[first + l] = 0;
+            }
+        }
+    }
+}
+
+int trace_occlusion(const rte_ray_t ray, const rte_scene_t scene) {
+    // Same ground plane test as trace_scene, minus the checkerboard
+    real_t ground_t = -ray.origin[1] / ray.direction[1];
+    if (ground_t > 0 && ground_t < CAMERA_FAR) {
+        return 1;
+    }
+
+    for (int m = 0; m < scene.mesh_count; m++) {
+        if (mesh_ray_occluded(&scene.meshes[m], &ray, CAMERA_FAR)) {
+            return 1;
+        }
+    }
+
+    if (scene.tlas != NULL && tlas_ray_occluded(scene.tlas, &ray, CAMERA_FAR)) {
+        return 1;
+    }
+
+    const rte_context_t* context = scene.context;
+
+    if (!context->built) {
+        return 0;
+    }
+
+    if (scene.accel == RTE_ACCEL_BVH) {
+        return bvh_occluded_sphere_set(&context->sphere_bvh, &context->sphere_set, &ray, CAMERA_FAR);
+    }
+
+    if (scene.accel == RTE_ACCEL_QBVH) {
+        return qbvh_occluded_sphere_set(&context->sphere_qbvh, &context->sphere_set, &ray, CAMERA_FAR);
+    }
+
+    for (int s = 0; s < context->sphere_count; s++) {
+        if (sphere_ray_occluded(&context->spheres[s], &ray, CAMERA_FAR)) {
+            return 1;
+        }
+    }
+
+    return 0;
 }
 
 void shade_fragment(rvec3_out_t dst_col, rte_fragment_t fragment, rte_ray_t ray, const rte_scene_t scene) {
@@ -556,7 +983,6 @@ void shade_fragment(rvec3_out_t dst_col, rte_fragment_t fragment, rte_ray_t ray,
 	rvec3_mul_scalar(RVEC_OUT(view_dir), ray.direction, REAL(-1.0));
 
 	// Shadowing
-	rte_fragment_t shadow_frag;
 	rte_ray_t shadow_ray;
 
 	rvec3_copy(RVEC_OUT(shadow_ray.origin), fragment.position);
@@ -564,7 +990,7 @@ void shade_fragment(rvec3_out_t dst_col, rte_fragment_t fragment, rte_ray_t ray,
 
 	rvec3_mul_scalar(RVEC_OUT(shadow_ray.direction), scene.sun_light.forward, REAL(1.0));
 
-	int shadow = !trace_scene(&shadow_frag, shadow_ray, scene);
+	int shadow = !trace_occlusion(shadow_ray, scene);
 
 	//
 	// Lambert shading
@@ -640,147 +1066,239 @@ void shade_sky(rvec3_out_t dst_col, rte_ray_t ray) {
     rvec3_mul_scalar(dst_col, RVEC_OUT_DEREF(dst_col), dot);
 }
 
-void trace_pixel(rvec3_out_t dst_col, const trace_t trace) {
-	rvec3_copy(dst_col, (rvec3_t) {0, 0, 0});
+int reflection_exhausted(const rvec3_t energy, real_t min_energy) {
+	return energy[0] < min_energy && energy[1] < min_energy && energy[2] < min_energy;
+}
 
-	real_t sub_tex_x = REAL(1.0) / (real_t)trace.camera.viewport.width;
-	real_t sub_tex_y = REAL(1.0) / (real_t)trace.camera.viewport.height;
+// Returns how many mirror bounces were traced past the first hit
+int shade_sample(rvec3_out_t dst_col, int hit, const rte_fragment_t* base_frag, const rte_ray_t ray, const rte_scene_t scene) {
+	rvec3_t sample;
+	int bounces = 0;
 
-	int samples = 1;
+	if (hit) {
+		shade_fragment(RVEC_OUT(sample), *base_frag, ray, scene);
 
-	if (trace.camera.samples == CAMERA_SAMPLES_FOUR) {
-		samples = 4;
-	}
+		// Reflection
+		rvec3_t reflection;
+        rvec3_copy(RVEC_OUT(reflection), RVEC3_RGB(0, 0, 0));
 
-	// Clear color
-	for (int s = 0; s < samples; s++) {
-		// Set up the base ray
-		// It's jittered at a subpixel level when using MSAA
-		rvec2_t view_coord;
-		screen_to_viewport(RVEC_OUT(view_coord), trace.camera.viewport, trace.point);
-
-		if (samples == 4) {
-			if (s <= 1) {
-				view_coord[0] += sub_tex_x * REAL(0.5);
-			} else {
-				view_coord[0] -= sub_tex_x * REAL(0.5);
-			}
+		if (base_frag->material_type == MATERIAL_TYPE_MIRROR) {
+            rte_fragment_t prior_frag = *base_frag;
+            rte_ray_t prior_ray = ray;
 
-			if (s % 2 == 0) {
-				view_coord[1] += sub_tex_y * REAL(0.5);
-			} else {
-				view_coord[1] -= sub_tex_y * REAL(0.5);
-			}
+            rvec3_t energy;
+
+            rvec3_copy(RVEC_OUT(energy), base_frag->albedo);
+
+            for (int b = 0; b < scene.mirror_bounces; b++) {
+                // Dark albedos multiply up quickly, whatever the next bounce sees would barely show
+                if (reflection_exhausted(energy, scene.min_energy)) {
+                    break;
+                }
+
+                rvec3_t bias;
+                rvec3_copy(RVEC_OUT(bias), prior_frag.normal);
+                rvec3_mul_scalar(RVEC_OUT(bias), bias, REAL(0.001));
+
+                rte_fragment_t reflect_frag;
+                rte_ray_t reflect_ray;
+
+                rvec3_copy(RVEC_OUT(reflect_ray.origin), prior_frag.position);
+                rvec3_add(RVEC_OUT(reflect_ray.origin), reflect_ray.origin, bias);
+
+                rvec3_t view_dir;
+                rvec3_copy(RVEC_OUT(view_dir), prior_ray.direction);
+
+                rvec3_t incidence;
+                rvec3_reflect(RVEC_OUT(incidence), view_dir, prior_frag.normal);
+                rvec3_normalize(RVEC_OUT(incidence));
+
+                rvec3_copy(RVEC_OUT(reflect_ray.direction), incidence);
+
+                int break_after = 0;
+                bounces++;
+
+                rvec3_t local_reflection;
+                rvec3_t local_energy;
+
+                if (trace_scene(&reflect_frag, reflect_ray, scene)) {
+                    shade_fragment(RVEC_OUT(local_reflection), reflect_frag, reflect_ray, scene);
+                    rvec3_copy(RVEC_OUT(local_energy), reflect_frag.albedo);
+                } else {
+                    shade_sky(RVEC_OUT(local_reflection), reflect_ray);
+                    rvec3_copy_scalar(RVEC_OUT(local_energy), REAL(0.0));
+
+                    break_after = 1;
+                }
+
+                rvec3_mul(RVEC_OUT(local_reflection), local_reflection, energy);
+                rvec3_add(RVEC_OUT(reflection), reflection, local_reflection);
+
+                rvec3_mul(RVEC_OUT(energy), energy, local_energy);
+
+                prior_frag = reflect_frag;
+                prior_ray = reflect_ray;
+
+                if (break_after) {
+                    break;
+                }
+            }
 		}
 
-		rte_ray_t ray;
+		rvec3_add(RVEC_OUT(sample), sample, reflection);
+	} else {
+		shade_sky(RVEC_OUT(sample), ray);
+	}
 
-		rvec3_copy(RVEC_OUT(ray.direction), (rvec3_t) {view_coord[0], -view_coord[1], 1});
+	rvec3_copy(dst_col, sample);
 
-#ifdef RTE_FLIP_Y
-		ray.direction[1] *= -1;
-#endif
+	return bounces;
+}
 
-		rvec4_t pre_t;
-		rvec4_t post_t;
+void trace_ray_batch(rvec3_t* dst_cols, int* p_mirrors, real_t* p_depths, const rte_ray_t* rays, int count, const rte_scene_t scene) {
+	rte_fragment_t frags[PACKET_SIZE];
+	int hits[PACKET_SIZE];
 
-		rvec4_copy_rvec3_w(RVEC_OUT(pre_t), ray.direction, REAL(1.0));
-		rmat4_mul_rvec4(RVEC_OUT(post_t), trace.camera.mat_vp_i, pre_t);
+	for (int start = 0; start < count; start += PACKET_SIZE) {
+		int pending = count - start < PACKET_SIZE ? count - start : PACKET_SIZE;
 
-		rvec3_copy_rvec4(RVEC_OUT(ray.direction), post_t);
-		rvec3_normalize(RVEC_OUT(ray.direction));
+		if (pending == 1) {
+			hits[0] = trace_scene(&frags[0], rays[start], scene);
+		} else {
+			trace_scene_packet(frags, hits, &rays[start], pending, scene);
+		}
 
-		rvec4_copy_rvec3_w(RVEC_OUT(pre_t), (rvec3_t) {0, 0, 0}, REAL(1.0));
-		rmat4_mul_rvec4(RVEC_OUT(post_t), trace.camera.mat_v, pre_t);
+		for (int r = 0; r < pending; r++) {
+			shade_sample(RVEC_OUT(dst_cols[start + r]), hits[r], &frags[r], rays[start + r], scene);
 
-		rvec3_copy_rvec4(RVEC_OUT(ray.origin), post_t);
+			if (p_mirrors != NULL) {
+				p_mirrors[start + r] = hits[r] && frags[r].material_type == MATERIAL_TYPE_MIRROR;
+			}
 
-        //
-		// Base pass
-		//
-        rvec3_t sample;
-		rte_fragment_t base_frag;
+			if (p_depths != NULL) {
+				rvec3_t offset;
+				rvec3_sub(RVEC_OUT(offset), frags[r].position, rays[start + r].origin);
 
-        if (trace_scene(&base_frag, ray, trace.scene)) {
-			shade_fragment(RVEC_OUT(sample), base_frag, ray, trace.scene);
+				p_depths[start + r] = hits[r] ? rvec3_length(offset) : 0;
+			}
+		}
+	}
+}
+
+// Fills in the AOVs of one pixel from the first sample traced for it
+static void write_aovs(const rte_aovs_t *aovs, rte_point_t point, int hit, const rte_fragment_t* frag, const rte_ray_t* ray, int bounces) {
+	size_t index = (size_t)point.y * aovs->stride + point.x;
+
+	if (aovs->depth != NULL) {
+		rvec3_t offset;
+		rvec3_sub(RVEC_OUT(offset), frag->position, ray->origin);
 
-			// Reflection
-			rvec3_t reflection;
-            rvec3_copy(RVEC_OUT(reflection), RVEC3_RGB(0, 0, 0));
+		aovs->depth[index] = hit ? rvec3_length(offset) : 0;
+	}
 
-			if (base_frag.material_type == MATERIAL_TYPE_MIRROR) {
-                rte_fragment_t prior_frag = base_frag;
-                rte_ray_t prior_ray = ray;
+	for (int c = 0; c < 3; c++) {
+		if (aovs->normal[c] != NULL) {
+			aovs->normal[c][index] = hit ? frag->normal[c] : 0;
+		}
 
-                rvec3_t energy;
+		if (aovs->albedo[c] != NULL) {
+			aovs->albedo[c][index] = hit ? frag->albedo[c] : 0;
+		}
+	}
 
-                rvec3_copy(&energy, base_frag.albedo);
+	if (aovs->material != NULL) {
+		aovs->material[index] = hit ? (int)frag->material_type : -1;
+	}
 
-                for (int b = 0; b < trace.scene.mirror_bounces; b++) {
-                    rvec3_t bias;
-                    rvec3_copy(RVEC_OUT(bias), prior_frag.normal);
-                    rvec3_mul_scalar(RVEC_OUT(bias), bias, REAL(0.001));
+	if (aovs->primitive_id != NULL) {
+		aovs->primitive_id[index] = hit ? frag->primitive_id : RTE_PRIMITIVE_NONE;
+	}
 
-                    rte_fragment_t reflect_frag;
-                    rte_ray_t reflect_ray;
+	if (aovs->bounces != NULL) {
+		aovs->bounces[index] = bounces;
+	}
+}
 
-                    rvec3_copy(RVEC_OUT(reflect_ray.origin), prior_frag.position);
-                    rvec3_add(RVEC_OUT(reflect_ray.origin), reflect_ray.origin, bias);
+void trace_pixel_block(rvec3_t *dst_cols, const trace_t trace, unsigned int width, unsigned int height) {
+	trace_pixel_block_aovs(dst_cols, NULL, trace, width, height);
+}
 
-                    rvec3_t view_dir;
-                    rvec3_copy(RVEC_OUT(view_dir), prior_ray.direction);
+void trace_pixel_block_aovs(rvec3_t *dst_cols, const rte_aovs_t *aovs, const trace_t trace, unsigned int width, unsigned int height) {
+	int samples = camera_sample_count(&trace.camera);
+	int pixel_count = (int)(width * height);
 
-                    rvec3_t incidence;
-                    rvec3_reflect(RVEC_OUT(incidence), view_dir, prior_frag.normal);
-                    rvec3_normalize(RVEC_OUT(incidence));
+	rte_ray_t rays[PACKET_SIZE];
+	rte_fragment_t frags[PACKET_SIZE];
+	int hits[PACKET_SIZE];
+	int owners[PACKET_SIZE];
 
-                    rvec3_copy(RVEC_OUT(reflect_ray.direction), incidence);
+	int pending = 0;
 
-                    int break_after = 0;
+	for (int p = 0; p < pixel_count; p++) {
+		rvec3_copy(RVEC_OUT(dst_cols[p]), (rvec3_t) {0, 0, 0});
 
-                    rvec3_t local_reflection;
-                    rvec3_t local_energy;
+		rte_point_t point;
+		point.x = trace.point.x + (unsigned int)p % width;
+		point.y = trace.point.y + (unsigned int)p / width;
 
-                    if (trace_scene(&reflect_frag, reflect_ray, trace.scene)) {
-                        shade_fragment(RVEC_OUT(local_reflection), reflect_frag, reflect_ray, trace.scene);
-                        rvec3_copy(RVEC_OUT(local_energy), reflect_frag.albedo);
-                    } else {
-                        shade_sky(RVEC_OUT(local_reflection), reflect_ray);
-                        rvec3_copy_scalar(RVEC_OUT(local_energy), REAL(0.0));
+		for (int s = 0; s < samples; s++) {
+			camera_sample_ray(&rays[pending], &trace.camera, point, s, samples);
+			owners[pending] = p;
+			pending++;
+		}
 
-                        break_after = 1;
-                    }
+		// Flush once the next pixel's samples would no longer fit
+		if (pending + samples <= PACKET_SIZE && p != pixel_count - 1) {
+			continue;
+		}
 
-                    rvec3_mul(RVEC_OUT(local_reflection), local_reflection, energy);
-                    rvec3_add(RVEC_OUT(reflection), reflection, local_reflection);
+		//
+		// Base pass
+		//
+		if (pending == 1) {
+			hits[0] = trace_scene(&frags[0], rays[0], trace.scene);
+		} else {
+			trace_scene_packet(frags, hits, rays, pending, trace.scene);
+		}
 
-                    rvec3_mul(RVEC_OUT(energy), energy, local_energy);
+		// Shadows and reflections diverge quickly, they're traced per sample
+		for (int r = 0; r < pending; r++) {
+			rvec3_t sample;
+			int bounces = shade_sample(RVEC_OUT(sample), hits[r], &frags[r], rays[r], trace.scene);
 
-                    prior_frag = reflect_frag;
-                    prior_ray = reflect_ray;
+			// Packets only ever hold whole pixels, so every pixel's first sample lands on a multiple of samples
+			if (aovs != NULL && r % samples == 0) {
+				rte_point_t point;
+				point.x = trace.point.x + (unsigned int)owners[r] % width;
+				point.y = trace.point.y + (unsigned int)owners[r] / width;
 
-                    if (break_after) {
-                        break;
-                    }
-                }
+				write_aovs(aovs, point, hits[r], &frags[r], &rays[r], bounces);
 			}
 
-			rvec3_add(RVEC_OUT(sample), sample, reflection);
-		} else {
-            shade_sky(RVEC_OUT(sample), ray);
-        }
+			rvec3_mul_scalar(RVEC_OUT(sample), sample, REAL(1.0) / (real_t)samples);
+			rvec3_add(RVEC_OUT(dst_cols[owners[r]]), dst_cols[owners[r]], sample);
+		}
 
-		rvec3_mul_scalar(RVEC_OUT(sample), sample, REAL(1.0) / (real_t)samples);
-		rvec3_add(dst_col, RVEC_OUT_DEREF(dst_col), sample);
+		pending = 0;
 	}
 
 	//
 	// Final pass
 	//
-    if (trace.tonemapping == RTE_TONEMAP_ACES)
-        tonemap_aces(dst_col);
+	for (int p = 0; p < pixel_count; p++) {
+		if (trace.tonemapping == RTE_TONEMAP_ACES)
+			tonemap_aces(RVEC_OUT(dst_cols[p]));
+
+		rvec3_saturate(RVEC_OUT(dst_cols[p]));
+	}
+}
+
+void trace_pixel(rvec3_out_t dst_col, const trace_t trace) {
+	rvec3_t col[1];
+
+	trace_pixel_block(col, trace, 1, 1);
 
-	rvec3_saturate(dst_col);
+	rvec3_copy(dst_col, col[0]);
 }
 
 #endif
\ No newline at end of file
@@ -21,6 +21,12 @@ extern "C" {
 #include "math/crand.h"
 
 #include "shapes/sphere.h"
+#include "shapes/mesh.h"
+
+#include "accel/bvh.h"
+#include "accel/lbvh.h"
+#include "accel/qbvh.h"
+#include "accel/tlas.h"
 
 typedef enum rte_bool {
     RTE_FALSE = 0,
@@ -37,6 +43,13 @@ typedef struct rte_point {
 	unsigned int y;
 } rte_point_t;
 
+typedef struct rte_tile {
+	unsigned int x;
+	unsigned int y;
+	unsigned int width;
+	unsigned int height;
+} rte_tile_t;
+
 typedef enum CAMERA_SAMPLES {
 	CAMERA_SAMPLES_ONE,
 	CAMERA_SAMPLES_FOUR
@@ -60,6 +73,11 @@ typedef enum MATERIAL_TYPE {
 	MATERIAL_TYPE_MIRROR
 } MATERIAL_TYPE_E;
 
+// Surfaces are numbered across the whole scene, spheres follow the ground and meshes follow the spheres
+// Every mesh (and then every TLAS instance) gets a single id, its triangles aren't told apart
+#define RTE_PRIMITIVE_NONE (-1)
+#define RTE_PRIMITIVE_GROUND 0
+
 typedef struct rte_fragment {
 	rvec3_t position;
 	rvec3_t normal;
@@ -70,8 +88,26 @@ typedef struct rte_fragment {
 	real_t metallic;
 
 	MATERIAL_TYPE_E material_type;
+	int primitive_id;
 } rte_fragment_t;
 
+//
+// Arbitrary output variables
+// Per pixel planes written by the same pass as the colors, any plane left NULL is skipped
+// Planes are row-major and indexed by the pixel's position in the frame, so every tile of a frame can share them
+// With MSAA they come from the first sample of each pixel
+//
+typedef struct rte_aovs {
+	real_t* depth; // Distance to the first hit, 0 for the sky
+	real_t* normal[3]; // 0 for the sky
+	real_t* albedo[3]; // 0 for the sky
+	int* material; // MATERIAL_TYPE_E of the first hit, -1 for the sky
+	int* primitive_id; // RTE_PRIMITIVE_NONE for the sky
+	int* bounces; // Mirror bounces traced past the first hit
+
+	unsigned int stride; // Pixels in a row of every plane
+} rte_aovs_t;
+
 typedef enum rte_tonemap {
     RTE_TONEMAP_NONE,
     RTE_TONEMAP_ACES
@@ -84,9 +120,56 @@ typedef struct rte_light {
     real_t intensity;
 } rte_light_t;
 
+typedef enum rte_accel {
+    RTE_ACCEL_NONE, // Brute force, every ray is tested against every sphere
+    RTE_ACCEL_BVH,
+    RTE_ACCEL_QBVH // Compressed four wide BVH, a third of the memory of RTE_ACCEL_BVH
+} rte_accel_e;
+
+typedef enum rte_builder {
+    RTE_BUILDER_SAH, // Binned SAH, slowest build but the best trees
+    RTE_BUILDER_LBVH, // Morton sorted, fastest build
+    RTE_BUILDER_LBVH_TREELETS // LBVH followed by treelet restructuring
+} rte_builder_e;
+
+//
+// Owns everything a scene is built from, so independent scenes can be rendered side by side
+// Fill in the settings after rte_context_init, then call rte_context_build before tracing with it
+//
+typedef struct rte_context {
+    unsigned long seed;
+    rte_builder_e builder;
+    int sphere_count;
+
+    sphere_t* spheres;
+    rte_bvh_t sphere_bvh;
+    rte_qbvh_t sphere_qbvh;
+    sphere_set_t sphere_set;
+
+    crand_state_t rand;
+    int built;
+} rte_context_t;
+
+// Below a 1/256 step of an 8 bit image, skipped reflections rarely move a pixel by more than a step or two
+#define RTE_DEFAULT_MIN_ENERGY REAL(0.00390625)
+
 typedef struct rte_scene {
+    // Never modified while tracing, any number of threads may share it
+    const rte_context_t* context;
+
     rte_light_t sun_light;
     int mirror_bounces;
+    rte_accel_e accel;
+
+    // Reflections stop early once no channel of the energy they still carry reaches this, 0 traces every bounce
+    real_t min_energy;
+
+    // Built meshes traced alongside the spheres, owned by the caller
+    const rte_mesh_t* meshes;
+    int mesh_count;
+
+    // Optional instanced meshes, the caller keeps it updated with tlas_update
+    const rte_tlas_t* tlas;
 } rte_scene_t;
 
 typedef struct trace {
@@ -101,13 +184,61 @@ extern void screen_to_viewport(rvec2_out_t dst, rte_viewport_t viewport, rte_poi
 extern rte_camera_t rte_setup_camera(rte_viewport_t viewport, rvec3_t position, rvec3_t rotation);
 extern rte_camera_t rte_default_camera(rte_viewport_t viewport);
 
-extern rte_scene_t rte_default_scene();
+// Builds the primary ray for one sub-sample of a pixel, samples comes from camera_sample_count
+extern void camera_sample_ray(rte_ray_t* p_ray, const rte_camera_t* camera, rte_point_t point, int sample, int samples);
+extern int camera_sample_count(const rte_camera_t* camera);
+
+// Builds the primary ray through a point of a pixel, offsets are in pixels from its center (-0.5 to 0.5)
+extern void camera_offset_ray(rte_ray_t* p_ray, const rte_camera_t* camera, rte_point_t point, real_t offset_x, real_t offset_y);
+
+// Offset of the nth sample for camera_offset_ray, well spread for any count, sample 0 is the pixel center
+extern void camera_sample_offset(int sample, real_t* p_x, real_t* p_y);
+
+// Finds where a world position lands on screen, the center of pixel x is at x + 0.5
+// Returns 0 if it's behind the camera, the coordinates can still be off screen otherwise
+extern int camera_project(real_t* p_x, real_t* p_y, const rte_camera_t* camera, const rvec3_t point);
+
+extern void rte_context_init(rte_context_t* context);
+extern void rte_context_free(rte_context_t* context);
+
+// Scatters the sphere field from the context's seed and builds its acceleration structures, replacing any previous build
+// Must not be called while other threads are tracing with the context, returns 0 on allocation failure
+extern int rte_context_build(rte_context_t* context);
+
+extern rte_scene_t rte_default_scene(const rte_context_t* context);
 
 extern int trace_scene(rte_fragment_t *p_fragment, const rte_ray_t ray, const rte_scene_t scene);
+
+// Traces a batch of coherent rays (e.g. primary rays of neighbouring pixels) as packets through the BVH
+// p_hits receives what trace_scene would have returned for each ray
+extern void trace_scene_packet(rte_fragment_t *p_fragments, int *p_hits, const rte_ray_t *rays, int count, const rte_scene_t scene);
+
+// Returns 1 if anything blocks the ray, stops at the first hit and computes no surface data
+extern int trace_occlusion(const rte_ray_t ray, const rte_scene_t scene);
+
 extern void shade_fragment(rvec3_out_t dst_col, const rte_fragment_t fragment, const rte_ray_t ray, const rte_scene_t scene);
 
+extern void shade_sky(rvec3_out_t dst_col, rte_ray_t ray);
+
+// Returns 1 if a reflection carrying this much energy is too dark to be worth another bounce
+extern int reflection_exhausted(const rvec3_t energy, real_t min_energy);
+
+extern void tonemap_aces(rvec3_out_t color);
+
 extern void trace_pixel(rvec3_out_t dst_col, const trace_t trace);
 
+// Traces a width x height block of pixels starting at trace.point, writing row-major colors to dst_cols
+// Primary rays of up to 4x4 pixels (2x2 with MSAA) are traced as one packet
+extern void trace_pixel_block(rvec3_t *dst_cols, const trace_t trace, unsigned int width, unsigned int height);
+
+// trace_pixel_block that also fills in the AOVs of the block's pixels, aovs may be NULL
+extern void trace_pixel_block_aovs(rvec3_t *dst_cols, const rte_aovs_t *aovs, const trace_t trace, unsigned int width, unsigned int height);
+
+// Traces and shades any set of rays, packets are cut from consecutive rays so coherent ones belong next to each other
+// Colors are linear (not tonemapped or saturated), p_mirrors receives whether each ray first hit a mirror
+// and p_depths the distance to that first hit or 0 for the sky, either may be NULL
+extern void trace_ray_batch(rvec3_t* dst_cols, int* p_mirrors, real_t* p_depths, const rte_ray_t* rays, int count, const rte_scene_t scene);
+
 #ifdef __cplusplus
 };
 #endif
@@ -0,0 +1,243 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#include "mesh.h"
+
+#include "../threading/thread.h"
+
+#include <stdlib.h>
+
+#define MESH_BVH_LEAF_SIZE 4
+
+void mesh_init(rte_mesh_t* mesh) {
+	mesh->positions = NULL;
+	mesh->position_count = 0;
+	mesh->position_capacity = 0;
+
+	mesh->normals = NULL;
+	mesh->normal_count = 0;
+	mesh->normal_capacity = 0;
+
+	mesh->position_indices = NULL;
+	mesh->normal_indices = NULL;
+	mesh->triangle_count = 0;
+	mesh->triangle_capacity = 0;
+
+	rvec3_copy_scalar(RVEC_OUT(mesh->albedo), REAL(0.8));
+	mesh->material = 0;
+
+	mesh->bvh.nodes = NULL;
+	mesh->bvh.node_count = 0;
+	mesh->bvh.indices = NULL;
+	mesh->bvh.index_count = 0;
+
+	mesh->set.vertices[0] = NULL;
+	mesh->set.count = 0;
+	mesh->set.capacity = 0;
+}
+
+void mesh_free(rte_mesh_t* mesh) {
+	free(mesh->positions);
+	free(mesh->normals);
+	free(mesh->position_indices);
+	free(mesh->normal_indices);
+
+	bvh_free(&mesh->bvh);
+	triangle_set_free(&mesh->set);
+
+	mesh_init(mesh);
+}
+
+//
+// Building
+//
+static int mesh_reserve(void** p_data, int* p_capacity, int count, size_t element_size) {
+	if (count < *p_capacity) {
+		return 1;
+	}
+
+	int capacity = *p_capacity * 2 + 256;
+	void* data = realloc(*p_data, element_size * capacity);
+
+	if (data == NULL) {
+		return 0;
+	}
+
+	*p_data = data;
+	*p_capacity = capacity;
+
+	return 1;
+}
+
+int mesh_add_position(rte_mesh_t* mesh, const rvec3_t position) {
+	if (!mesh_reserve((void**)&mesh->positions, &mesh->position_capacity, mesh->position_count, sizeof(rvec3_t))) {
+		return -1;
+	}
+
+	rvec3_copy(RVEC_OUT(mesh->positions[mesh->position_count]), position);
+	return mesh->position_count++;
+}
+
+int mesh_add_normal(rte_mesh_t* mesh, const rvec3_t normal) {
+	if (!mesh_reserve((void**)&mesh->normals, &mesh->normal_capacity, mesh->normal_count, sizeof(rvec3_t))) {
+		return -1;
+	}
+
+	rvec3_copy(RVEC_OUT(mesh->normals[mesh->normal_count]), normal);
+	rvec3_normalize(RVEC_OUT(mesh->normals[mesh->normal_count]));
+
+	return mesh->normal_count++;
+}
+
+int mesh_add_triangle(rte_mesh_t* mesh, const int positions[3], const int normals[3]) {
+	// Both index lists share one capacity
+	int normal_capacity = mesh->triangle_capacity;
+
+	if (!mesh_reserve((void**)&mesh->normal_indices, &normal_capacity, mesh->triangle_count, sizeof(int) * 3)) {
+		return -1;
+	}
+
+	if (!mesh_reserve((void**)&mesh->position_indices, &mesh->triangle_capacity, mesh->triangle_count, sizeof(int) * 3)) {
+		return -1;
+	}
+
+	int t = mesh->triangle_count;
+
+	for (int v = 0; v < 3; v++) {
+		mesh->position_indices[t * 3 + v] = positions[v];
+		mesh->normal_indices[t * 3 + v] = normals != NULL ? normals[v] : -1;
+	}
+
+	return mesh->triangle_count++;
+}
+
+typedef struct mesh_bounds_job {
+	const rte_mesh_t* mesh;
+	rte_aabb_t* bounds;
+} mesh_bounds_job_t;
+
+static void mesh_bounds_job(void* user, int begin, int end) {
+	mesh_bounds_job_t* job = (mesh_bounds_job_t*)user;
+	const rte_mesh_t* mesh = job->mesh;
+
+	for (int t = begin; t < end; t++) {
+		const int* indices = &mesh->position_indices[t * 3];
+		triangle_bounds(&job->bounds[t], mesh->positions[indices[0]], mesh->positions[indices[1]], mesh->positions[indices[2]]);
+	}
+}
+
+int mesh_build(rte_mesh_t* mesh) {
+	bvh_free(&mesh->bvh);
+	triangle_set_free(&mesh->set);
+
+	if (mesh->triangle_count == 0) {
+		return 1;
+	}
+
+	mesh_bounds_job_t job;
+
+	job.mesh = mesh;
+	job.bounds = (rte_aabb_t*)malloc(sizeof(rte_aabb_t) * mesh->triangle_count);
+
+	if (job.bounds == NULL) {
+		return 0;
+	}
+
+	rte_parallel_for(mesh->triangle_count, 4096, mesh_bounds_job, &job);
+
+	int built = bvh_build(&mesh->bvh, job.bounds, mesh->triangle_count, MESH_BVH_LEAF_SIZE);
+
+	free(job.bounds);
+
+	if (!built) {
+		return 0;
+	}
+
+	// The SoA copy follows the BVH order so every leaf is a contiguous run of slots
+	return triangle_set_build(&mesh->set, mesh->positions, mesh->position_indices, mesh->bvh.indices, mesh->bvh.index_count);
+}
+
+int mesh_refit(rte_mesh_t* mesh) {
+	if (mesh->triangle_count != mesh->bvh.index_count) {
+		return mesh_build(mesh);
+	}
+
+	if (mesh->triangle_count == 0) {
+		return 1;
+	}
+
+	mesh_bounds_job_t job;
+
+	job.mesh = mesh;
+	job.bounds = (rte_aabb_t*)malloc(sizeof(rte_aabb_t) * mesh->triangle_count);
+
+	if (job.bounds == NULL) {
+		return 0;
+	}
+
+	rte_parallel_for(mesh->triangle_count, 4096, mesh_bounds_job, &job);
+
+	bvh_refit(&mesh->bvh, job.bounds);
+	triangle_set_update(&mesh->set, mesh->positions, mesh->position_indices);
+
+	free(job.bounds);
+	return 1;
+}
+
+//
+// Tracing
+//
+int mesh_ray_intersect(const rte_mesh_t* mesh, const rte_ray_t* ray, real_t* p_t, mesh_intersect_t* intersect) {
+	real_t t = *p_t;
+	real_t u, v;
+
+	int slot = bvh_intersect_triangle_set(&mesh->bvh, &mesh->set, ray, &t, &u, &v);
+
+	if (slot == -1) {
+		return 0;
+	}
+
+	int triangle = mesh->set.triangle_index[slot];
+
+	const int* positions = &mesh->position_indices[triangle * 3];
+	const int* normals = &mesh->normal_indices[triangle * 3];
+
+	rvec3_mul_scalar(RVEC_OUT(intersect->point), ray->direction, t);
+	rvec3_add(RVEC_OUT(intersect->point), ray->origin, intersect->point);
+
+	if (normals[0] >= 0 && normals[1] >= 0 && normals[2] >= 0) {
+		rvec3_t n0, n1, n2;
+
+		rvec3_mul_scalar(RVEC_OUT(n0), mesh->normals[normals[0]], REAL(1.0) - u - v);
+		rvec3_mul_scalar(RVEC_OUT(n1), mesh->normals[normals[1]], u);
+		rvec3_mul_scalar(RVEC_OUT(n2), mesh->normals[normals[2]], v);
+
+		rvec3_add(RVEC_OUT(intersect->normal), n0, n1);
+		rvec3_add(RVEC_OUT(intersect->normal), intersect->normal, n2);
+	} else {
+		rvec3_t edge0, edge1;
+
+		rvec3_sub(RVEC_OUT(edge0), mesh->positions[positions[1]], mesh->positions[positions[0]]);
+		rvec3_sub(RVEC_OUT(edge1), mesh->positions[positions[2]], mesh->positions[positions[0]]);
+
+		rvec3_cross(RVEC_OUT(intersect->normal), edge0, edge1);
+	}
+
+	rvec3_normalize(RVEC_OUT(intersect->normal));
+
+	// Meshes are two sided
+	if (rvec3_dot(intersect->normal, ray->direction) > 0) {
+		rvec3_mul_scalar(RVEC_OUT(intersect->normal), intersect->normal, REAL(-1.0));
+	}
+
+	intersect->distance = t;
+	intersect->triangle = triangle;
+
+	*p_t = t;
+	return 1;
+}
+
+int mesh_ray_occluded(const rte_mesh_t* mesh, const rte_ray_t* ray, real_t t_max) {
+	return bvh_occluded_triangle_set(&mesh->bvh, &mesh->set, ray, t_max);
+}
@@ -0,0 +1,69 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#ifndef RTEVERYWHERE_MESH_H
+#define RTEVERYWHERE_MESH_H
+
+#include "../math/real.h"
+#include "../math/vectors.h"
+#include "../math/ray.h"
+
+#include "../accel/bvh.h"
+
+#include "triangle_set.h"
+
+//
+// Indexed triangle mesh with a single material
+// Fill it through the mesh_add_* functions (or obj_load) then call mesh_build before tracing against it
+//
+typedef struct rte_mesh {
+	rvec3_t* positions;
+	int position_count;
+	int position_capacity;
+
+	rvec3_t* normals;
+	int normal_count;
+	int normal_capacity;
+
+	// Three entries per triangle, normal indices are -1 when the triangle is flat shaded
+	int* position_indices;
+	int* normal_indices;
+	int triangle_count;
+	int triangle_capacity;
+
+	rvec3_t albedo;
+	int material;
+
+	rte_bvh_t bvh;
+	triangle_set_t set;
+} rte_mesh_t;
+
+typedef struct mesh_intersect {
+	rvec3_t point;
+	rvec3_t normal;
+	real_t distance;
+
+	int triangle;
+} mesh_intersect_t;
+
+extern void mesh_init(rte_mesh_t* mesh);
+extern void mesh_free(rte_mesh_t* mesh);
+
+// These return the index of the new element, or -1 on allocation failure
+extern int mesh_add_position(rte_mesh_t* mesh, const rvec3_t position);
+extern int mesh_add_normal(rte_mesh_t* mesh, const rvec3_t normal);
+extern int mesh_add_triangle(rte_mesh_t* mesh, const int positions[3], const int normals[3]);
+
+// Builds the BVH and SoA triangle copy, returns 0 on allocation failure
+extern int mesh_build(rte_mesh_t* mesh);
+
+// Call after moving positions without touching the triangles, refits the BVH in place instead of rebuilding it
+// Falls back to mesh_build if triangles were added since the last build
+extern int mesh_refit(rte_mesh_t* mesh);
+
+// Nearest hit closer than *p_t, the normal always faces against the ray
+extern int mesh_ray_intersect(const rte_mesh_t* mesh, const rte_ray_t* ray, real_t* p_t, mesh_intersect_t* intersect);
+extern int mesh_ray_occluded(const rte_mesh_t* mesh, const rte_ray_t* ray, real_t t_max);
+
+#endif //RTEVERYWHERE_MESH_H
@@ -44,4 +44,25 @@ int sphere_ray_intersect(sphere_t sphere, rte_ray_t ray, sphere_intersect_t* int
 	}
 
 	return 0;
+}
+
+int sphere_ray_occluded(const sphere_t* sphere, const rte_ray_t* ray, real_t t_max) {
+	rvec3_t d;
+	rvec3_sub(RVEC_OUT(d), ray->origin, sphere->origin);
+
+	real_t p1 = -rvec3_dot(ray->direction, d);
+	real_t p2sqr = p1 * p1 - rvec3_dot(d, d) + sphere->radius * sphere->radius;
+
+	if (p2sqr < 0)
+		return 0;
+
+	real_t p2 = (real_t)sqrt(p2sqr);
+	real_t t = p1 - p2 > 0 ? p1 - p2 : p1 + p2;
+
+	return t > 0 && t < t_max;
+}
+
+void sphere_bounds(rte_aabb_t* dst, const sphere_t* sphere) {
+	rvec3_sub_scalar(RVEC_OUT(dst->min), sphere->origin, sphere->radius);
+	rvec3_add_scalar(RVEC_OUT(dst->max), sphere->origin, sphere->radius);
 }
\ No newline at end of file
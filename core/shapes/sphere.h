@@ -8,6 +8,7 @@
 #include "../math/real.h"
 #include "../math/vectors.h"
 #include "../math/ray.h"
+#include "../math/aabb.h"
 
 typedef struct sphere {
     real_t radius;
@@ -24,4 +25,9 @@ typedef struct sphere_intersect {
 
 extern int sphere_ray_intersect(sphere_t sphere, rte_ray_t ray, sphere_intersect_t* intersect);
 
+// Any-hit variant, only reports whether the sphere is hit within (0, t_max)
+extern int sphere_ray_occluded(const sphere_t* sphere, const rte_ray_t* ray, real_t t_max);
+
+extern void sphere_bounds(rte_aabb_t* dst, const sphere_t* sphere);
+
 #endif //RTEVERYWHERE_SPHERE_H
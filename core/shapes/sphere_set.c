@@ -0,0 +1,230 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#include "sphere_set.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+
+int sphere_set_build(sphere_set_t* set, const sphere_t* spheres, const int* order, int count) {
+	// Ranges may start anywhere, an extra lane group of padding keeps their last load in bounds
+	int capacity = ((count + SPHERE_SET_WIDTH - 1) / SPHERE_SET_WIDTH) * SPHERE_SET_WIDTH + SPHERE_SET_WIDTH;
+
+	char* block = (char*)malloc((sizeof(real_t) * 4 + sizeof(int) * 2) * capacity);
+
+	if (block == NULL) {
+		set->count = 0;
+		set->capacity = 0;
+		set->center_x = NULL;
+		return 0;
+	}
+
+	set->center_x = (real_t*)block;
+	set->center_y = set->center_x + capacity;
+	set->center_z = set->center_y + capacity;
+	set->radius_sqr = set->center_z + capacity;
+	set->material = (int*)(set->radius_sqr + capacity);
+	set->sphere_index = set->material + capacity;
+
+	set->count = count;
+	set->capacity = capacity;
+
+	for (int i = 0; i < capacity; i++) {
+		if (i >= count) {
+			set->center_x[i] = REAL(0.0);
+			set->center_y[i] = REAL(0.0);
+			set->center_z[i] = REAL(0.0);
+			set->radius_sqr[i] = -FLT_MAX;
+			set->material[i] = 0;
+			set->sphere_index[i] = -1;
+			continue;
+		}
+
+		int s = order != NULL ? order[i] : i;
+		const sphere_t* sphere = &spheres[s];
+
+		set->center_x[i] = sphere->origin[0];
+		set->center_y[i] = sphere->origin[1];
+		set->center_z[i] = sphere->origin[2];
+		set->radius_sqr[i] = sphere->radius * sphere->radius;
+		set->material[i] = sphere->type;
+		set->sphere_index[i] = s;
+	}
+
+	return 1;
+}
+
+void sphere_set_free(sphere_set_t* set) {
+	free(set->center_x);
+
+	set->center_x = NULL;
+	set->center_y = NULL;
+	set->center_z = NULL;
+	set->radius_sqr = NULL;
+	set->material = NULL;
+	set->sphere_index = NULL;
+
+	set->count = 0;
+	set->capacity = 0;
+}
+
+int sphere_set_intersect(const sphere_set_t* set, int first, int count, const rte_ray_t* ray, real_t* p_t) {
+	int hit_slot = -1;
+	real_t closest_t = *p_t;
+
+#ifdef RSIMD_WIDTH
+	const rsimd_t zero = rsimd_set1(REAL(0.0));
+
+	const rsimd_t ox = rsimd_set1(ray->origin[0]);
+	const rsimd_t oy = rsimd_set1(ray->origin[1]);
+	const rsimd_t oz = rsimd_set1(ray->origin[2]);
+
+	const rsimd_t dir_x = rsimd_set1(ray->direction[0]);
+	const rsimd_t dir_y = rsimd_set1(ray->direction[1]);
+	const rsimd_t dir_z = rsimd_set1(ray->direction[2]);
+
+	for (int base = first; base < first + count; base += RSIMD_WIDTH) {
+		// Same math as sphere_ray_intersect, one sphere per lane
+		rsimd_t dx = rsimd_sub(ox, rsimd_load(set->center_x + base));
+		rsimd_t dy = rsimd_sub(oy, rsimd_load(set->center_y + base));
+		rsimd_t dz = rsimd_sub(oz, rsimd_load(set->center_z + base));
+
+		rsimd_t p1 = rsimd_sub(zero, rsimd_add(rsimd_add(rsimd_mul(dir_x, dx), rsimd_mul(dir_y, dy)), rsimd_mul(dir_z, dz)));
+		rsimd_t d2 = rsimd_add(rsimd_add(rsimd_mul(dx, dx), rsimd_mul(dy, dy)), rsimd_mul(dz, dz));
+		rsimd_t p2sqr = rsimd_add(rsimd_sub(rsimd_mul(p1, p1), d2), rsimd_load(set->radius_sqr + base));
+
+		rsimd_t p2 = rsimd_sqrt(rsimd_max(p2sqr, zero));
+		rsimd_t t_near = rsimd_sub(p1, p2);
+		rsimd_t t = rsimd_select(rsimd_cmp_gt(t_near, zero), rsimd_add(p1, p2), t_near);
+
+		rsimd_mask_t hit = rsimd_cmp_le(zero, p2sqr);
+		hit = rsimd_mask_and(hit, rsimd_cmp_gt(t, zero));
+		hit = rsimd_mask_and(hit, rsimd_cmp_lt(t, rsimd_set1(closest_t)));
+
+		unsigned int bits = rsimd_mask_bits(hit);
+
+		int remaining = first + count - base;
+		if (remaining < RSIMD_WIDTH) {
+			bits &= (1u << remaining) - 1;
+		}
+
+		if (bits == 0) {
+			continue;
+		}
+
+		real_t lanes[RSIMD_WIDTH];
+		rsimd_store(lanes, t);
+
+		for (int l = 0; l < RSIMD_WIDTH; l++) {
+			if ((bits & (1u << l)) && lanes[l] < closest_t) {
+				closest_t = lanes[l];
+				hit_slot = base + l;
+			}
+		}
+	}
+#else
+	for (int i = first; i < first + count; i++) {
+		real_t dx = ray->origin[0] - set->center_x[i];
+		real_t dy = ray->origin[1] - set->center_y[i];
+		real_t dz = ray->origin[2] - set->center_z[i];
+
+		real_t p1 = -(ray->direction[0] * dx + ray->direction[1] * dy + ray->direction[2] * dz);
+		real_t p2sqr = p1 * p1 - (dx * dx + dy * dy + dz * dz) + set->radius_sqr[i];
+
+		if (p2sqr < 0) {
+			continue;
+		}
+
+		real_t p2 = (real_t)sqrt(p2sqr);
+		real_t t = p1 - p2 > 0 ? p1 - p2 : p1 + p2;
+
+		if (t > 0 && t < closest_t) {
+			closest_t = t;
+			hit_slot = i;
+		}
+	}
+#endif
+
+	*p_t = closest_t;
+	return hit_slot;
+}
+
+int sphere_set_occluded(const sphere_set_t* set, int first, int count, const rte_ray_t* ray, real_t t_max) {
+#ifdef RSIMD_WIDTH
+	const rsimd_t zero = rsimd_set1(REAL(0.0));
+	const rsimd_t far = rsimd_set1(t_max);
+
+	const rsimd_t ox = rsimd_set1(ray->origin[0]);
+	const rsimd_t oy = rsimd_set1(ray->origin[1]);
+	const rsimd_t oz = rsimd_set1(ray->origin[2]);
+
+	const rsimd_t dir_x = rsimd_set1(ray->direction[0]);
+	const rsimd_t dir_y = rsimd_set1(ray->direction[1]);
+	const rsimd_t dir_z = rsimd_set1(ray->direction[2]);
+
+	for (int base = first; base < first + count; base += RSIMD_WIDTH) {
+		rsimd_t dx = rsimd_sub(ox, rsimd_load(set->center_x + base));
+		rsimd_t dy = rsimd_sub(oy, rsimd_load(set->center_y + base));
+		rsimd_t dz = rsimd_sub(oz, rsimd_load(set->center_z + base));
+
+		rsimd_t p1 = rsimd_sub(zero, rsimd_add(rsimd_add(rsimd_mul(dir_x, dx), rsimd_mul(dir_y, dy)), rsimd_mul(dir_z, dz)));
+		rsimd_t d2 = rsimd_add(rsimd_add(rsimd_mul(dx, dx), rsimd_mul(dy, dy)), rsimd_mul(dz, dz));
+		rsimd_t p2sqr = rsimd_add(rsimd_sub(rsimd_mul(p1, p1), d2), rsimd_load(set->radius_sqr + base));
+
+		rsimd_t p2 = rsimd_sqrt(rsimd_max(p2sqr, zero));
+		rsimd_t t_near = rsimd_sub(p1, p2);
+		rsimd_t t = rsimd_select(rsimd_cmp_gt(t_near, zero), rsimd_add(p1, p2), t_near);
+
+		rsimd_mask_t hit = rsimd_cmp_le(zero, p2sqr);
+		hit = rsimd_mask_and(hit, rsimd_cmp_gt(t, zero));
+		hit = rsimd_mask_and(hit, rsimd_cmp_lt(t, far));
+
+		unsigned int bits = rsimd_mask_bits(hit);
+
+		int remaining = first + count - base;
+		if (remaining < RSIMD_WIDTH) {
+			bits &= (1u << remaining) - 1;
+		}
+
+		if (bits != 0) {
+			return 1;
+		}
+	}
+#else
+	for (int i = first; i < first + count; i++) {
+		real_t dx = ray->origin[0] - set->center_x[i];
+		real_t dy = ray->origin[1] - set->center_y[i];
+		real_t dz = ray->origin[2] - set->center_z[i];
+
+		real_t p1 = -(ray->direction[0] * dx + ray->direction[1] * dy + ray->direction[2] * dz);
+		real_t p2sqr = p1 * p1 - (dx * dx + dy * dy + dz * dz) + set->radius_sqr[i];
+
+		if (p2sqr < 0) {
+			continue;
+		}
+
+		real_t p2 = (real_t)sqrt(p2sqr);
+		real_t t = p1 - p2 > 0 ? p1 - p2 : p1 + p2;
+
+		if (t > 0 && t < t_max) {
+			return 1;
+		}
+	}
+#endif
+
+	return 0;
+}
+
+void sphere_set_resolve(const sphere_set_t* set, int slot, const rte_ray_t* ray, real_t t, sphere_intersect_t* intersect) {
+	rvec3_t center = {set->center_x[slot], set->center_y[slot], set->center_z[slot]};
+
+	rvec3_mul_scalar(RVEC_OUT(intersect->point), ray->direction, t);
+	rvec3_add(RVEC_OUT(intersect->point), ray->origin, intersect->point);
+
+	rvec3_sub(RVEC_OUT(intersect->normal), intersect->point, center);
+	rvec3_normalize(RVEC_OUT(intersect->normal));
+
+	intersect->distance = t;
+}
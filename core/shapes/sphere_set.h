@@ -0,0 +1,53 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#ifndef RTEVERYWHERE_SPHERE_SET_H
+#define RTEVERYWHERE_SPHERE_SET_H
+
+#include "../math/real.h"
+#include "../math/vectors.h"
+#include "../math/ray.h"
+#include "../math/simd.h"
+
+#include "sphere.h"
+
+#ifdef RSIMD_WIDTH
+#define SPHERE_SET_WIDTH RSIMD_WIDTH
+#else
+#define SPHERE_SET_WIDTH 1
+#endif
+
+//
+// Structure of arrays copy of a sphere list, laid out for the wide intersection kernel
+// Only the data needed to find the nearest hit lives here, everything else stays in the source sphere_t array
+//
+typedef struct sphere_set {
+	real_t* center_x;
+	real_t* center_y;
+	real_t* center_z;
+	real_t* radius_sqr;
+
+	int* material;
+	int* sphere_index; // Index of the source sphere_t
+
+	int count;
+	int capacity; // Count rounded up to SPHERE_SET_WIDTH, the padding never hits
+} sphere_set_t;
+
+// Copies spheres into the set, order optionally remaps slot i to spheres[order[i]]
+// Returns 0 on allocation failure
+extern int sphere_set_build(sphere_set_t* set, const sphere_t* spheres, const int* order, int count);
+extern void sphere_set_free(sphere_set_t* set);
+
+// Finds the nearest hit among slots [first, first + count) that is closer than *p_t
+// On a hit, *p_t is updated and the slot is returned, otherwise -1
+extern int sphere_set_intersect(const sphere_set_t* set, int first, int count, const rte_ray_t* ray, real_t* p_t);
+
+// Returns 1 if any slot in [first, first + count) is hit within (0, t_max)
+extern int sphere_set_occluded(const sphere_set_t* set, int first, int count, const rte_ray_t* ray, real_t t_max);
+
+// Computes the point and normal for a hit found by sphere_set_intersect
+extern void sphere_set_resolve(const sphere_set_t* set, int slot, const rte_ray_t* ray, real_t t, sphere_intersect_t* intersect);
+
+#endif //RTEVERYWHERE_SPHERE_SET_H
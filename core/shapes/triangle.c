@@ -0,0 +1,101 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#include "triangle.h"
+
+void triangle_ray_setup(triangle_ray_t* dst, const rte_ray_t* ray) {
+	// Permute the axes so the largest direction component is z
+	int kz = 0;
+
+	for (int a = 1; a < 3; a++) {
+		real_t length = ray->direction[a] < 0 ? -ray->direction[a] : ray->direction[a];
+		real_t longest = ray->direction[kz] < 0 ? -ray->direction[kz] : ray->direction[kz];
+
+		if (length > longest) {
+			kz = a;
+		}
+	}
+
+	int kx = (kz + 1) % 3;
+	int ky = (kx + 1) % 3;
+
+	// Keep the winding intact
+	if (ray->direction[kz] < 0) {
+		int swap = kx;
+		kx = ky;
+		ky = swap;
+	}
+
+	dst->kx = kx;
+	dst->ky = ky;
+	dst->kz = kz;
+
+	dst->shear_x = ray->direction[kx] / ray->direction[kz];
+	dst->shear_y = ray->direction[ky] / ray->direction[kz];
+	dst->shear_z = REAL(1.0) / ray->direction[kz];
+}
+
+int triangle_ray_intersect(const triangle_ray_t* tri_ray, const rte_ray_t* ray, const rvec3_t v0, const rvec3_t v1, const rvec3_t v2, real_t* p_t, real_t* p_u, real_t* p_v) {
+	const int kx = tri_ray->kx;
+	const int ky = tri_ray->ky;
+	const int kz = tri_ray->kz;
+
+	rvec3_t a, b, c;
+	rvec3_sub(RVEC_OUT(a), v0, ray->origin);
+	rvec3_sub(RVEC_OUT(b), v1, ray->origin);
+	rvec3_sub(RVEC_OUT(c), v2, ray->origin);
+
+	// Shear and scale the vertices into ray space
+	real_t ax = a[kx] - tri_ray->shear_x * a[kz];
+	real_t ay = a[ky] - tri_ray->shear_y * a[kz];
+	real_t bx = b[kx] - tri_ray->shear_x * b[kz];
+	real_t by = b[ky] - tri_ray->shear_y * b[kz];
+	real_t cx = c[kx] - tri_ray->shear_x * c[kz];
+	real_t cy = c[ky] - tri_ray->shear_y * c[kz];
+
+	real_t u = cx * by - cy * bx;
+	real_t v = ax * cy - ay * cx;
+	real_t w = bx * ay - by * ax;
+
+	// Exactly zero means the ray grazes an edge, redo those in double so neighbours agree
+	if (u == 0 || v == 0 || w == 0) {
+		u = (real_t)((double)cx * (double)by - (double)cy * (double)bx);
+		v = (real_t)((double)ax * (double)cy - (double)ay * (double)cx);
+		w = (real_t)((double)bx * (double)ay - (double)by * (double)ax);
+	}
+
+	if ((u < 0 || v < 0 || w < 0) && (u > 0 || v > 0 || w > 0)) {
+		return 0;
+	}
+
+	real_t det = u + v + w;
+
+	if (det == 0) {
+		return 0;
+	}
+
+	real_t az = tri_ray->shear_z * a[kz];
+	real_t bz = tri_ray->shear_z * b[kz];
+	real_t cz = tri_ray->shear_z * c[kz];
+
+	real_t t = (u * az + v * bz + w * cz) / det;
+
+	if (!(t > 0 && t < *p_t)) {
+		return 0;
+	}
+
+	*p_t = t;
+	*p_u = v / det;
+	*p_v = w / det;
+
+	return 1;
+}
+
+void triangle_bounds(rte_aabb_t* dst, const rvec3_t v0, const rvec3_t v1, const rvec3_t v2) {
+	aabb_empty(dst);
+
+	aabb_grow_point(dst, v0);
+	aabb_grow_point(dst, v1);
+	aabb_grow_point(dst, v2);
+}
@@ -0,0 +1,37 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#ifndef RTEVERYWHERE_TRIANGLE_H
+#define RTEVERYWHERE_TRIANGLE_H
+
+#include "../math/real.h"
+#include "../math/vectors.h"
+#include "../math/ray.h"
+#include "../math/aabb.h"
+
+//
+// Watertight ray / triangle test (Woop, Benthin & Wald 2013)
+// Edges shared by two triangles are never missed by both, which matters for closed meshes
+//
+
+// Per-ray constants of the test, set up once and reused for every triangle the ray visits
+typedef struct triangle_ray {
+	int kx;
+	int ky;
+	int kz;
+
+	real_t shear_x;
+	real_t shear_y;
+	real_t shear_z;
+} triangle_ray_t;
+
+extern void triangle_ray_setup(triangle_ray_t* dst, const rte_ray_t* ray);
+
+// Two sided, on a hit within (0, *p_t) the distance is written to *p_t
+// p_u and p_v receive the barycentric weights of v1 and v2
+extern int triangle_ray_intersect(const triangle_ray_t* tri_ray, const rte_ray_t* ray, const rvec3_t v0, const rvec3_t v1, const rvec3_t v2, real_t* p_t, real_t* p_u, real_t* p_v);
+
+extern void triangle_bounds(rte_aabb_t* dst, const rvec3_t v0, const rvec3_t v1, const rvec3_t v2);
+
+#endif //RTEVERYWHERE_TRIANGLE_H
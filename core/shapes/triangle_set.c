@@ -0,0 +1,258 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#include "triangle_set.h"
+
+#include <stdlib.h>
+
+int triangle_set_build(triangle_set_t* set, const rvec3_t* positions, const int* indices, const int* order, int count) {
+	// Ranges may start anywhere, an extra lane group of padding keeps their last load in bounds
+	int capacity = ((count + TRIANGLE_SET_WIDTH - 1) / TRIANGLE_SET_WIDTH) * TRIANGLE_SET_WIDTH + TRIANGLE_SET_WIDTH;
+
+	char* block = (char*)malloc((sizeof(real_t) * 9 + sizeof(int)) * capacity);
+
+	if (block == NULL) {
+		set->count = 0;
+		set->capacity = 0;
+		set->vertices[0] = NULL;
+		return 0;
+	}
+
+	for (int c = 0; c < 9; c++) {
+		set->vertices[c] = (real_t*)block + c * capacity;
+	}
+
+	set->triangle_index = (int*)(set->vertices[8] + capacity);
+
+	set->count = count;
+	set->capacity = capacity;
+
+	for (int i = 0; i < capacity; i++) {
+		if (i >= count) {
+			// Degenerate, and masked off by the range checks anyway
+			for (int c = 0; c < 9; c++) {
+				set->vertices[c][i] = REAL(0.0);
+			}
+
+			set->triangle_index[i] = -1;
+			continue;
+		}
+
+		set->triangle_index[i] = order != NULL ? order[i] : i;
+	}
+
+	triangle_set_update(set, positions, indices);
+	return 1;
+}
+
+void triangle_set_update(triangle_set_t* set, const rvec3_t* positions, const int* indices) {
+	for (int i = 0; i < set->count; i++) {
+		int t = set->triangle_index[i];
+
+		for (int v = 0; v < 3; v++) {
+			int position = indices[t * 3 + v];
+
+			for (int a = 0; a < 3; a++) {
+				set->vertices[v * 3 + a][i] = positions[position][a];
+			}
+		}
+	}
+}
+
+void triangle_set_free(triangle_set_t* set) {
+	free(set->vertices[0]);
+
+	for (int c = 0; c < 9; c++) {
+		set->vertices[c] = NULL;
+	}
+
+	set->triangle_index = NULL;
+
+	set->count = 0;
+	set->capacity = 0;
+}
+
+static void triangle_set_fetch(const triangle_set_t* set, int slot, rvec3_out_t v0, rvec3_out_t v1, rvec3_out_t v2) {
+	for (int a = 0; a < 3; a++) {
+		RVEC_OUT_DEREF(v0)[a] = set->vertices[a][slot];
+		RVEC_OUT_DEREF(v1)[a] = set->vertices[3 + a][slot];
+		RVEC_OUT_DEREF(v2)[a] = set->vertices[6 + a][slot];
+	}
+}
+
+#ifdef RSIMD_WIDTH
+typedef struct triangle_lanes {
+	rsimd_t u;
+	rsimd_t v;
+	rsimd_t w;
+	rsimd_t t;
+
+	unsigned int hit_bits;
+	unsigned int edge_bits; // Lanes that graze an edge and must be redone by the scalar test
+} triangle_lanes_t;
+
+// Same math as triangle_ray_intersect, one triangle per lane
+static void triangle_set_test(triangle_lanes_t* lanes, const triangle_set_t* set, int base, const triangle_ray_t* tri_ray, const rte_ray_t* ray, rsimd_t t_max) {
+	const rsimd_t zero = rsimd_set1(REAL(0.0));
+
+	const int kx = tri_ray->kx;
+	const int ky = tri_ray->ky;
+	const int kz = tri_ray->kz;
+
+	const rsimd_t ox = rsimd_set1(ray->origin[kx]);
+	const rsimd_t oy = rsimd_set1(ray->origin[ky]);
+	const rsimd_t oz = rsimd_set1(ray->origin[kz]);
+
+	const rsimd_t shear_x = rsimd_set1(tri_ray->shear_x);
+	const rsimd_t shear_y = rsimd_set1(tri_ray->shear_y);
+	const rsimd_t shear_z = rsimd_set1(tri_ray->shear_z);
+
+	rsimd_t px[3], py[3], pz[3];
+
+	for (int v = 0; v < 3; v++) {
+		rsimd_t x = rsimd_sub(rsimd_load(set->vertices[v * 3 + kx] + base), ox);
+		rsimd_t y = rsimd_sub(rsimd_load(set->vertices[v * 3 + ky] + base), oy);
+		rsimd_t z = rsimd_sub(rsimd_load(set->vertices[v * 3 + kz] + base), oz);
+
+		px[v] = rsimd_sub(x, rsimd_mul(shear_x, z));
+		py[v] = rsimd_sub(y, rsimd_mul(shear_y, z));
+		pz[v] = rsimd_mul(shear_z, z);
+	}
+
+	rsimd_t u = rsimd_sub(rsimd_mul(px[2], py[1]), rsimd_mul(py[2], px[1]));
+	rsimd_t v = rsimd_sub(rsimd_mul(px[0], py[2]), rsimd_mul(py[0], px[2]));
+	rsimd_t w = rsimd_sub(rsimd_mul(px[1], py[0]), rsimd_mul(py[1], px[0]));
+
+	unsigned int nonzero = rsimd_mask_bits(rsimd_mask_or(rsimd_cmp_lt(u, zero), rsimd_cmp_gt(u, zero)));
+	nonzero &= rsimd_mask_bits(rsimd_mask_or(rsimd_cmp_lt(v, zero), rsimd_cmp_gt(v, zero)));
+	nonzero &= rsimd_mask_bits(rsimd_mask_or(rsimd_cmp_lt(w, zero), rsimd_cmp_gt(w, zero)));
+
+	rsimd_mask_t positive = rsimd_mask_and(rsimd_mask_and(rsimd_cmp_le(zero, u), rsimd_cmp_le(zero, v)), rsimd_cmp_le(zero, w));
+	rsimd_mask_t negative = rsimd_mask_and(rsimd_mask_and(rsimd_cmp_le(u, zero), rsimd_cmp_le(v, zero)), rsimd_cmp_le(w, zero));
+
+	rsimd_t det = rsimd_add(rsimd_add(u, v), w);
+	rsimd_t t = rsimd_div(rsimd_add(rsimd_add(rsimd_mul(u, pz[0]), rsimd_mul(v, pz[1])), rsimd_mul(w, pz[2])), det);
+
+	rsimd_mask_t hit = rsimd_mask_or(positive, negative);
+	hit = rsimd_mask_and(hit, rsimd_mask_or(rsimd_cmp_lt(det, zero), rsimd_cmp_gt(det, zero)));
+	hit = rsimd_mask_and(hit, rsimd_cmp_gt(t, zero));
+	hit = rsimd_mask_and(hit, rsimd_cmp_lt(t, t_max));
+
+	lanes->u = u;
+	lanes->v = v;
+	lanes->w = w;
+	lanes->t = t;
+
+	lanes->hit_bits = rsimd_mask_bits(hit) & nonzero;
+	lanes->edge_bits = ~nonzero & ((1u << RSIMD_WIDTH) - 1);
+}
+#endif
+
+int triangle_set_intersect(const triangle_set_t* set, int first, int count, const triangle_ray_t* tri_ray, const rte_ray_t* ray, real_t* p_t, real_t* p_u, real_t* p_v) {
+	int hit_slot = -1;
+	real_t closest_t = *p_t;
+
+#ifdef RSIMD_WIDTH
+	for (int base = first; base < first + count; base += RSIMD_WIDTH) {
+		triangle_lanes_t lanes;
+		triangle_set_test(&lanes, set, base, tri_ray, ray, rsimd_set1(closest_t));
+
+		int remaining = first + count - base;
+		if (remaining < RSIMD_WIDTH) {
+			lanes.hit_bits &= (1u << remaining) - 1;
+			lanes.edge_bits &= (1u << remaining) - 1;
+		}
+
+		if (lanes.hit_bits != 0) {
+			real_t t[RSIMD_WIDTH], v[RSIMD_WIDTH], w[RSIMD_WIDTH], u[RSIMD_WIDTH];
+
+			rsimd_store(t, lanes.t);
+			rsimd_store(u, lanes.u);
+			rsimd_store(v, lanes.v);
+			rsimd_store(w, lanes.w);
+
+			for (int l = 0; l < RSIMD_WIDTH; l++) {
+				if ((lanes.hit_bits & (1u << l)) && t[l] < closest_t) {
+					real_t det = u[l] + v[l] + w[l];
+
+					closest_t = t[l];
+					hit_slot = base + l;
+
+					*p_u = v[l] / det;
+					*p_v = w[l] / det;
+				}
+			}
+		}
+
+		for (int l = 0; l < RSIMD_WIDTH; l++) {
+			if (lanes.edge_bits & (1u << l)) {
+				rvec3_t v0, v1, v2;
+				triangle_set_fetch(set, base + l, RVEC_OUT(v0), RVEC_OUT(v1), RVEC_OUT(v2));
+
+				if (triangle_ray_intersect(tri_ray, ray, v0, v1, v2, &closest_t, p_u, p_v)) {
+					hit_slot = base + l;
+				}
+			}
+		}
+	}
+#else
+	for (int i = first; i < first + count; i++) {
+		rvec3_t v0, v1, v2;
+		triangle_set_fetch(set, i, RVEC_OUT(v0), RVEC_OUT(v1), RVEC_OUT(v2));
+
+		if (triangle_ray_intersect(tri_ray, ray, v0, v1, v2, &closest_t, p_u, p_v)) {
+			hit_slot = i;
+		}
+	}
+#endif
+
+	*p_t = closest_t;
+	return hit_slot;
+}
+
+int triangle_set_occluded(const triangle_set_t* set, int first, int count, const triangle_ray_t* tri_ray, const rte_ray_t* ray, real_t t_max) {
+	real_t t = t_max;
+	real_t u, v;
+
+#ifdef RSIMD_WIDTH
+	const rsimd_t far = rsimd_set1(t_max);
+
+	for (int base = first; base < first + count; base += RSIMD_WIDTH) {
+		triangle_lanes_t lanes;
+		triangle_set_test(&lanes, set, base, tri_ray, ray, far);
+
+		int remaining = first + count - base;
+		if (remaining < RSIMD_WIDTH) {
+			lanes.hit_bits &= (1u << remaining) - 1;
+			lanes.edge_bits &= (1u << remaining) - 1;
+		}
+
+		if (lanes.hit_bits != 0) {
+			return 1;
+		}
+
+		for (int l = 0; l < RSIMD_WIDTH; l++) {
+			if (lanes.edge_bits & (1u << l)) {
+				rvec3_t v0, v1, v2;
+				triangle_set_fetch(set, base + l, RVEC_OUT(v0), RVEC_OUT(v1), RVEC_OUT(v2));
+
+				if (triangle_ray_intersect(tri_ray, ray, v0, v1, v2, &t, &u, &v)) {
+					return 1;
+				}
+			}
+		}
+	}
+#else
+	for (int i = first; i < first + count; i++) {
+		rvec3_t v0, v1, v2;
+		triangle_set_fetch(set, i, RVEC_OUT(v0), RVEC_OUT(v1), RVEC_OUT(v2));
+
+		if (triangle_ray_intersect(tri_ray, ray, v0, v1, v2, &t, &u, &v)) {
+			return 1;
+		}
+	}
+#endif
+
+	return 0;
+}
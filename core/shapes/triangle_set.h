@@ -0,0 +1,48 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#ifndef RTEVERYWHERE_TRIANGLE_SET_H
+#define RTEVERYWHERE_TRIANGLE_SET_H
+
+#include "../math/real.h"
+#include "../math/vectors.h"
+#include "../math/ray.h"
+#include "../math/simd.h"
+
+#include "triangle.h"
+
+#ifdef RSIMD_WIDTH
+#define TRIANGLE_SET_WIDTH RSIMD_WIDTH
+#else
+#define TRIANGLE_SET_WIDTH 1
+#endif
+
+//
+// Structure of arrays copy of a triangle list for the wide watertight kernel, same layout rules as sphere_set_t
+//
+typedef struct triangle_set {
+	real_t* vertices[9]; // Axis a of corner v lives in vertices[v * 3 + a]
+
+	int* triangle_index; // Index of the source triangle
+
+	int count;
+	int capacity;
+} triangle_set_t;
+
+// Triangle i is made of positions[indices[i * 3 + 0..2]], order optionally remaps slot i to triangle order[i]
+// Returns 0 on allocation failure
+extern int triangle_set_build(triangle_set_t* set, const rvec3_t* positions, const int* indices, const int* order, int count);
+extern void triangle_set_free(triangle_set_t* set);
+
+// Recopies the vertices of every slot after the positions moved, the slot order is kept
+extern void triangle_set_update(triangle_set_t* set, const rvec3_t* positions, const int* indices);
+
+// Finds the nearest hit among slots [first, first + count) that is closer than *p_t
+// On a hit, *p_t and the barycentrics are updated and the slot is returned, otherwise -1
+extern int triangle_set_intersect(const triangle_set_t* set, int first, int count, const triangle_ray_t* tri_ray, const rte_ray_t* ray, real_t* p_t, real_t* p_u, real_t* p_v);
+
+// Returns 1 if any slot in [first, first + count) is hit within (0, t_max)
+extern int triangle_set_occluded(const triangle_set_t* set, int first, int count, const triangle_ray_t* tri_ray, const rte_ray_t* ray, real_t t_max);
+
+#endif //RTEVERYWHERE_TRIANGLE_SET_H
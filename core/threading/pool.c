@@ -0,0 +1,257 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#include "pool.h"
+
+#include <stdlib.h>
+
+struct rte_pool {
+	rte_thread_t** threads;
+	int thread_count;
+
+	rte_mutex_t* mutex;
+	rte_cond_t* work; // Workers sleep here while the queue is empty
+	rte_cond_t* done; // Waiters sleep here until their job finishes
+
+	rte_job_t* head;
+	rte_job_t* tail;
+
+	int quit;
+};
+
+//
+// Queue, every function here expects the pool mutex to be held
+//
+static void rte_pool_unlink(rte_pool_t* pool, rte_job_t* job) {
+	rte_job_t* previous = NULL;
+
+	for (rte_job_t* it = pool->head; it != NULL; previous = it, it = it->next) {
+		if (it != job) {
+			continue;
+		}
+
+		if (previous != NULL) {
+			previous->next = job->next;
+		} else {
+			pool->head = job->next;
+		}
+
+		if (pool->tail == job) {
+			pool->tail = previous;
+		}
+
+		job->next = NULL;
+		return;
+	}
+}
+
+// Hands out the next run of the job, the job leaves the queue once all of its runs are taken
+static int rte_pool_claim(rte_pool_t* pool, rte_job_t* job) {
+	int index = job->claimed++;
+
+	if (job->claimed == job->count) {
+		rte_pool_unlink(pool, job);
+	}
+
+	return index;
+}
+
+static void rte_pool_finish(rte_pool_t* pool, rte_job_t* job) {
+	int remaining = job->remaining - 1;
+	rte_atomic_store(&job->remaining, remaining);
+
+	// The waiter may free the job as soon as the mutex is released, so it isn't touched after this
+	if (remaining == 0) {
+		rte_cond_broadcast(pool->done);
+	}
+}
+
+//
+// Workers
+//
+static int rte_pool_worker(void* data) {
+	rte_pool_t* pool = (rte_pool_t*)data;
+
+	rte_mutex_lock(pool->mutex);
+
+	for (;;) {
+		while (!pool->quit && pool->head == NULL) {
+			rte_cond_wait(pool->work, pool->mutex);
+		}
+
+		if (pool->quit) {
+			break;
+		}
+
+		rte_job_t* job = pool->head;
+		int index = rte_pool_claim(pool, job);
+
+		rte_mutex_unlock(pool->mutex);
+		job->func(job->user, index);
+		rte_mutex_lock(pool->mutex);
+
+		rte_pool_finish(pool, job);
+	}
+
+	rte_mutex_unlock(pool->mutex);
+	return 0;
+}
+
+rte_pool_t* rte_pool_create(int thread_count) {
+#if defined(RTE_NO_THREADS)
+	// Workers would run to completion inside rte_thread_create, rte_job_wait does everything instead
+	thread_count = 0;
+#endif
+
+	if (thread_count < 0) {
+		thread_count = 0;
+	}
+
+	rte_pool_t* pool = (rte_pool_t*)calloc(1, sizeof(rte_pool_t));
+
+	if (pool == NULL) {
+		return NULL;
+	}
+
+	pool->threads = (rte_thread_t**)calloc(thread_count > 0 ? thread_count : 1, sizeof(rte_thread_t*));
+	pool->mutex = rte_mutex_create();
+	pool->work = rte_cond_create();
+	pool->done = rte_cond_create();
+
+	if (pool->threads == NULL || pool->mutex == NULL || pool->work == NULL || pool->done == NULL) {
+		rte_pool_destroy(pool);
+		return NULL;
+	}
+
+	for (int t = 0; t < thread_count; t++) {
+		rte_thread_t* thread = rte_thread_create(rte_pool_worker, pool);
+
+		// A smaller pool still works, the waiters pick up the slack
+		if (thread != NULL) {
+			pool->threads[pool->thread_count++] = thread;
+		}
+	}
+
+	return pool;
+}
+
+void rte_pool_destroy(rte_pool_t* pool) {
+	if (pool == NULL) {
+		return;
+	}
+
+	if (pool->mutex != NULL) {
+		rte_mutex_lock(pool->mutex);
+		pool->quit = 1;
+
+		if (pool->work != NULL) {
+			rte_cond_broadcast(pool->work);
+		}
+
+		rte_mutex_unlock(pool->mutex);
+	}
+
+	for (int t = 0; t < pool->thread_count; t++) {
+		rte_thread_join(pool->threads[t]);
+	}
+
+	rte_cond_destroy(pool->done);
+	rte_cond_destroy(pool->work);
+	rte_mutex_destroy(pool->mutex);
+
+	free(pool->threads);
+	free(pool);
+}
+
+int rte_pool_thread_count(const rte_pool_t* pool) {
+	return pool->thread_count;
+}
+
+static rte_pool_t* shared_pool = NULL;
+static volatile int shared_state = 0; // 0 = not created, 1 = being created, 2 = ready
+
+rte_pool_t* rte_pool_shared() {
+	if (rte_atomic_load(&shared_state) == 2) {
+		return shared_pool;
+	}
+
+	if (rte_atomic_cas(&shared_state, 0, 1)) {
+		shared_pool = rte_pool_create(rte_thread_count() - 1);
+		rte_atomic_store(&shared_state, 2);
+
+		return shared_pool;
+	}
+
+	// Someone else is creating it, that only takes as long as starting the threads
+	while (rte_atomic_load(&shared_state) != 2) {
+		rte_thread_sleep(0);
+	}
+
+	return shared_pool;
+}
+
+//
+// Jobs
+//
+void rte_pool_submit(rte_pool_t* pool, rte_job_t* job, rte_job_func_t func, void* user, int count) {
+	job->func = func;
+	job->user = user;
+	job->count = count > 0 ? count : 0;
+	job->claimed = 0;
+	job->remaining = job->count;
+	job->pool = pool;
+	job->next = NULL;
+
+	if (job->count == 0) {
+		return;
+	}
+
+	rte_mutex_lock(pool->mutex);
+
+	if (pool->tail != NULL) {
+		pool->tail->next = job;
+	} else {
+		pool->head = job;
+	}
+
+	pool->tail = job;
+
+	if (job->count > 1) {
+		rte_cond_broadcast(pool->work);
+	} else {
+		rte_cond_signal(pool->work);
+	}
+
+	rte_mutex_unlock(pool->mutex);
+}
+
+int rte_job_done(rte_job_t* job) {
+	return rte_atomic_load(&job->remaining) == 0;
+}
+
+void rte_job_wait(rte_job_t* job) {
+	if (job->count == 0) {
+		return;
+	}
+
+	rte_pool_t* pool = job->pool;
+
+	rte_mutex_lock(pool->mutex);
+
+	while (job->claimed < job->count) {
+		int index = rte_pool_claim(pool, job);
+
+		rte_mutex_unlock(pool->mutex);
+		job->func(job->user, index);
+		rte_mutex_lock(pool->mutex);
+
+		rte_pool_finish(pool, job);
+	}
+
+	while (job->remaining > 0) {
+		rte_cond_wait(pool->done, pool->mutex);
+	}
+
+	rte_mutex_unlock(pool->mutex);
+}
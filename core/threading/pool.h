@@ -0,0 +1,62 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#ifndef RTEVERYWHERE_POOL_H
+#define RTEVERYWHERE_POOL_H
+
+#include "thread.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Persistent worker pool
+// Threads are started once and sleep on a condition variable until a job is submitted
+// A job runs its function count times, each run gets its own index in [0, count)
+//
+
+typedef struct rte_pool rte_pool_t;
+
+typedef void (*rte_job_func_t)(void* user, int index);
+
+// Owned by the submitter and acts as the job's future, it must stay alive until the job is done
+typedef struct rte_job {
+	rte_job_func_t func;
+	void* user;
+
+	int count;
+	int claimed;             // Runs handed out so far, guarded by the pool
+	volatile int remaining;  // Runs not yet finished
+
+	rte_pool_t* pool;
+	struct rte_job* next;
+} rte_job_t;
+
+// Starts thread_count workers, 0 is allowed and leaves every run to rte_job_wait. Returns NULL on failure
+extern rte_pool_t* rte_pool_create(int thread_count);
+
+// Stops and joins every worker, the pool must have no unfinished jobs
+extern void rte_pool_destroy(rte_pool_t* pool);
+
+extern int rte_pool_thread_count(const rte_pool_t* pool);
+
+// Process wide pool used by rte_parallel_for, created on first use with one thread less than the hardware has
+extern rte_pool_t* rte_pool_shared();
+
+// Queues the job and wakes the workers, returns immediately
+extern void rte_pool_submit(rte_pool_t* pool, rte_job_t* job, rte_job_func_t func, void* user, int count);
+
+// Non blocking, 1 once every run of the job has returned
+extern int rte_job_done(rte_job_t* job);
+
+// Runs whatever the workers haven't picked up yet on the calling thread, then sleeps until the job is done
+// Because the caller helps, waiting from inside another job can't deadlock the pool
+extern void rte_job_wait(rte_job_t* job);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif //RTEVERYWHERE_POOL_H
@@ -0,0 +1,386 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#include "thread.h"
+#include "pool.h"
+
+#include <stdlib.h>
+
+#if defined(RTE_NO_THREADS)
+#elif defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+struct rte_thread {
+	rte_thread_func_t func;
+	void* user;
+	int result;
+
+#if defined(RTE_NO_THREADS)
+#elif defined(_WIN32)
+	HANDLE handle;
+#else
+	pthread_t handle;
+#endif
+};
+
+struct rte_mutex {
+#if defined(RTE_NO_THREADS)
+	int locked;
+#elif defined(_WIN32)
+	CRITICAL_SECTION section;
+#else
+	pthread_mutex_t mutex;
+#endif
+};
+
+struct rte_cond {
+#if defined(RTE_NO_THREADS)
+	int signalled;
+#elif defined(_WIN32)
+	CONDITION_VARIABLE variable;
+#else
+	pthread_cond_t cond;
+#endif
+};
+
+//
+// Threads
+//
+#if defined(RTE_NO_THREADS)
+#elif defined(_WIN32)
+static DWORD WINAPI rte_thread_entry(LPVOID data) {
+	rte_thread_t* thread = (rte_thread_t*)data;
+	thread->result = thread->func(thread->user);
+
+	return 0;
+}
+#else
+static void* rte_thread_entry(void* data) {
+	rte_thread_t* thread = (rte_thread_t*)data;
+	thread->result = thread->func(thread->user);
+
+	return NULL;
+}
+#endif
+
+rte_thread_t* rte_thread_create(rte_thread_func_t func, void* user) {
+	rte_thread_t* thread = (rte_thread_t*)malloc(sizeof(rte_thread_t));
+
+	if (thread == NULL) {
+		return NULL;
+	}
+
+	thread->func = func;
+	thread->user = user;
+	thread->result = 0;
+
+#if defined(RTE_NO_THREADS)
+	// Without threads the work simply happens up front
+	thread->result = func(user);
+#elif defined(_WIN32)
+	thread->handle = CreateThread(NULL, 0, rte_thread_entry, thread, 0, NULL);
+
+	if (thread->handle == NULL) {
+		free(thread);
+		return NULL;
+	}
+#else
+	if (pthread_create(&thread->handle, NULL, rte_thread_entry, thread) != 0) {
+		free(thread);
+		return NULL;
+	}
+#endif
+
+	return thread;
+}
+
+int rte_thread_join(rte_thread_t* thread) {
+#if defined(RTE_NO_THREADS)
+#elif defined(_WIN32)
+	WaitForSingleObject(thread->handle, INFINITE);
+	CloseHandle(thread->handle);
+#else
+	pthread_join(thread->handle, NULL);
+#endif
+
+	int result = thread->result;
+	free(thread);
+
+	return result;
+}
+
+int rte_thread_count() {
+	int count = 1;
+
+#if defined(RTE_NO_THREADS)
+#elif defined(_WIN32)
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+
+	count = (int)info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+	count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+
+	return count < 1 ? 1 : count;
+}
+
+void rte_thread_sleep(int milliseconds) {
+#if defined(RTE_NO_THREADS)
+	// Nothing else could make progress in the meantime
+#elif defined(_WIN32)
+	Sleep((DWORD)milliseconds);
+#else
+	usleep((useconds_t)milliseconds * 1000);
+#endif
+}
+
+//
+// Mutexes
+//
+rte_mutex_t* rte_mutex_create() {
+	rte_mutex_t* mutex = (rte_mutex_t*)malloc(sizeof(rte_mutex_t));
+
+	if (mutex == NULL) {
+		return NULL;
+	}
+
+#if defined(RTE_NO_THREADS)
+	mutex->locked = 0;
+#elif defined(_WIN32)
+	InitializeCriticalSection(&mutex->section);
+#else
+	pthread_mutex_init(&mutex->mutex, NULL);
+#endif
+
+	return mutex;
+}
+
+void rte_mutex_destroy(rte_mutex_t* mutex) {
+	if (mutex == NULL) {
+		return;
+	}
+
+#if defined(RTE_NO_THREADS)
+#elif defined(_WIN32)
+	DeleteCriticalSection(&mutex->section);
+#else
+	pthread_mutex_destroy(&mutex->mutex);
+#endif
+
+	free(mutex);
+}
+
+void rte_mutex_lock(rte_mutex_t* mutex) {
+#if defined(RTE_NO_THREADS)
+	mutex->locked = 1;
+#elif defined(_WIN32)
+	EnterCriticalSection(&mutex->section);
+#else
+	pthread_mutex_lock(&mutex->mutex);
+#endif
+}
+
+void rte_mutex_unlock(rte_mutex_t* mutex) {
+#if defined(RTE_NO_THREADS)
+	mutex->locked = 0;
+#elif defined(_WIN32)
+	LeaveCriticalSection(&mutex->section);
+#else
+	pthread_mutex_unlock(&mutex->mutex);
+#endif
+}
+
+//
+// Condition variables
+//
+rte_cond_t* rte_cond_create() {
+	rte_cond_t* cond = (rte_cond_t*)malloc(sizeof(rte_cond_t));
+
+	if (cond == NULL) {
+		return NULL;
+	}
+
+#if defined(RTE_NO_THREADS)
+	cond->signalled = 0;
+#elif defined(_WIN32)
+	InitializeConditionVariable(&cond->variable);
+#else
+	pthread_cond_init(&cond->cond, NULL);
+#endif
+
+	return cond;
+}
+
+void rte_cond_destroy(rte_cond_t* cond) {
+	if (cond == NULL) {
+		return;
+	}
+
+#if defined(RTE_NO_THREADS)
+#elif defined(_WIN32)
+	// Win32 condition variables need no cleanup
+#else
+	pthread_cond_destroy(&cond->cond);
+#endif
+
+	free(cond);
+}
+
+void rte_cond_wait(rte_cond_t* cond, rte_mutex_t* mutex) {
+#if defined(RTE_NO_THREADS)
+	// Nobody else could ever signal, callers recheck their condition and move on
+	cond->signalled = 0;
+#elif defined(_WIN32)
+	SleepConditionVariableCS(&cond->variable, &mutex->section, INFINITE);
+#else
+	pthread_cond_wait(&cond->cond, &mutex->mutex);
+#endif
+}
+
+void rte_cond_signal(rte_cond_t* cond) {
+#if defined(RTE_NO_THREADS)
+	cond->signalled = 1;
+#elif defined(_WIN32)
+	WakeConditionVariable(&cond->variable);
+#else
+	pthread_cond_signal(&cond->cond);
+#endif
+}
+
+void rte_cond_broadcast(rte_cond_t* cond) {
+#if defined(RTE_NO_THREADS)
+	cond->signalled = 1;
+#elif defined(_WIN32)
+	WakeAllConditionVariable(&cond->variable);
+#else
+	pthread_cond_broadcast(&cond->cond);
+#endif
+}
+
+//
+// Atomics
+//
+int rte_atomic_load(volatile int* p) {
+#if defined(RTE_NO_THREADS)
+	return *p;
+#elif defined(_WIN32)
+	return (int)InterlockedCompareExchange((volatile LONG*)p, 0, 0);
+#else
+	return __atomic_load_n(p, __ATOMIC_SEQ_CST);
+#endif
+}
+
+void rte_atomic_store(volatile int* p, int value) {
+#if defined(RTE_NO_THREADS)
+	*p = value;
+#elif defined(_WIN32)
+	InterlockedExchange((volatile LONG*)p, (LONG)value);
+#else
+	__atomic_store_n(p, value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+int rte_atomic_add(volatile int* p, int value) {
+#if defined(RTE_NO_THREADS)
+	int previous = *p;
+	*p += value;
+
+	return previous;
+#elif defined(_WIN32)
+	return (int)InterlockedExchangeAdd((volatile LONG*)p, (LONG)value);
+#else
+	return __atomic_fetch_add(p, value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+int rte_atomic_cas(volatile int* p, int expected, int desired) {
+#if defined(RTE_NO_THREADS)
+	if (*p != expected) {
+		return 0;
+	}
+
+	*p = desired;
+	return 1;
+#elif defined(_WIN32)
+	return InterlockedCompareExchange((volatile LONG*)p, (LONG)desired, (LONG)expected) == (LONG)expected;
+#else
+	return __atomic_compare_exchange_n(p, &expected, desired, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+#endif
+}
+
+//
+// Parallel for
+//
+typedef struct rte_parallel_job {
+	rte_parallel_func_t func;
+	void* user;
+
+	int count;
+	int grain;
+
+	volatile int next;
+} rte_parallel_job_t;
+
+static void rte_parallel_worker(void* data, int index) {
+	(void)index;
+
+	rte_parallel_job_t* job = (rte_parallel_job_t*)data;
+
+	for (;;) {
+		int begin = rte_atomic_add(&job->next, job->grain);
+
+		if (begin >= job->count) {
+			break;
+		}
+
+		int end = begin + job->grain < job->count ? begin + job->grain : job->count;
+		job->func(job->user, begin, end);
+	}
+}
+
+void rte_parallel_for(int count, int grain, rte_parallel_func_t func, void* user) {
+	if (count <= 0) {
+		return;
+	}
+
+	if (grain < 1) {
+		grain = 1;
+	}
+
+	rte_parallel_job_t job;
+
+	job.func = func;
+	job.user = user;
+	job.count = count;
+	job.grain = grain;
+	job.next = 0;
+
+	int chunks = (count + grain - 1) / grain;
+
+	rte_pool_t* pool = rte_pool_shared();
+	int helpers = pool != NULL ? rte_pool_thread_count(pool) : 0;
+
+	if (helpers > chunks - 1) {
+		helpers = chunks - 1;
+	}
+
+	// Helpers that never get a thread are run by the wait, they find no chunks left by then
+	rte_job_t pool_job;
+
+	if (helpers > 0) {
+		rte_pool_submit(pool, &pool_job, rte_parallel_worker, &job, helpers);
+	}
+
+	rte_parallel_worker(&job, 0);
+
+	if (helpers > 0) {
+		rte_job_wait(&pool_job);
+	}
+}
@@ -0,0 +1,79 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#ifndef RTEVERYWHERE_THREAD_H
+#define RTEVERYWHERE_THREAD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//
+// Minimal threading layer over pthreads / Win32
+// Define RTE_NO_THREADS on targets without either, everything then runs on the calling thread
+//
+
+typedef struct rte_thread rte_thread_t;
+typedef struct rte_mutex rte_mutex_t;
+typedef struct rte_cond rte_cond_t;
+
+typedef int (*rte_thread_func_t)(void* user);
+
+// Returns NULL if the thread couldn't be started
+extern rte_thread_t* rte_thread_create(rte_thread_func_t func, void* user);
+
+// Waits for the thread to exit, frees it and returns the value its function returned
+extern int rte_thread_join(rte_thread_t* thread);
+
+// Number of hardware threads, always at least 1
+extern int rte_thread_count();
+
+extern void rte_thread_sleep(int milliseconds);
+
+extern rte_mutex_t* rte_mutex_create();
+extern void rte_mutex_destroy(rte_mutex_t* mutex);
+
+extern void rte_mutex_lock(rte_mutex_t* mutex);
+extern void rte_mutex_unlock(rte_mutex_t* mutex);
+
+//
+// Condition variables
+// Waits may wake spuriously, always recheck the condition under the mutex
+//
+extern rte_cond_t* rte_cond_create();
+extern void rte_cond_destroy(rte_cond_t* cond);
+
+// Atomically unlocks the mutex and sleeps until signalled, the mutex is held again on return
+extern void rte_cond_wait(rte_cond_t* cond, rte_mutex_t* mutex);
+
+extern void rte_cond_signal(rte_cond_t* cond);
+extern void rte_cond_broadcast(rte_cond_t* cond);
+
+//
+// Atomics
+// All of these are sequentially consistent
+//
+extern int rte_atomic_load(volatile int* p);
+extern void rte_atomic_store(volatile int* p, int value);
+
+// Returns the value before the add
+extern int rte_atomic_add(volatile int* p, int value);
+
+// Stores desired if *p still holds expected, returns 1 if it did
+extern int rte_atomic_cas(volatile int* p, int expected, int desired);
+
+//
+// Parallel for
+//
+typedef void (*rte_parallel_func_t)(void* user, int begin, int end);
+
+// Splits [0, count) into chunks of grain and hands them out to the shared pool (see pool.h), the caller included
+// Returns once every chunk has been processed
+extern void rte_parallel_for(int count, int grain, rte_parallel_func_t func, void* user);
+
+#ifdef __cplusplus
+};
+#endif
+
+#endif //RTEVERYWHERE_THREAD_H
@@ -0,0 +1,165 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#include "aovs.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define AOVS_PATH_MAX 1024
+
+// Depth, normal and albedo
+#define AOVS_REAL_PLANES 7
+
+// Material, primitive and bounces
+#define AOVS_INT_PLANES 3
+
+int headless_aovs_init(headless_aovs_t* aovs, int width, int height) {
+	memset(aovs, 0, sizeof(headless_aovs_t));
+
+	size_t pixels = (size_t)width * height;
+
+	aovs->reals = (real_t*)malloc(sizeof(real_t) * pixels * AOVS_REAL_PLANES);
+	aovs->ints = (int*)malloc(sizeof(int) * pixels * AOVS_INT_PLANES);
+
+	if (aovs->reals == NULL || aovs->ints == NULL) {
+		headless_aovs_free(aovs);
+		return 0;
+	}
+
+	aovs->planes.depth = aovs->reals;
+
+	for (int c = 0; c < 3; c++) {
+		aovs->planes.normal[c] = aovs->reals + pixels * (1 + c);
+		aovs->planes.albedo[c] = aovs->reals + pixels * (4 + c);
+	}
+
+	aovs->planes.material = aovs->ints;
+	aovs->planes.primitive_id = aovs->ints + pixels;
+	aovs->planes.bounces = aovs->ints + pixels * 2;
+	aovs->planes.stride = width;
+
+	aovs->width = width;
+	aovs->height = height;
+
+	return 1;
+}
+
+void headless_aovs_free(headless_aovs_t* aovs) {
+	free(aovs->reals);
+	free(aovs->ints);
+
+	memset(aovs, 0, sizeof(headless_aovs_t));
+}
+
+// Spreads neighbouring ids far apart so touching surfaces are told apart, -1 (nothing) stays black
+static void headless_aovs_id_color(rvec3_out_t dst, int id) {
+	if (id < 0) {
+		rvec3_copy(dst, (rvec3_t) {0, 0, 0});
+		return;
+	}
+
+	unsigned int hash = (unsigned int)id * 2654435761u;
+	hash ^= hash >> 15;
+
+	RVEC_OUT_DEREF(dst)[0] = (real_t)((hash >> 0) & 0xFF) / REAL(255.0);
+	RVEC_OUT_DEREF(dst)[1] = (real_t)((hash >> 8) & 0xFF) / REAL(255.0);
+	RVEC_OUT_DEREF(dst)[2] = (real_t)((hash >> 16) & 0xFF) / REAL(255.0);
+}
+
+static int headless_aovs_write_one(const headless_aovs_t* aovs, const char* prefix, const char* name, const rvec3_t* colors, unsigned char* rgb) {
+	char path[AOVS_PATH_MAX];
+	snprintf(path, sizeof(path), "%s_%s.bmp", prefix, name);
+
+	headless_quantize(rgb, colors, aovs->width * aovs->height);
+
+	if (!headless_write_rgb(path, rgb, aovs->width, aovs->height)) {
+		printf("Error: Failed to write '%s'!\n", path);
+		return 1;
+	}
+
+	printf("Wrote %s\n", path);
+	return 0;
+}
+
+int headless_aovs_write(const headless_aovs_t* aovs, const char* prefix, int max_bounces) {
+	const rte_aovs_t* planes = &aovs->planes;
+	int pixels = aovs->width * aovs->height;
+
+	rvec3_t* colors = (rvec3_t*)malloc(sizeof(rvec3_t) * pixels);
+	unsigned char* rgb = (unsigned char*)malloc((size_t)pixels * 3);
+
+	if (colors == NULL || rgb == NULL) {
+		printf("Error: Failed to allocate the AOV images!\n");
+
+		free(colors);
+		free(rgb);
+
+		return 6;
+	}
+
+	int failed = 0;
+
+	// Nearest is white, the farthest hit is black like the sky
+	real_t far = 0;
+
+	for (int p = 0; p < pixels; p++) {
+		far = planes->depth[p] > far ? planes->depth[p] : far;
+	}
+
+	for (int p = 0; p < pixels; p++) {
+		real_t shade = planes->depth[p] > 0 ? REAL(1.0) - planes->depth[p] / far : 0;
+		rvec3_copy(RVEC_OUT(colors[p]), (rvec3_t) {shade, shade, shade});
+	}
+
+	failed += headless_aovs_write_one(aovs, prefix, "depth", colors, rgb);
+
+	for (int p = 0; p < pixels; p++) {
+		for (int c = 0; c < 3; c++) {
+			colors[p][c] = planes->normal[c][p] * REAL(0.5) + REAL(0.5);
+		}
+
+		// The sky has no normal, leave it black instead of the color of a sideways one
+		if (planes->material[p] < 0) {
+			rvec3_copy(RVEC_OUT(colors[p]), (rvec3_t) {0, 0, 0});
+		}
+	}
+
+	failed += headless_aovs_write_one(aovs, prefix, "normal", colors, rgb);
+
+	for (int p = 0; p < pixels; p++) {
+		for (int c = 0; c < 3; c++) {
+			colors[p][c] = planes->albedo[c][p];
+		}
+
+		rvec3_saturate(RVEC_OUT(colors[p]));
+	}
+
+	failed += headless_aovs_write_one(aovs, prefix, "albedo", colors, rgb);
+
+	for (int p = 0; p < pixels; p++) {
+		headless_aovs_id_color(RVEC_OUT(colors[p]), planes->material[p]);
+	}
+
+	failed += headless_aovs_write_one(aovs, prefix, "material", colors, rgb);
+
+	for (int p = 0; p < pixels; p++) {
+		headless_aovs_id_color(RVEC_OUT(colors[p]), planes->primitive_id[p]);
+	}
+
+	failed += headless_aovs_write_one(aovs, prefix, "primitive", colors, rgb);
+
+	for (int p = 0; p < pixels; p++) {
+		real_t shade = max_bounces > 0 ? (real_t)planes->bounces[p] / (real_t)max_bounces : 0;
+		rvec3_copy(RVEC_OUT(colors[p]), (rvec3_t) {shade, shade, shade});
+	}
+
+	failed += headless_aovs_write_one(aovs, prefix, "bounces", colors, rgb);
+
+	free(colors);
+	free(rgb);
+
+	return failed;
+}
@@ -0,0 +1,33 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#ifndef RTEVERYWHERE_AOVS_H
+#define RTEVERYWHERE_AOVS_H
+
+#include "headless.h"
+
+//
+// AOV output
+// Single frame renders can write what each pixel first hit next to its color, every AOV as its own BMP named after
+// the --aovs prefix (prefix_depth.bmp, prefix_normal.bmp, ...). Ids are shown as colors, depth and bounces as gray
+//
+
+typedef struct headless_aovs {
+	rte_aovs_t planes;
+
+	real_t* reals; // Backs the depth, normal and albedo planes
+	int* ints; // Backs the material, primitive and bounce planes
+
+	int width;
+	int height;
+} headless_aovs_t;
+
+// Allocates every plane for a frame of the given size, returns 0 on failure
+extern int headless_aovs_init(headless_aovs_t* aovs, int width, int height);
+extern void headless_aovs_free(headless_aovs_t* aovs);
+
+// Writes every plane, max_bounces is what the bounce plane is scaled by, returns how many files failed
+extern int headless_aovs_write(const headless_aovs_t* aovs, const char* prefix, int max_bounces);
+
+#endif //RTEVERYWHERE_AOVS_H
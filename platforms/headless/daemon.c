@@ -0,0 +1,902 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#include "daemon.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <net/socket.h>
+#include <render/scheduler.h>
+#include <threading/pool.h>
+#include <threading/thread.h>
+
+// Request line and headers, bodies are never read
+#define DAEMON_MAX_REQUEST 8192
+
+#define DAEMON_MAX_QUEUE 64
+#define DAEMON_MAX_PIXELS (4096 * 4096)
+
+// Longest part of a bad query pair echoed back in the error
+#define DAEMON_MAX_NAME 64
+
+// Clients get this long to send their request
+#define DAEMON_READ_TIMEOUT_MS 10000
+
+// Response headers, the body is sent as is after them
+#define DAEMON_MAX_HEADERS 1024
+
+typedef struct daemon_job {
+	headless_options_t options;
+	char query[DAEMON_MAX_REQUEST]; // Decoded in place, the string options point into it
+
+	double time_queued;
+
+	// Filled in by the render thread
+	int done;
+	const char* error;
+	char* image;
+	size_t image_size;
+
+	int batch_size;
+	int scene_reused;
+	double queue_ms;
+	double render_ms;
+
+	struct daemon_job* next;
+} daemon_job_t;
+
+typedef struct daemon {
+	const headless_options_t* options;
+
+	// Everything below is guarded by mutex
+	rte_mutex_t* mutex;
+	rte_cond_t* changed; // Broadcast when jobs are queued or finished and when shutting down
+
+	daemon_job_t* queue; // Highest priority first
+	int queue_length;
+	int quit;
+
+	int jobs_done;
+	int batches;
+	int scene_builds;
+} daemon_t;
+
+typedef struct daemon_connection {
+	daemon_t* daemon;
+	rte_socket_t* socket;
+	rte_thread_t* thread;
+	volatile int finished;
+
+	struct daemon_connection* next;
+} daemon_connection_t;
+
+//
+// HTTP
+//
+static int daemon_respond(rte_socket_t* socket, const char* status, const char* type, const char* extra, const void* body, size_t size) {
+	char headers[DAEMON_MAX_HEADERS];
+
+	int length = snprintf(headers, sizeof(headers),
+		"HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\nConnection: close\r\n%s\r\n",
+		status, type, size, extra != NULL ? extra : ""
+	);
+
+	if (length < 0 || length >= (int)sizeof(headers)) {
+		return 0;
+	}
+
+	return rte_socket_send_all(socket, headers, (size_t)length) && (size == 0 || rte_socket_send_all(socket, body, size));
+}
+
+static int daemon_respond_text(rte_socket_t* socket, const char* status, const char* text) {
+	return daemon_respond(socket, status, "text/plain", NULL, text, strlen(text));
+}
+
+// Reads up to the blank line ending the headers, returns 0 if the client hung up, stalled or sent too much
+static int daemon_read_request(rte_socket_t* socket, char* request, size_t capacity) {
+	size_t length = 0;
+
+	while (length < capacity - 1) {
+		int received = rte_socket_recv(socket, request + length, capacity - 1 - length);
+
+		if (received <= 0) {
+			return 0;
+		}
+
+		length += (size_t)received;
+		request[length] = '\0';
+
+		if (strstr(request, "\r\n\r\n") != NULL) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+static int daemon_hex(char c) {
+	if (c >= '0' && c <= '9') {
+		return c - '0';
+	}
+
+	if (c >= 'a' && c <= 'f') {
+		return c - 'a' + 10;
+	}
+
+	if (c >= 'A' && c <= 'F') {
+		return c - 'A' + 10;
+	}
+
+	return -1;
+}
+
+// Percent decodes in place, returns 0 on a malformed escape
+static int daemon_url_decode(char* text) {
+	char* dst = text;
+
+	for (const char* src = text; *src != '\0'; src++) {
+		if (*src == '+') {
+			*dst++ = ' ';
+		} else if (*src == '%') {
+			int high = daemon_hex(src[1]);
+			int low = high >= 0 ? daemon_hex(src[2]) : -1;
+
+			if (low < 0 || (high == 0 && low == 0)) {
+				return 0;
+			}
+
+			*dst++ = (char)(high << 4 | low);
+			src += 2;
+		} else {
+			*dst++ = *src;
+		}
+	}
+
+	*dst = '\0';
+	return 1;
+}
+
+//
+// Jobs
+//
+
+// Options that only the daemon decides, like threads and output paths, can't be set by a request
+static int daemon_allowed(const char* name) {
+	static const char* names[] = {
+		"width", "height", "samples", "position", "rotation", "accel", "builder", "seed", "bounces", "min-energy", "aces",
+		"wavefront", "adaptive", "adaptive-threshold", "denoise", "priority"
+	};
+
+	for (size_t n = 0; n < sizeof(names) / sizeof(names[0]); n++) {
+		if (strcmp(name, names[n]) == 0) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+// Fills the job from the query string, returns 0 and why it can't be rendered in error otherwise
+static int daemon_parse_job(daemon_job_t* job, const headless_options_t* defaults, const char* query, char* error, size_t error_size) {
+	headless_default_options(&job->options);
+
+	job->options.threads = defaults->threads;
+	job->options.tile_size = defaults->tile_size;
+
+	// Paths on the daemon's machine aren't up to a request, every job gets the model the daemon was started with
+	job->options.model = defaults->model;
+
+	strncpy(job->query, query, sizeof(job->query) - 1);
+	job->query[sizeof(job->query) - 1] = '\0';
+
+	char* pair = job->query;
+
+	while (pair != NULL && *pair != '\0') {
+		char* next = strchr(pair, '&');
+
+		if (next != NULL) {
+			*next++ = '\0';
+		}
+
+		char* value = strchr(pair, '=');
+
+		if (value != NULL) {
+			*value++ = '\0';
+		}
+
+		if (!daemon_url_decode(pair) || (value != NULL && !daemon_url_decode(value))) {
+			snprintf(error, error_size, "Malformed query string");
+			return 0;
+		}
+
+		if (!daemon_allowed(pair)) {
+			snprintf(error, error_size, "Unknown parameter '%.*s'", DAEMON_MAX_NAME, pair);
+			return 0;
+		}
+
+		// Flags may leave out the value
+		if (value == NULL && headless_option_is_flag(pair)) {
+			value = "1";
+		}
+
+		if (headless_set_option(&job->options, pair, value) != HEADLESS_OPTION_OK) {
+			snprintf(error, error_size, "Invalid value for '%.*s'", DAEMON_MAX_NAME, pair);
+			return 0;
+		}
+
+		pair = next;
+	}
+
+	const char* invalid = headless_check_options(&job->options);
+
+	if (invalid != NULL) {
+		snprintf(error, error_size, "%s", invalid);
+		return 0;
+	}
+
+	if ((long)job->options.width * job->options.height > DAEMON_MAX_PIXELS) {
+		snprintf(error, error_size, "Too many pixels");
+		return 0;
+	}
+
+	return 1;
+}
+
+// Requests with the same geometry can share one built scene
+static int daemon_same_scene(const headless_options_t* a, const headless_options_t* b) {
+	const char* model_a = a->model != NULL ? a->model : "";
+	const char* model_b = b->model != NULL ? b->model : "";
+
+	return a->seed == b->seed && a->builder == b->builder && strcmp(model_a, model_b) == 0;
+}
+
+// Expects the mutex to be held
+static void daemon_enqueue(daemon_t* daemon, daemon_job_t* job) {
+	// Goes behind every job of the same priority, so those stay first come first served
+	daemon_job_t** link = &daemon->queue;
+
+	while (*link != NULL && (*link)->options.priority >= job->options.priority) {
+		link = &(*link)->next;
+	}
+
+	job->next = *link;
+	*link = job;
+
+	daemon->queue_length++;
+	rte_cond_broadcast(daemon->changed);
+}
+
+// Takes the front job and every queued job sharing its scene, in queue order. Expects the mutex to be held
+static daemon_job_t* daemon_take_batch(daemon_t* daemon) {
+	daemon_job_t* batch = daemon->queue;
+	daemon_job_t* tail = batch;
+
+	daemon->queue = batch->next;
+	batch->next = NULL;
+	daemon->queue_length--;
+
+	daemon_job_t** link = &daemon->queue;
+
+	while (*link != NULL) {
+		daemon_job_t* job = *link;
+
+		if (!daemon_same_scene(&job->options, &batch->options)) {
+			link = &job->next;
+			continue;
+		}
+
+		*link = job->next;
+		daemon->queue_length--;
+
+		job->next = NULL;
+		tail->next = job;
+		tail = job;
+	}
+
+	return batch;
+}
+
+typedef struct daemon_renderer {
+	daemon_t* daemon;
+	rte_pool_t* pool;
+
+	headless_scene_t scene;
+	headless_options_t scene_options; // What the scene was built from, only the geometry fields matter
+	int scene_built;
+
+	rvec3_t* frame;
+	unsigned char* rgb;
+	size_t frame_pixels;
+} daemon_renderer_t;
+
+// Returns the error for the job or NULL once its image is encoded
+static const char* daemon_render_job(daemon_renderer_t* renderer, daemon_job_t* job) {
+	const headless_options_t* options = &job->options;
+	size_t pixels = (size_t)options->width * options->height;
+
+	// The frame only ever grows, so a stream of similar requests allocates nothing
+	if (pixels > renderer->frame_pixels) {
+		free(renderer->frame);
+		free(renderer->rgb);
+
+		renderer->frame = (rvec3_t*)malloc(sizeof(rvec3_t) * pixels);
+		renderer->rgb = (unsigned char*)malloc(pixels * 3);
+		renderer->frame_pixels = renderer->frame != NULL && renderer->rgb != NULL ? pixels : 0;
+
+		if (renderer->frame_pixels == 0) {
+			return "Out of memory";
+		}
+	}
+
+	headless_render_t render;
+	rte_scheduler_t scheduler;
+
+	if (!headless_render_init(&render, options)) {
+		return "Out of memory";
+	}
+
+	if (!rte_scheduler_init(&scheduler, options->width, options->height, options->tile_size, options->threads)) {
+		headless_render_free(&render);
+		return "Out of memory";
+	}
+
+	headless_scene_frame(&renderer->scene, options);
+
+	render.trace = renderer->scene.trace;
+	render.frame = renderer->frame;
+
+	rte_scheduler_run_pool(&scheduler, renderer->pool, headless_render_tile, &render);
+
+	rte_scheduler_free(&scheduler);
+	headless_render_free(&render);
+
+	if (!headless_denoise(renderer->frame, renderer->scene.trace, options)) {
+		return "Out of memory";
+	}
+
+	headless_quantize(renderer->rgb, (const rvec3_t*)renderer->frame, (int)pixels);
+	job->image = headless_encode_rgb(renderer->rgb, options->width, options->height, &job->image_size);
+
+	return job->image != NULL ? NULL : "Out of memory";
+}
+
+static void daemon_render_batch(daemon_renderer_t* renderer, daemon_job_t* batch) {
+	daemon_t* daemon = renderer->daemon;
+
+	int batch_size = 0;
+
+	for (daemon_job_t* job = batch; job != NULL; job = job->next) {
+		batch_size++;
+	}
+
+	// The last scene is kept built, so a batch following one with the same geometry skips the build too
+	int reused = renderer->scene_built && daemon_same_scene(&renderer->scene_options, &batch->options);
+	const char* scene_error = NULL;
+
+	if (!reused) {
+		if (renderer->scene_built) {
+			headless_scene_free(&renderer->scene);
+			renderer->scene_built = 0;
+		}
+
+		if (headless_scene_build(&renderer->scene, &batch->options)) {
+			renderer->scene_options = batch->options;
+			renderer->scene_built = 1;
+		} else {
+			headless_scene_free(&renderer->scene);
+			scene_error = "Failed to build the scene";
+		}
+	}
+
+	int first = 1;
+
+	for (daemon_job_t* job = batch; job != NULL;) {
+		daemon_job_t* next = job->next;
+
+		double time_start = headless_seconds();
+		const char* error = scene_error != NULL ? scene_error : daemon_render_job(renderer, job);
+
+		rte_mutex_lock(daemon->mutex);
+
+		job->error = error;
+		job->batch_size = batch_size;
+		job->scene_reused = reused || !first;
+		job->queue_ms = (time_start - job->time_queued) * 1000.0;
+		job->render_ms = (headless_seconds() - time_start) * 1000.0;
+		job->done = 1;
+
+		daemon->jobs_done++;
+		rte_cond_broadcast(daemon->changed);
+
+		// The job belongs to its connection from here on
+		rte_mutex_unlock(daemon->mutex);
+
+		first = 0;
+		job = next;
+	}
+
+	rte_mutex_lock(daemon->mutex);
+
+	daemon->batches++;
+	daemon->scene_builds += !reused;
+
+	rte_mutex_unlock(daemon->mutex);
+}
+
+static int daemon_render_thread(void* user) {
+	daemon_renderer_t* renderer = (daemon_renderer_t*)user;
+	daemon_t* daemon = renderer->daemon;
+
+	rte_mutex_lock(daemon->mutex);
+
+	for (;;) {
+		while (daemon->queue == NULL && !daemon->quit) {
+			rte_cond_wait(daemon->changed, daemon->mutex);
+		}
+
+		// Shutting down still finishes what was queued
+		if (daemon->queue == NULL) {
+			break;
+		}
+
+		daemon_job_t* batch = daemon_take_batch(daemon);
+
+		rte_mutex_unlock(daemon->mutex);
+		daemon_render_batch(renderer, batch);
+		rte_mutex_lock(daemon->mutex);
+	}
+
+	rte_mutex_unlock(daemon->mutex);
+	return 0;
+}
+
+//
+// Connections
+//
+static void daemon_serve_render(daemon_t* daemon, rte_socket_t* socket, const char* query) {
+	daemon_job_t* job = (daemon_job_t*)calloc(1, sizeof(daemon_job_t));
+
+	if (job == NULL) {
+		daemon_respond_text(socket, "503 Service Unavailable", "Out of memory\n");
+		return;
+	}
+
+	char error[300];
+
+	if (!daemon_parse_job(job, daemon->options, query, error, sizeof(error) - 1)) {
+		strcat(error, "\n");
+
+		daemon_respond_text(socket, "400 Bad Request", error);
+		free(job);
+		return;
+	}
+
+	job->time_queued = headless_seconds();
+
+	rte_mutex_lock(daemon->mutex);
+
+	int accepted = !daemon->quit && daemon->queue_length < DAEMON_MAX_QUEUE;
+
+	if (accepted) {
+		daemon_enqueue(daemon, job);
+
+		while (!job->done) {
+			rte_cond_wait(daemon->changed, daemon->mutex);
+		}
+	}
+
+	rte_mutex_unlock(daemon->mutex);
+
+	if (!accepted) {
+		daemon_respond_text(socket, "503 Service Unavailable", daemon->quit ? "Shutting down\n" : "Queue is full\n");
+	} else if (job->error != NULL) {
+		char text[300];
+		snprintf(text, sizeof(text), "%s\n", job->error);
+
+		daemon_respond_text(socket, "500 Internal Server Error", text);
+	} else {
+		char extra[256];
+
+		snprintf(extra, sizeof(extra),
+			"X-Batch-Size: %i\r\nX-Scene-Reused: %i\r\nX-Queue-Ms: %.2f\r\nX-Render-Ms: %.2f\r\n",
+			job->batch_size, job->scene_reused, job->queue_ms, job->render_ms
+		);
+
+		daemon_respond(socket, "200 OK", "image/bmp", extra, job->image, job->image_size);
+	}
+
+	free(job->image);
+	free(job);
+}
+
+static void daemon_serve_status(daemon_t* daemon, rte_socket_t* socket) {
+	char text[256];
+
+	rte_mutex_lock(daemon->mutex);
+
+	snprintf(text, sizeof(text), "queued %i\nrendered %i\nbatches %i\nscene_builds %i\n",
+		daemon->queue_length, daemon->jobs_done, daemon->batches, daemon->scene_builds
+	);
+
+	rte_mutex_unlock(daemon->mutex);
+
+	daemon_respond_text(socket, "200 OK", text);
+}
+
+static int daemon_connection_thread(void* user) {
+	daemon_connection_t* connection = (daemon_connection_t*)user;
+	daemon_t* daemon = connection->daemon;
+	rte_socket_t* socket = connection->socket;
+
+	char request[DAEMON_MAX_REQUEST];
+	char method[16];
+	char target[DAEMON_MAX_REQUEST];
+
+	rte_socket_set_timeout(socket, DAEMON_READ_TIMEOUT_MS);
+
+	if (!daemon_read_request(socket, request, sizeof(request))) {
+		daemon_respond_text(socket, "400 Bad Request", "Incomplete request\n");
+	} else if (sscanf(request, "%15s %8191s HTTP/", method, target) != 2) {
+		daemon_respond_text(socket, "400 Bad Request", "Malformed request line\n");
+	} else {
+		char* query = strchr(target, '?');
+
+		if (query != NULL) {
+			*query++ = '\0';
+		} else {
+			query = "";
+		}
+
+		int get = strcmp(method, "GET") == 0;
+		int post = strcmp(method, "POST") == 0;
+
+		if (strcmp(target, "/render") == 0) {
+			if (get || post) {
+				daemon_serve_render(daemon, socket, query);
+			} else {
+				daemon_respond_text(socket, "405 Method Not Allowed", "Use GET\n");
+			}
+		} else if (strcmp(target, "/status") == 0) {
+			daemon_serve_status(daemon, socket);
+		} else if (strcmp(target, "/shutdown") == 0) {
+			if (post) {
+				rte_mutex_lock(daemon->mutex);
+
+				daemon->quit = 1;
+				rte_cond_broadcast(daemon->changed);
+
+				rte_mutex_unlock(daemon->mutex);
+
+				daemon_respond_text(socket, "200 OK", "Shutting down\n");
+			} else {
+				daemon_respond_text(socket, "405 Method Not Allowed", "Use POST\n");
+			}
+		} else {
+			daemon_respond_text(socket, "404 Not Found", "Unknown path\n");
+		}
+	}
+
+	rte_socket_close(socket);
+	rte_atomic_store(&connection->finished, 1);
+
+	return 0;
+}
+
+// Joins finished connections, or all of them when everything is shutting down
+static daemon_connection_t* daemon_reap(daemon_connection_t* connections, int all) {
+	daemon_connection_t** link = &connections;
+
+	while (*link != NULL) {
+		daemon_connection_t* connection = *link;
+
+		if (!all && !rte_atomic_load(&connection->finished)) {
+			link = &connection->next;
+			continue;
+		}
+
+		rte_thread_join(connection->thread);
+
+		*link = connection->next;
+		free(connection);
+	}
+
+	return connections;
+}
+
+int daemon_serve(const headless_options_t* options) {
+	daemon_t daemon;
+	memset(&daemon, 0, sizeof(daemon));
+
+	daemon.options = options;
+	daemon.mutex = rte_mutex_create();
+	daemon.changed = rte_cond_create();
+
+	daemon_renderer_t renderer;
+	memset(&renderer, 0, sizeof(renderer));
+
+	renderer.daemon = &daemon;
+
+	// Started once and kept warm for every request, the render thread is one of the workers
+	renderer.pool = rte_pool_create(options->threads - 1);
+
+	if (daemon.mutex == NULL || daemon.changed == NULL || renderer.pool == NULL) {
+		printf("Error: Failed to start the render threads!\n");
+		return 1;
+	}
+
+	rte_socket_t* listener = rte_socket_listen(options->daemon);
+
+	if (listener == NULL) {
+		printf("Error: Failed to listen on '%s'!\n", options->daemon);
+		return 1;
+	}
+
+	rte_thread_t* render_thread = rte_thread_create(daemon_render_thread, &renderer);
+
+	if (render_thread == NULL) {
+		printf("Error: Failed to start the render threads!\n");
+		return 1;
+	}
+
+	printf("Serving renders on %s with %i threads\n", options->daemon, options->threads);
+
+	daemon_connection_t* connections = NULL;
+
+	for (;;) {
+		rte_mutex_lock(daemon.mutex);
+		int quit = daemon.quit;
+		rte_mutex_unlock(daemon.mutex);
+
+		if (quit) {
+			break;
+		}
+
+		connections = daemon_reap(connections, 0);
+
+		if (rte_socket_wait(listener, 100) != 1) {
+			continue;
+		}
+
+		rte_socket_t* socket = rte_socket_accept(listener);
+		daemon_connection_t* connection = (daemon_connection_t*)calloc(1, sizeof(daemon_connection_t));
+
+		if (socket == NULL || connection == NULL) {
+			rte_socket_close(socket);
+			free(connection);
+			continue;
+		}
+
+		connection->daemon = &daemon;
+		connection->socket = socket;
+		connection->thread = rte_thread_create(daemon_connection_thread, connection);
+
+		if (connection->thread == NULL) {
+			rte_socket_close(socket);
+			free(connection);
+			continue;
+		}
+
+		connection->next = connections;
+		connections = connection;
+	}
+
+	rte_socket_close(listener);
+
+	// Queued renders still finish and reach their clients
+	rte_thread_join(render_thread);
+	daemon_reap(connections, 1);
+
+	printf("Rendered %i requests in %i batches with %i scene builds\n", daemon.jobs_done, daemon.batches, daemon.scene_builds);
+
+	if (renderer.scene_built) {
+		headless_scene_free(&renderer.scene);
+	}
+
+	free(renderer.frame);
+	free(renderer.rgb);
+	rte_pool_destroy(renderer.pool);
+
+	rte_cond_destroy(daemon.changed);
+	rte_mutex_destroy(daemon.mutex);
+
+	return 0;
+}
+
+//
+// Client
+//
+
+// Appends "&name=value" with the value percent encoded, returns 0 once the query is full
+static int daemon_append(char* query, size_t capacity, const char* name, const char* value) {
+	size_t length = strlen(query);
+	int written = snprintf(query + length, capacity - length, "%s%s=", length > 0 ? "&" : "", name);
+
+	if (written < 0 || (size_t)written >= capacity - length) {
+		return 0;
+	}
+
+	length += (size_t)written;
+
+	for (const unsigned char* c = (const unsigned char*)value; *c != '\0'; c++) {
+		int plain = (*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z') || (*c >= '0' && *c <= '9') || strchr("-_.~,", *c) != NULL;
+
+		if (length + (plain ? 1 : 3) >= capacity) {
+			return 0;
+		}
+
+		if (plain) {
+			query[length++] = (char)*c;
+		} else {
+			length += (size_t)sprintf(query + length, "%%%02X", *c);
+		}
+	}
+
+	query[length] = '\0';
+	return 1;
+}
+
+static int daemon_append_int(char* query, size_t capacity, const char* name, long value) {
+	char text[32];
+	snprintf(text, sizeof(text), "%li", value);
+
+	return daemon_append(query, capacity, name, text);
+}
+
+static int daemon_append_vec3(char* query, size_t capacity, const char* name, const rvec3_t vec) {
+	char text[96];
+	snprintf(text, sizeof(text), "%.9g,%.9g,%.9g", (double)vec[0], (double)vec[1], (double)vec[2]);
+
+	return daemon_append(query, capacity, name, text);
+}
+
+static int daemon_append_real(char* query, size_t capacity, const char* name, real_t value) {
+	char text[32];
+	snprintf(text, sizeof(text), "%.9g", (double)value);
+
+	return daemon_append(query, capacity, name, text);
+}
+
+int daemon_request(const headless_options_t* options) {
+	static const char* accels[] = {"none", "bvh", "qbvh"};
+	static const char* builders[] = {"sah", "lbvh", "treelets"};
+
+	char query[DAEMON_MAX_REQUEST - 64];
+	query[0] = '\0';
+
+	int fits = daemon_append_int(query, sizeof(query), "width", options->width)
+		&& daemon_append_int(query, sizeof(query), "height", options->height)
+		&& daemon_append_int(query, sizeof(query), "samples", options->samples)
+		&& daemon_append(query, sizeof(query), "accel", accels[options->accel])
+		&& daemon_append(query, sizeof(query), "builder", builders[options->builder])
+		&& daemon_append_int(query, sizeof(query), "seed", (long)options->seed)
+		&& daemon_append_int(query, sizeof(query), "bounces", options->bounces)
+		&& daemon_append_real(query, sizeof(query), "min-energy", options->min_energy)
+		&& daemon_append_int(query, sizeof(query), "aces", options->aces)
+		&& daemon_append_int(query, sizeof(query), "wavefront", options->wavefront)
+		&& daemon_append_int(query, sizeof(query), "adaptive", options->adaptive)
+		&& daemon_append_real(query, sizeof(query), "adaptive-threshold", options->adaptive_threshold)
+		&& daemon_append_int(query, sizeof(query), "denoise", options->denoise)
+		&& daemon_append_int(query, sizeof(query), "priority", options->priority)
+		&& (!options->has_position || daemon_append_vec3(query, sizeof(query), "position", options->position))
+		&& (!options->has_rotation || daemon_append_vec3(query, sizeof(query), "rotation", options->rotation));
+
+	if (!fits) {
+		printf("Error: Request is too long!\n");
+		return 1;
+	}
+
+	rte_socket_t* socket = rte_socket_connect(options->client);
+
+	if (socket == NULL) {
+		printf("Error: Failed to connect to a daemon on '%s'!\n", options->client);
+		return 1;
+	}
+
+	char request[DAEMON_MAX_REQUEST];
+	snprintf(request, sizeof(request), "GET /render?%s HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n", query);
+
+	double time_request = headless_seconds();
+
+	if (!rte_socket_send_all(socket, request, strlen(request))) {
+		printf("Error: Failed to send the request!\n");
+		rte_socket_close(socket);
+		return 1;
+	}
+
+	// The daemon closes the connection after the body, so everything up to that is the response
+	char* response = NULL;
+	size_t length = 0;
+	size_t capacity = 0;
+
+	for (;;) {
+		if (length + 65536 > capacity) {
+			capacity = capacity > 0 ? capacity * 2 : 1 << 20;
+			char* grown = (char*)realloc(response, capacity + 1);
+
+			if (grown == NULL) {
+				free(response);
+				rte_socket_close(socket);
+
+				printf("Error: Out of memory reading the response!\n");
+				return 1;
+			}
+
+			response = grown;
+		}
+
+		int received = rte_socket_recv(socket, response + length, capacity - length);
+
+		if (received <= 0) {
+			break;
+		}
+
+		length += (size_t)received;
+	}
+
+	rte_socket_close(socket);
+	time_request = headless_seconds() - time_request;
+
+	if (response == NULL) {
+		printf("Error: No response from the daemon!\n");
+		return 1;
+	}
+
+	response[length] = '\0';
+
+	char* body = strstr(response, "\r\n\r\n");
+	int status = 0;
+
+	if (body == NULL || sscanf(response, "HTTP/%*s %i", &status) != 1) {
+		printf("Error: Malformed response from the daemon!\n");
+		free(response);
+		return 1;
+	}
+
+	body[2] = '\0';
+	body += 4;
+
+	size_t body_size = length - (size_t)(body - response);
+
+	if (status != 200) {
+		printf("Error: Daemon answered %i: %.*s", status, (int)body_size, body);
+		free(response);
+		return 1;
+	}
+
+	int batch_size = 0;
+	int reused = 0;
+	double render_ms = 0;
+
+	const char* header = strstr(response, "X-Batch-Size: ");
+	batch_size = header != NULL ? atoi(header + 14) : 0;
+
+	header = strstr(response, "X-Scene-Reused: ");
+	reused = header != NULL ? atoi(header + 16) : 0;
+
+	header = strstr(response, "X-Render-Ms: ");
+	render_ms = header != NULL ? atof(header + 13) : 0;
+
+	FILE* file = fopen(options->output, "wb");
+	int written = file != NULL && fwrite(body, 1, body_size, file) == body_size;
+
+	if (file != NULL) {
+		written = fclose(file) == 0 && written;
+	}
+
+	free(response);
+
+	if (!written) {
+		printf("Error: Failed to write '%s'!\n", options->output);
+		return 1;
+	}
+
+	printf("Rendered in %.2fms of a %.2fms request (batch of %i, scene %s)\n",
+		render_ms, time_request * 1000.0, batch_size, reused ? "reused" : "built"
+	);
+
+	printf("Wrote %s\n", options->output);
+	return 0;
+}
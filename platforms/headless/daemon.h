@@ -0,0 +1,27 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#ifndef RTEVERYWHERE_DAEMON_H
+#define RTEVERYWHERE_DAEMON_H
+
+#include "headless.h"
+
+//
+// Render service
+// A long running process answering HTTP on options->daemon (host:port or unix:/path)
+//   GET /render?width=320&height=240&seed=4&...  Renders with the named options and answers with the BMP
+//   GET /status                                  Queue and cache counters as text
+//   POST /shutdown                               Finishes the queued renders and exits
+// Render parameters are the command line options without dashes, plus priority (higher goes first)
+// Queued requests that share their geometry (seed, builder and model) are rendered back to back on one built scene,
+// and the last scene stays built for whatever comes next. Every render runs on the same pool of threads
+//
+
+// Serves until told to shut down, returns the exit code
+extern int daemon_serve(const headless_options_t* options);
+
+// Requests a render of the options from the daemon at options->client and writes it to options->output, returns the exit code
+extern int daemon_request(const headless_options_t* options);
+
+#endif //RTEVERYWHERE_DAEMON_H
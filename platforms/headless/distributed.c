@@ -0,0 +1,797 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#include "distributed.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <net/socket.h>
+#include <render/scheduler.h>
+#include <threading/thread.h>
+
+//
+// Protocol
+// Every message is a big endian header { u32 type, u32 size } followed by size bytes of payload
+//
+#define DISTRIBUTED_MAGIC 0x52544557 // "RTEW"
+#define DISTRIBUTED_VERSION 4
+
+#define MESSAGE_HELLO 1  // Worker -> coordinator { magic, version }
+#define MESSAGE_JOB 2    // Coordinator -> worker, the render settings, see job_write
+#define MESSAGE_TILE 3   // Coordinator -> worker { id, x, y, width, height }
+#define MESSAGE_RESULT 4 // Worker -> coordinator { id, compressed size } + compressed RGB
+#define MESSAGE_DONE 5   // Coordinator -> worker, nothing left to render
+
+#define MESSAGE_HEADER_SIZE 8
+#define MESSAGE_MAX_SIZE (64 * 1024 * 1024)
+#define MESSAGE_MAX_PATH 4096
+
+// Tiles a worker holds at once, so the next one is already there when it finishes the last
+#define DISTRIBUTED_IN_FLIGHT 2
+
+// How long a worker keeps trying to reach a coordinator that isn't up yet
+#define WORKER_CONNECT_ATTEMPTS 50
+#define WORKER_CONNECT_DELAY_MS 100
+
+static void put_u32(unsigned char* dst, uint32_t value) {
+	dst[0] = (unsigned char)(value >> 24);
+	dst[1] = (unsigned char)(value >> 16);
+	dst[2] = (unsigned char)(value >> 8);
+	dst[3] = (unsigned char)value;
+}
+
+static uint32_t get_u32(const unsigned char* src) {
+	return ((uint32_t)src[0] << 24) | ((uint32_t)src[1] << 16) | ((uint32_t)src[2] << 8) | (uint32_t)src[3];
+}
+
+static void put_u64(unsigned char* dst, uint64_t value) {
+	put_u32(dst, (uint32_t)(value >> 32));
+	put_u32(dst + 4, (uint32_t)value);
+}
+
+static uint64_t get_u64(const unsigned char* src) {
+	return ((uint64_t)get_u32(src) << 32) | get_u32(src + 4);
+}
+
+static void put_float(unsigned char* dst, float value) {
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	put_u32(dst, bits);
+}
+
+static float get_float(const unsigned char* src) {
+	uint32_t bits = get_u32(src);
+
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+
+	return value;
+}
+
+static int send_message(rte_socket_t* socket, uint32_t type, const void* payload, uint32_t size) {
+	unsigned char header[MESSAGE_HEADER_SIZE];
+
+	put_u32(header, type);
+	put_u32(header + 4, size);
+
+	return rte_socket_send_all(socket, header, sizeof(header)) && (size == 0 || rte_socket_send_all(socket, payload, size));
+}
+
+// Returns the payload, NULL once the connection fails or the message is malformed. The caller frees it
+static unsigned char* recv_message(rte_socket_t* socket, uint32_t* p_type, uint32_t* p_size) {
+	unsigned char header[MESSAGE_HEADER_SIZE];
+
+	if (!rte_socket_recv_all(socket, header, sizeof(header))) {
+		return NULL;
+	}
+
+	*p_type = get_u32(header);
+	*p_size = get_u32(header + 4);
+
+	if (*p_size > MESSAGE_MAX_SIZE) {
+		return NULL;
+	}
+
+	// Always at least one byte so an empty payload still comes back non NULL
+	unsigned char* payload = (unsigned char*)malloc(*p_size + 1);
+
+	if (payload == NULL || !rte_socket_recv_all(socket, payload, *p_size)) {
+		free(payload);
+		return NULL;
+	}
+
+	return payload;
+}
+
+//
+// Tile compression
+// Each byte is replaced by its difference to the same channel of the previous pixel, which turns the smooth gradients
+// most tiles are made of into long runs of zeros, and the result is then PackBits run length coded
+//
+static size_t tile_compress_bound(size_t size) {
+	return size + (size + 127) / 128;
+}
+
+static size_t tile_compress(unsigned char* dst, const unsigned char* rgb, size_t size) {
+	unsigned char* delta = (unsigned char*)malloc(size > 0 ? size : 1);
+
+	if (delta == NULL) {
+		return 0;
+	}
+
+	for (size_t b = 0; b < size; b++) {
+		delta[b] = (unsigned char)(rgb[b] - (b >= 3 ? rgb[b - 3] : 0));
+	}
+
+	size_t out = 0;
+	size_t b = 0;
+
+	while (b < size) {
+		size_t run = 1;
+
+		while (b + run < size && run < 128 && delta[b + run] == delta[b]) {
+			run++;
+		}
+
+		// Runs of three or more are cheaper as a repeat, 257 - length in the control byte
+		if (run >= 3) {
+			dst[out++] = (unsigned char)(257 - run);
+			dst[out++] = delta[b];
+
+			b += run;
+			continue;
+		}
+
+		// Literals go on until the next run worth encoding, length - 1 in the control byte
+		size_t start = b;
+
+		while (b < size && b - start < 128) {
+			if (b + 2 < size && delta[b] == delta[b + 1] && delta[b] == delta[b + 2]) {
+				break;
+			}
+
+			b++;
+		}
+
+		dst[out++] = (unsigned char)(b - start - 1);
+		memcpy(&dst[out], &delta[start], b - start);
+		out += b - start;
+	}
+
+	free(delta);
+	return out;
+}
+
+// Returns 0 if the data doesn't decode to exactly size bytes
+static int tile_decompress(unsigned char* rgb, size_t size, const unsigned char* src, size_t src_size) {
+	size_t out = 0;
+	size_t in = 0;
+
+	while (in < src_size) {
+		unsigned int control = src[in++];
+
+		if (control < 128) {
+			size_t length = control + 1;
+
+			if (in + length > src_size || out + length > size) {
+				return 0;
+			}
+
+			memcpy(&rgb[out], &src[in], length);
+
+			in += length;
+			out += length;
+		} else if (control > 128) {
+			size_t length = 257 - control;
+
+			if (in >= src_size || out + length > size) {
+				return 0;
+			}
+
+			memset(&rgb[out], src[in++], length);
+			out += length;
+		}
+	}
+
+	if (out != size) {
+		return 0;
+	}
+
+	for (size_t b = 3; b < size; b++) {
+		rgb[b] = (unsigned char)(rgb[b] + rgb[b - 3]);
+	}
+
+	return 1;
+}
+
+//
+// Job settings
+// Only what changes the image is sent, workers keep their own thread counts
+//
+#define JOB_FIXED_SIZE (4 * 5 + 8 + 4 * 4 + 4 * 6 + 4 * 3)
+
+static uint32_t job_write(unsigned char* dst, const headless_options_t* options) {
+	const char* model = options->model != NULL ? options->model : "";
+	uint32_t model_length = (uint32_t)strlen(model);
+
+	put_u32(dst + 0, (uint32_t)options->width);
+	put_u32(dst + 4, (uint32_t)options->height);
+	put_u32(dst + 8, (uint32_t)options->samples);
+	put_u32(dst + 12, (uint32_t)options->accel);
+	put_u32(dst + 16, (uint32_t)options->builder);
+	put_u64(dst + 20, (uint64_t)options->seed); // unsigned long is 64 bits on most targets
+	put_u32(dst + 28, (uint32_t)options->bounces);
+	put_u32(dst + 32, (uint32_t)options->aces);
+	put_u32(dst + 36, (uint32_t)(options->has_position | options->has_rotation << 1));
+	put_u32(dst + 40, model_length);
+
+	for (int c = 0; c < 3; c++) {
+		put_float(dst + 44 + c * 4, (float)options->position[c]);
+		put_float(dst + 56 + c * 4, (float)options->rotation[c]);
+	}
+
+	put_u32(dst + 68, (uint32_t)options->adaptive);
+	put_float(dst + 72, (float)options->adaptive_threshold);
+	put_float(dst + 76, (float)options->min_energy);
+
+	memcpy(dst + JOB_FIXED_SIZE, model, model_length);
+	return JOB_FIXED_SIZE + model_length;
+}
+
+// Model receives the path, it has to hold MESSAGE_MAX_PATH bytes
+static int job_read(headless_options_t* options, char* model, const unsigned char* src, uint32_t size) {
+	if (size < JOB_FIXED_SIZE) {
+		return 0;
+	}
+
+	uint32_t model_length = get_u32(src + 40);
+
+	if (model_length >= MESSAGE_MAX_PATH || JOB_FIXED_SIZE + model_length != size) {
+		return 0;
+	}
+
+	// Enums are range checked before the cast, the rest goes through the same checks as the command line below
+	uint32_t accel = get_u32(src + 12);
+	uint32_t builder = get_u32(src + 16);
+	uint64_t seed = get_u64(src + 20);
+
+	if (accel > (uint32_t)RTE_ACCEL_QBVH || builder > (uint32_t)RTE_BUILDER_LBVH_TREELETS || seed != (unsigned long)seed) {
+		return 0;
+	}
+
+	options->width = (int)get_u32(src + 0);
+	options->height = (int)get_u32(src + 4);
+	options->samples = (int)get_u32(src + 8);
+	options->accel = (rte_accel_e)accel;
+	options->builder = (rte_builder_e)builder;
+	options->seed = (unsigned long)seed;
+	options->bounces = (int)get_u32(src + 28);
+	options->aces = (int)get_u32(src + 32);
+
+	uint32_t flags = get_u32(src + 36);
+	options->has_position = (flags & 1) != 0;
+	options->has_rotation = (flags & 2) != 0;
+
+	for (int c = 0; c < 3; c++) {
+		options->position[c] = (real_t)get_float(src + 44 + c * 4);
+		options->rotation[c] = (real_t)get_float(src + 56 + c * 4);
+	}
+
+	options->adaptive = (int)get_u32(src + 68);
+	options->adaptive_threshold = (real_t)get_float(src + 72);
+	options->min_energy = (real_t)get_float(src + 76);
+
+	memcpy(model, src + JOB_FIXED_SIZE, model_length);
+	model[model_length] = '\0';
+
+	options->model = model;
+
+	// Catches non-positive or oversized resolutions, samples other than 1 or 4 and out of range adaptive settings
+	return headless_check_options(options) == NULL;
+}
+
+//
+// Coordinator
+//
+typedef struct coordinator {
+	const headless_options_t* options;
+
+	unsigned char job[JOB_FIXED_SIZE + MESSAGE_MAX_PATH];
+	uint32_t job_size;
+
+	rte_tile_t* tiles;
+	int tile_count;
+
+	// Everything below is guarded by mutex
+	rte_mutex_t* mutex;
+	rte_cond_t* changed; // Broadcast whenever tiles are requeued or the last one arrives
+
+	int* pending; // Stack of tiles nobody holds, the next one handed out is on top
+	int pending_count;
+
+	unsigned char* done;
+	int remaining;
+
+	int workers_seen;
+	int workers_lost;
+	int tiles_requeued;
+
+	size_t bytes_raw;
+	size_t bytes_received;
+
+	unsigned char* frame; // Top-down RGB, tiles land in disjoint regions so writes need no lock
+} coordinator_t;
+
+typedef struct coordinator_connection {
+	coordinator_t* coordinator;
+	rte_socket_t* socket;
+	rte_thread_t* thread;
+	int index;
+} coordinator_connection_t;
+
+// Stores a compressed tile into the frame, returns 0 if it doesn't decode
+static int coordinator_store(coordinator_t* coordinator, const rte_tile_t* tile, const unsigned char* data, size_t size) {
+	size_t raw_size = (size_t)tile->width * tile->height * 3;
+	unsigned char* rgb = (unsigned char*)malloc(raw_size);
+
+	if (rgb == NULL || !tile_decompress(rgb, raw_size, data, size)) {
+		free(rgb);
+		return 0;
+	}
+
+	int width = coordinator->options->width;
+
+	for (unsigned int y = 0; y < tile->height; y++) {
+		memcpy(&coordinator->frame[(((size_t)tile->y + y) * width + tile->x) * 3], &rgb[(size_t)y * tile->width * 3], (size_t)tile->width * 3);
+	}
+
+	free(rgb);
+	return 1;
+}
+
+static int coordinator_serve(coordinator_connection_t* connection, int* in_flight, int* p_in_flight_count) {
+	coordinator_t* coordinator = connection->coordinator;
+
+	uint32_t type;
+	uint32_t size;
+	unsigned char* payload = recv_message(connection->socket, &type, &size);
+
+	int valid = payload != NULL && type == MESSAGE_HELLO && size == 8 && get_u32(payload) == DISTRIBUTED_MAGIC && get_u32(payload + 4) == DISTRIBUTED_VERSION;
+	free(payload);
+
+	if (!valid || !send_message(connection->socket, MESSAGE_JOB, coordinator->job, coordinator->job_size)) {
+		return 0;
+	}
+
+	for (;;) {
+		int taken[DISTRIBUTED_IN_FLIGHT];
+		int taken_count = 0;
+
+		rte_mutex_lock(coordinator->mutex);
+
+		while (*p_in_flight_count < DISTRIBUTED_IN_FLIGHT && coordinator->pending_count > 0) {
+			int id = coordinator->pending[--coordinator->pending_count];
+
+			in_flight[(*p_in_flight_count)++] = id;
+			taken[taken_count++] = id;
+		}
+
+		// Idle workers stay connected in case someone else drops their tiles
+		if (*p_in_flight_count == 0) {
+			int finished = coordinator->remaining == 0;
+
+			if (!finished) {
+				rte_cond_wait(coordinator->changed, coordinator->mutex);
+			}
+
+			rte_mutex_unlock(coordinator->mutex);
+
+			if (finished) {
+				break;
+			}
+
+			continue;
+		}
+
+		rte_mutex_unlock(coordinator->mutex);
+
+		for (int t = 0; t < taken_count; t++) {
+			const rte_tile_t* tile = &coordinator->tiles[taken[t]];
+			unsigned char message[20];
+
+			put_u32(message + 0, (uint32_t)taken[t]);
+			put_u32(message + 4, tile->x);
+			put_u32(message + 8, tile->y);
+			put_u32(message + 12, tile->width);
+			put_u32(message + 16, tile->height);
+
+			if (!send_message(connection->socket, MESSAGE_TILE, message, sizeof(message))) {
+				return 0;
+			}
+		}
+
+		payload = recv_message(connection->socket, &type, &size);
+
+		if (payload == NULL || type != MESSAGE_RESULT || size < 4) {
+			free(payload);
+			return 0;
+		}
+
+		int id = (int)get_u32(payload);
+		int slot = -1;
+
+		for (int f = 0; f < *p_in_flight_count; f++) {
+			if (in_flight[f] == id) {
+				slot = f;
+			}
+		}
+
+		// Results for tiles this worker doesn't hold mean it's confused, drop it like a dead one
+		if (slot < 0 || !coordinator_store(coordinator, &coordinator->tiles[id], payload + 4, size - 4)) {
+			free(payload);
+			return 0;
+		}
+
+		free(payload);
+
+		in_flight[slot] = in_flight[--(*p_in_flight_count)];
+
+		rte_mutex_lock(coordinator->mutex);
+
+		coordinator->done[id] = 1;
+		coordinator->remaining--;
+		coordinator->bytes_raw += (size_t)coordinator->tiles[id].width * coordinator->tiles[id].height * 3;
+		coordinator->bytes_received += size + MESSAGE_HEADER_SIZE;
+
+		if (coordinator->remaining == 0) {
+			rte_cond_broadcast(coordinator->changed);
+		}
+
+		rte_mutex_unlock(coordinator->mutex);
+	}
+
+	send_message(connection->socket, MESSAGE_DONE, NULL, 0);
+	return 1;
+}
+
+static int coordinator_connection(void* data) {
+	coordinator_connection_t* connection = (coordinator_connection_t*)data;
+	coordinator_t* coordinator = connection->coordinator;
+
+	int in_flight[DISTRIBUTED_IN_FLIGHT];
+	int in_flight_count = 0;
+
+	rte_socket_set_timeout(connection->socket, coordinator->options->worker_timeout * 1000);
+
+	if (coordinator_serve(connection, in_flight, &in_flight_count)) {
+		return 0;
+	}
+
+	// Dead, stalled or misbehaving, whatever it held goes back to the others
+	rte_mutex_lock(coordinator->mutex);
+
+	for (int f = 0; f < in_flight_count; f++) {
+		if (!coordinator->done[in_flight[f]]) {
+			coordinator->pending[coordinator->pending_count++] = in_flight[f];
+			coordinator->tiles_requeued++;
+		}
+	}
+
+	coordinator->workers_lost++;
+	rte_cond_broadcast(coordinator->changed);
+
+	rte_mutex_unlock(coordinator->mutex);
+
+	printf("Lost worker %i, requeued %i tiles\n", connection->index, in_flight_count);
+	return 1;
+}
+
+int distributed_coordinator(const headless_options_t* options) {
+	coordinator_t coordinator;
+	memset(&coordinator, 0, sizeof(coordinator));
+
+	coordinator.options = options;
+
+	if (options->model != NULL && strlen(options->model) >= MESSAGE_MAX_PATH) {
+		printf("Error: Model path is too long to send to workers!\n");
+		return 1;
+	}
+
+	coordinator.job_size = job_write(coordinator.job, options);
+
+	// Only used to cut the frame, tiles are handed out from the pending stack so they can be requeued
+	rte_scheduler_t scheduler;
+
+	if (!rte_scheduler_init(&scheduler, options->width, options->height, options->tile_size, 1)) {
+		printf("Error: Failed to cut the frame into tiles!\n");
+		return 1;
+	}
+
+	coordinator.tiles = scheduler.tiles;
+	coordinator.tile_count = scheduler.tile_count;
+	coordinator.remaining = scheduler.tile_count;
+
+	coordinator.mutex = rte_mutex_create();
+	coordinator.changed = rte_cond_create();
+	coordinator.pending = (int*)malloc(sizeof(int) * (coordinator.tile_count + 1));
+	coordinator.done = (unsigned char*)calloc(coordinator.tile_count + 1, 1);
+	coordinator.frame = (unsigned char*)calloc((size_t)options->width * options->height, 3);
+
+	if (coordinator.mutex == NULL || coordinator.changed == NULL || coordinator.pending == NULL || coordinator.done == NULL || coordinator.frame == NULL) {
+		printf("Error: Failed to allocate a %ix%i frame!\n", options->width, options->height);
+		return 1;
+	}
+
+	for (int t = coordinator.tile_count - 1; t >= 0; t--) {
+		coordinator.pending[coordinator.pending_count++] = t;
+	}
+
+	rte_socket_t* listener = rte_socket_listen(options->coordinator);
+
+	if (listener == NULL) {
+		printf("Error: Failed to listen on '%s'!\n", options->coordinator);
+		return 1;
+	}
+
+	printf("Waiting for workers on %s, %i tiles to render\n", options->coordinator, coordinator.tile_count);
+
+	coordinator_connection_t** connections = NULL;
+	int connection_count = 0;
+
+	double time_start = 0;
+
+	for (;;) {
+		rte_mutex_lock(coordinator.mutex);
+		int finished = coordinator.remaining == 0;
+		rte_mutex_unlock(coordinator.mutex);
+
+		if (finished) {
+			break;
+		}
+
+		if (rte_socket_wait(listener, 100) != 1) {
+			continue;
+		}
+
+		rte_socket_t* socket = rte_socket_accept(listener);
+		coordinator_connection_t* connection = (coordinator_connection_t*)calloc(1, sizeof(coordinator_connection_t));
+		coordinator_connection_t** grown = (coordinator_connection_t**)realloc(connections, sizeof(coordinator_connection_t*) * (connection_count + 1));
+
+		if (grown != NULL) {
+			connections = grown;
+		}
+
+		if (socket == NULL || connection == NULL || grown == NULL) {
+			rte_socket_close(socket);
+			free(connection);
+			continue;
+		}
+
+		if (connection_count == 0) {
+			time_start = headless_seconds();
+		}
+
+		connection->coordinator = &coordinator;
+		connection->socket = socket;
+		connection->index = connection_count;
+		connection->thread = rte_thread_create(coordinator_connection, connection);
+
+		if (connection->thread == NULL) {
+			rte_socket_close(socket);
+			free(connection);
+			continue;
+		}
+
+		connections[connection_count++] = connection;
+		coordinator.workers_seen++;
+
+		printf("Worker %i connected\n", connection->index);
+	}
+
+	double time_render = headless_seconds() - time_start;
+
+	for (int c = 0; c < connection_count; c++) {
+		rte_thread_join(connections[c]->thread);
+		rte_socket_close(connections[c]->socket);
+		free(connections[c]);
+	}
+
+	free(connections);
+	rte_socket_close(listener);
+
+	printf("Rendered %ix%i at %i spp on %i workers in %.2fms (%i lost, %i tiles requeued)\n",
+		options->width, options->height, options->samples, coordinator.workers_seen,
+		time_render * 1000.0, coordinator.workers_lost, coordinator.tiles_requeued
+	);
+
+	printf("Received %zu bytes for %zu bytes of pixels (%.1f%%)\n",
+		coordinator.bytes_received, coordinator.bytes_raw,
+		coordinator.bytes_raw > 0 ? 100.0 * (double)coordinator.bytes_received / (double)coordinator.bytes_raw : 0.0
+	);
+
+	int status = 0;
+
+	if (headless_write_rgb(options->output, coordinator.frame, options->width, options->height)) {
+		printf("Wrote %s\n", options->output);
+	} else {
+		printf("Error: Failed to write '%s'!\n", options->output);
+		status = 1;
+	}
+
+	free(coordinator.frame);
+	free(coordinator.done);
+	free(coordinator.pending);
+	rte_cond_destroy(coordinator.changed);
+	rte_mutex_destroy(coordinator.mutex);
+	rte_scheduler_free(&scheduler);
+
+	return status;
+}
+
+//
+// Worker
+//
+typedef struct worker_tile {
+	const trace_t* trace;
+	const rte_adaptive_t* adaptive;
+	rte_tile_t tile;
+	rvec3_t* colors;
+} worker_tile_t;
+
+static void worker_rows_job(void* user, int begin, int end) {
+	worker_tile_t* job = (worker_tile_t*)user;
+	trace_t trace = *job->trace;
+
+	// Refinement only depends on each pixel and its neighbours, so the rows can be split up like any other tile
+	if (job->adaptive->max_samples > 0) {
+		rte_tile_t rows = job->tile;
+		rows.y += begin;
+		rows.height = end - begin;
+
+		trace_tile_adaptive(&job->colors[begin * job->tile.width], trace, rows, job->adaptive);
+		return;
+	}
+
+	for (int y = begin; y < end; y++) {
+		for (unsigned int x = 0; x < job->tile.width; x++) {
+			trace.point.x = job->tile.x + x;
+			trace.point.y = job->tile.y + y;
+
+			trace_pixel(RVEC_OUT(job->colors[y * job->tile.width + x]), trace);
+		}
+	}
+}
+
+// Renders the tile and sends it back, returns 0 if the connection failed
+static int worker_render(rte_socket_t* socket, const trace_t* trace, const rte_adaptive_t* adaptive, const unsigned char* message) {
+	uint32_t id = get_u32(message);
+
+	worker_tile_t job;
+	job.trace = trace;
+	job.adaptive = adaptive;
+	job.tile.x = get_u32(message + 4);
+	job.tile.y = get_u32(message + 8);
+	job.tile.width = get_u32(message + 12);
+	job.tile.height = get_u32(message + 16);
+
+	if (job.tile.x + job.tile.width > trace->camera.viewport.width || job.tile.y + job.tile.height > trace->camera.viewport.height) {
+		return 0;
+	}
+
+	size_t pixels = (size_t)job.tile.width * job.tile.height;
+
+	job.colors = (rvec3_t*)malloc(sizeof(rvec3_t) * (pixels > 0 ? pixels : 1));
+	unsigned char* rgb = (unsigned char*)malloc(pixels * 3 + 1);
+	unsigned char* result = (unsigned char*)malloc(4 + tile_compress_bound(pixels * 3));
+
+	int status = 0;
+
+	if (job.colors != NULL && rgb != NULL && result != NULL) {
+		// Rows are the unit of work, tiles are far too small to cut any finer
+		rte_parallel_for((int)job.tile.height, 1, worker_rows_job, &job);
+		headless_quantize(rgb, (const rvec3_t*)job.colors, (int)pixels);
+
+		put_u32(result, id);
+		size_t size = 4 + tile_compress(result + 4, rgb, pixels * 3);
+
+		status = send_message(socket, MESSAGE_RESULT, result, (uint32_t)size);
+	}
+
+	free(result);
+	free(rgb);
+	free(job.colors);
+
+	return status;
+}
+
+int distributed_worker(const headless_options_t* local) {
+	rte_socket_t* socket = NULL;
+
+	for (int a = 0; a < WORKER_CONNECT_ATTEMPTS && socket == NULL; a++) {
+		socket = rte_socket_connect(local->worker);
+
+		if (socket == NULL) {
+			rte_thread_sleep(WORKER_CONNECT_DELAY_MS);
+		}
+	}
+
+	if (socket == NULL) {
+		printf("Error: Failed to connect to a coordinator on '%s'!\n", local->worker);
+		return 1;
+	}
+
+	unsigned char hello[8];
+	put_u32(hello, DISTRIBUTED_MAGIC);
+	put_u32(hello + 4, DISTRIBUTED_VERSION);
+
+	uint32_t type;
+	uint32_t size;
+	unsigned char* payload = NULL;
+
+	headless_options_t options = *local;
+	char model[MESSAGE_MAX_PATH];
+
+	if (send_message(socket, MESSAGE_HELLO, hello, sizeof(hello))) {
+		payload = recv_message(socket, &type, &size);
+	}
+
+	if (payload == NULL || type != MESSAGE_JOB || !job_read(&options, model, payload, size)) {
+		printf("Error: Coordinator didn't send a usable job!\n");
+
+		free(payload);
+		rte_socket_close(socket);
+		return 1;
+	}
+
+	free(payload);
+
+	headless_scene_t scene;
+
+	if (!headless_scene_build(&scene, &options)) {
+		headless_scene_free(&scene);
+		rte_socket_close(socket);
+		return 1;
+	}
+
+	rte_adaptive_t adaptive = headless_adaptive(&options);
+
+	int tiles = 0;
+	int status = 1;
+
+	for (;;) {
+		payload = recv_message(socket, &type, &size);
+
+		if (payload == NULL) {
+			printf("Error: Lost the coordinator!\n");
+			break;
+		}
+
+		if (type == MESSAGE_DONE) {
+			status = 0;
+			free(payload);
+			break;
+		}
+
+		int rendered = type == MESSAGE_TILE && size == 20 && worker_render(socket, &scene.trace, &adaptive, payload);
+		free(payload);
+
+		if (!rendered) {
+			printf("Error: Failed to render a tile for the coordinator!\n");
+			break;
+		}
+
+		tiles++;
+	}
+
+	printf("Rendered %i tiles\n", tiles);
+
+	headless_scene_free(&scene);
+	rte_socket_close(socket);
+
+	return status;
+}
@@ -0,0 +1,23 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#ifndef RTEVERYWHERE_DISTRIBUTED_H
+#define RTEVERYWHERE_DISTRIBUTED_H
+
+#include "headless.h"
+
+//
+// Distributed rendering
+// The coordinator listens on options->coordinator, sends every worker that connects the render settings and then
+// keeps it fed with tiles. Workers trace each tile with trace_pixel and send it back compressed.
+// Tiles held by a worker that disconnects or stalls past options->worker_timeout go back in the queue for the others
+//
+
+// Renders the frame described by the options on remote workers and writes it to options->output, returns the exit code
+extern int distributed_coordinator(const headless_options_t* options);
+
+// Connects to options->worker and renders tiles until the coordinator is done, returns the exit code
+extern int distributed_worker(const headless_options_t* options);
+
+#endif //RTEVERYWHERE_DISTRIBUTED_H
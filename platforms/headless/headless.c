@@ -0,0 +1,518 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#include "headless.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include <threading/thread.h>
+#include <model/obj.h>
+#include <image/bmp.h>
+
+void headless_default_options(headless_options_t* options) {
+	memset(options, 0, sizeof(headless_options_t));
+
+	options->width = 640;
+	options->height = 480;
+	options->samples = 1;
+	options->threads = rte_thread_count();
+	options->tile_size = 16;
+	options->accel = RTE_ACCEL_BVH;
+	options->builder = RTE_BUILDER_SAH;
+	options->seed = CRAND_DEFAULT_SEED; // Same layout the SDL harness opens with
+	options->bounces = -1;
+	options->output = "out.bmp";
+	options->worker_timeout = 30;
+	options->frames = 60;
+	options->adaptive_threshold = rte_adaptive_defaults().threshold;
+	options->min_energy = RTE_DEFAULT_MIN_ENERGY;
+}
+
+double headless_seconds() {
+#if defined(_WIN32)
+	LARGE_INTEGER frequency;
+	LARGE_INTEGER counter;
+
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+
+	return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+
+	return (double)time.tv_sec + (double)time.tv_nsec * 1e-9;
+#endif
+}
+
+static int headless_parse_vec3(rvec3_out_t dst, const char* text) {
+	double x, y, z;
+
+	if (sscanf(text, "%lf,%lf,%lf", &x, &y, &z) != 3) {
+		return 0;
+	}
+
+	RVEC_OUT_DEREF(dst)[0] = (real_t)x;
+	RVEC_OUT_DEREF(dst)[1] = (real_t)y;
+	RVEC_OUT_DEREF(dst)[2] = (real_t)z;
+
+	return 1;
+}
+
+// Returns 0 unless the whole text is a decimal integer
+static int headless_parse_int(int* p_value, const char* text) {
+	char* end;
+	long value = strtol(text, &end, 10);
+
+	if (end == text || *end != '\0' || value < -0x7FFFFFFF || value > 0x7FFFFFFF) {
+		return 0;
+	}
+
+	*p_value = (int)value;
+	return 1;
+}
+
+int headless_option_is_flag(const char* name) {
+	return strcmp(name, "aces") == 0 || strcmp(name, "wavefront") == 0;
+}
+
+headless_option_result_e headless_set_option(headless_options_t* options, const char* name, const char* value) {
+	static const struct {
+		const char* name;
+		size_t offset;
+	} ints[] = {
+		{"width", offsetof(headless_options_t, width)},
+		{"height", offsetof(headless_options_t, height)},
+		{"samples", offsetof(headless_options_t, samples)},
+		{"threads", offsetof(headless_options_t, threads)},
+		{"tile", offsetof(headless_options_t, tile_size)},
+		{"bounces", offsetof(headless_options_t, bounces)},
+		{"aces", offsetof(headless_options_t, aces)},
+		{"wavefront", offsetof(headless_options_t, wavefront)},
+		{"adaptive", offsetof(headless_options_t, adaptive)},
+		{"denoise", offsetof(headless_options_t, denoise)},
+		{"worker-timeout", offsetof(headless_options_t, worker_timeout)},
+		{"frames", offsetof(headless_options_t, frames)},
+		{"priority", offsetof(headless_options_t, priority)}
+	};
+
+	static const struct {
+		const char* name;
+		size_t offset;
+	} strings[] = {
+		{"model", offsetof(headless_options_t, model)},
+		{"output", offsetof(headless_options_t, output)},
+		{"aovs", offsetof(headless_options_t, aovs)},
+		{"coordinator", offsetof(headless_options_t, coordinator)},
+		{"worker", offsetof(headless_options_t, worker)},
+		{"path", offsetof(headless_options_t, path)},
+		{"daemon", offsetof(headless_options_t, daemon)},
+		{"client", offsetof(headless_options_t, client)}
+	};
+
+	for (size_t i = 0; i < sizeof(ints) / sizeof(ints[0]); i++) {
+		if (strcmp(name, ints[i].name) == 0) {
+			return value != NULL && headless_parse_int((int*)((char*)options + ints[i].offset), value) ? HEADLESS_OPTION_OK : HEADLESS_OPTION_INVALID;
+		}
+	}
+
+	for (size_t s = 0; s < sizeof(strings) / sizeof(strings[0]); s++) {
+		if (strcmp(name, strings[s].name) == 0) {
+			if (value == NULL) {
+				return HEADLESS_OPTION_INVALID;
+			}
+
+			*(const char**)((char*)options + strings[s].offset) = value;
+			return HEADLESS_OPTION_OK;
+		}
+	}
+
+	if (strcmp(name, "position") == 0) {
+		options->has_position = value != NULL && headless_parse_vec3(RVEC_OUT(options->position), value);
+		return options->has_position ? HEADLESS_OPTION_OK : HEADLESS_OPTION_INVALID;
+	}
+
+	if (strcmp(name, "rotation") == 0) {
+		options->has_rotation = value != NULL && headless_parse_vec3(RVEC_OUT(options->rotation), value);
+		return options->has_rotation ? HEADLESS_OPTION_OK : HEADLESS_OPTION_INVALID;
+	}
+
+	if (strcmp(name, "adaptive-threshold") == 0) {
+		char* end;
+
+		if (value == NULL || value[0] == '\0') {
+			return HEADLESS_OPTION_INVALID;
+		}
+
+		options->adaptive_threshold = (real_t)strtod(value, &end);
+		return *end == '\0' ? HEADLESS_OPTION_OK : HEADLESS_OPTION_INVALID;
+	}
+
+	if (strcmp(name, "min-energy") == 0) {
+		char* end;
+
+		if (value == NULL || value[0] == '\0') {
+			return HEADLESS_OPTION_INVALID;
+		}
+
+		options->min_energy = (real_t)strtod(value, &end);
+		return *end == '\0' ? HEADLESS_OPTION_OK : HEADLESS_OPTION_INVALID;
+	}
+
+	if (strcmp(name, "seed") == 0) {
+		char* end;
+
+		if (value == NULL || value[0] == '\0') {
+			return HEADLESS_OPTION_INVALID;
+		}
+
+		options->seed = strtoul(value, &end, 10);
+		return *end == '\0' ? HEADLESS_OPTION_OK : HEADLESS_OPTION_INVALID;
+	}
+
+	if (strcmp(name, "accel") == 0) {
+		if (value == NULL) {
+			return HEADLESS_OPTION_INVALID;
+		} else if (strcmp(value, "none") == 0) {
+			options->accel = RTE_ACCEL_NONE;
+		} else if (strcmp(value, "bvh") == 0) {
+			options->accel = RTE_ACCEL_BVH;
+		} else if (strcmp(value, "qbvh") == 0) {
+			options->accel = RTE_ACCEL_QBVH;
+		} else {
+			return HEADLESS_OPTION_INVALID;
+		}
+
+		return HEADLESS_OPTION_OK;
+	}
+
+	if (strcmp(name, "builder") == 0) {
+		if (value == NULL) {
+			return HEADLESS_OPTION_INVALID;
+		} else if (strcmp(value, "sah") == 0) {
+			options->builder = RTE_BUILDER_SAH;
+		} else if (strcmp(value, "lbvh") == 0) {
+			options->builder = RTE_BUILDER_LBVH;
+		} else if (strcmp(value, "treelets") == 0) {
+			options->builder = RTE_BUILDER_LBVH_TREELETS;
+		} else {
+			return HEADLESS_OPTION_INVALID;
+		}
+
+		return HEADLESS_OPTION_OK;
+	}
+
+	return HEADLESS_OPTION_UNKNOWN;
+}
+
+const char* headless_check_options(const headless_options_t* options) {
+	if (options->width <= 0 || options->height <= 0 || options->width > 65535 || options->height > 65535) {
+		return "Resolution must be between 1 and 65535 pixels on each side";
+	}
+
+	if (options->samples != 1 && options->samples != 4) {
+		return "Samples must be 1 or 4";
+	}
+
+	if (options->threads < 1 || options->tile_size < 1) {
+		return "Threads and tile size must be at least 1";
+	}
+
+	if (options->adaptive < 0 || options->adaptive > RTE_ADAPTIVE_MAX_SAMPLES) {
+		return "Adaptive samples must be between 0 (off) and 16";
+	}
+
+	if (!(options->adaptive_threshold >= 0)) {
+		return "Adaptive threshold can't be negative";
+	}
+
+	if (options->adaptive > 0 && options->wavefront) {
+		return "Adaptive sampling can't be traced as a wavefront";
+	}
+
+	if (!(options->min_energy >= 0)) {
+		return "Minimum reflection energy can't be negative";
+	}
+
+	if (options->denoise < 0 || options->denoise > RTE_DENOISE_MAX_PASSES) {
+		return "Denoise passes must be between 0 (off) and 5";
+	}
+
+	if (options->denoise > 0 && options->coordinator != NULL) {
+		return "Denoising needs the whole frame, distributed renders can't be denoised";
+	}
+
+	if (options->aovs != NULL && (options->wavefront || options->adaptive > 0)) {
+		return "AOVs are only written by the packet tracer, not with --wavefront or --adaptive";
+	}
+
+	if (options->aovs != NULL && (options->coordinator != NULL || options->worker != NULL || options->path != NULL || options->daemon != NULL || options->client != NULL)) {
+		return "AOVs are only written by single frame renders";
+	}
+
+	return NULL;
+}
+
+rte_adaptive_t headless_adaptive(const headless_options_t* options) {
+	rte_adaptive_t settings;
+
+	settings.max_samples = options->adaptive;
+	settings.threshold = options->adaptive_threshold;
+
+	return settings;
+}
+
+int headless_denoise(rvec3_t* frame, const trace_t trace, const headless_options_t* options) {
+	if (options->denoise == 0) {
+		return 1;
+	}
+
+	rte_denoise_t denoise;
+
+	if (!denoise_init(&denoise, options->width, options->height)) {
+		return 0;
+	}
+
+	denoise_trace_guides(&denoise, trace);
+	denoise_filter(&denoise, frame, options->denoise);
+
+	denoise_free(&denoise);
+	return 1;
+}
+
+int headless_scene_build(headless_scene_t* scene, const headless_options_t* options) {
+	rte_context_init(&scene->context);
+	mesh_init(&scene->mesh);
+
+	scene->context.seed = options->seed;
+	scene->context.builder = options->builder;
+
+	if (!rte_context_build(&scene->context)) {
+		printf("Error: Failed to build the scene!\n");
+		return 0;
+	}
+
+	if (options->model != NULL && options->model[0] != '\0') {
+		if (!obj_load(&scene->mesh, options->model) || !mesh_build(&scene->mesh) || scene->mesh.triangle_count == 0) {
+			printf("Error: Failed to load model '%s'!\n", options->model);
+			return 0;
+		}
+	}
+
+	headless_scene_frame(scene, options);
+
+	return 1;
+}
+
+void headless_scene_frame(headless_scene_t* scene, const headless_options_t* options) {
+	trace_t* trace = &scene->trace;
+	memset(trace, 0, sizeof(trace_t));
+
+	trace->scene = rte_default_scene(&scene->context);
+	trace->scene.accel = options->accel;
+
+	if (options->bounces >= 0) {
+		trace->scene.mirror_bounces = options->bounces;
+	}
+
+	trace->scene.min_energy = options->min_energy;
+
+	if (scene->mesh.triangle_count > 0) {
+		trace->scene.meshes = &scene->mesh;
+		trace->scene.mesh_count = 1;
+	}
+
+	rte_viewport_t viewport;
+	viewport.width = options->width;
+	viewport.height = options->height;
+
+	trace->camera = rte_default_camera(viewport);
+
+	if (options->has_position || options->has_rotation) {
+		rvec3_t position;
+		rvec3_t rotation;
+
+		rvec3_copy(RVEC_OUT(position), options->has_position ? options->position : trace->camera.position);
+		rvec3_copy(RVEC_OUT(rotation), options->has_rotation ? options->rotation : trace->camera.rotation);
+
+		trace->camera = rte_setup_camera(viewport, position, rotation);
+	}
+
+	trace->camera.samples = options->samples == 4 ? CAMERA_SAMPLES_FOUR : CAMERA_SAMPLES_ONE;
+	trace->tonemapping = options->aces ? RTE_TONEMAP_ACES : RTE_TONEMAP_NONE;
+}
+
+void headless_scene_free(headless_scene_t* scene) {
+	mesh_free(&scene->mesh);
+	rte_context_free(&scene->context);
+}
+
+int headless_render_init(headless_render_t* render, const headless_options_t* options) {
+	memset(render, 0, sizeof(headless_render_t));
+	render->width = options->width;
+	render->adaptive = headless_adaptive(options);
+
+	if (!options->wavefront && options->adaptive == 0) {
+		return 1;
+	}
+
+	int tile_pixels = options->tile_size * options->tile_size;
+	render->workers = (headless_worker_t*)calloc(options->threads, sizeof(headless_worker_t));
+
+	if (render->workers == NULL) {
+		return 0;
+	}
+
+	// Counted as they're set up so a failure only frees what exists
+	for (int w = 0; w < options->threads; w++) {
+		headless_worker_t* worker = &render->workers[w];
+		worker->colors = (rvec3_t*)malloc(sizeof(rvec3_t) * tile_pixels);
+
+		if (worker->colors == NULL || (options->wavefront && !wavefront_init(&worker->wavefront, tile_pixels))) {
+			free(worker->colors);
+			headless_render_free(render);
+			return 0;
+		}
+
+		render->worker_count++;
+	}
+
+	return 1;
+}
+
+void headless_render_free(headless_render_t* render) {
+	for (int w = 0; w < render->worker_count; w++) {
+		wavefront_free(&render->workers[w].wavefront);
+		free(render->workers[w].colors);
+	}
+
+	free(render->workers);
+
+	render->workers = NULL;
+	render->worker_count = 0;
+}
+
+static void headless_copy_tile(headless_render_t* render, const rvec3_t* colors, rte_tile_t tile) {
+	for (unsigned int y = 0; y < tile.height; y++) {
+		memcpy(&render->frame[(tile.y + y) * render->width + tile.x], &colors[y * tile.width], sizeof(rvec3_t) * tile.width);
+	}
+}
+
+void headless_render_tile(void* user, int worker, rte_tile_t tile) {
+	headless_render_t* render = (headless_render_t*)user;
+
+	if (render->adaptive.max_samples > 0) {
+		headless_worker_t* state = &render->workers[worker];
+		int rays = trace_tile_adaptive(state->colors, render->trace, tile, &render->adaptive);
+
+		rte_atomic_add(&render->adaptive_rays, rays);
+		headless_copy_tile(render, state->colors, tile);
+
+		return;
+	}
+
+	if (render->workers != NULL) {
+		headless_worker_t* state = &render->workers[worker];
+		trace_tile_wavefront(&state->wavefront, state->colors, render->trace, tile);
+
+		headless_copy_tile(render, state->colors, tile);
+
+		return;
+	}
+
+	// Neighbouring pixels are traced together as ray packets, MSAA packets already hold 4 rays per pixel
+	trace_t trace = render->trace;
+	unsigned int block = trace.camera.samples == CAMERA_SAMPLES_FOUR ? 2 : 4;
+
+	for (unsigned int y = tile.y; y < tile.y + tile.height; y += block) {
+		for (unsigned int x = tile.x; x < tile.x + tile.width; x += block) {
+			unsigned int block_w = tile.x + tile.width - x < block ? tile.x + tile.width - x : block;
+			unsigned int block_h = tile.y + tile.height - y < block ? tile.y + tile.height - y : block;
+
+			rvec3_t colors[16];
+
+			trace.point.x = x;
+			trace.point.y = y;
+
+			trace_pixel_block_aovs(colors, render->aovs, trace, block_w, block_h);
+
+			for (unsigned int by = 0; by < block_h; by++) {
+				memcpy(&render->frame[(y + by) * render->width + x], &colors[by * block_w], sizeof(rvec3_t) * block_w);
+			}
+		}
+	}
+}
+
+void headless_quantize(unsigned char* dst, const rvec3_t* colors, int count) {
+	for (int p = 0; p < count; p++) {
+		const real_t* color = colors[p];
+
+		dst[p * 3 + 0] = (unsigned char)(color[0] * 255);
+		dst[p * 3 + 1] = (unsigned char)(color[1] * 255);
+		dst[p * 3 + 2] = (unsigned char)(color[2] * 255);
+	}
+}
+
+// BMPs are stored bottom-up as BGR
+static unsigned char* headless_to_bmp_order(const unsigned char* rgb, int width, int height) {
+	unsigned char* pixels = (unsigned char*)malloc((size_t)width * height * 3);
+
+	if (pixels == NULL) {
+		return NULL;
+	}
+
+	for (int y = 0; y < height; y++) {
+		const unsigned char* src = &rgb[(size_t)y * width * 3];
+		unsigned char* dst = &pixels[(size_t)(height - 1 - y) * width * 3];
+
+		for (int x = 0; x < width; x++) {
+			dst[x * 3 + 0] = src[x * 3 + 2];
+			dst[x * 3 + 1] = src[x * 3 + 1];
+			dst[x * 3 + 2] = src[x * 3 + 0];
+		}
+	}
+
+	return pixels;
+}
+
+int headless_write_rgb(const char* path, const unsigned char* rgb, int width, int height) {
+	unsigned char* pixels = headless_to_bmp_order(rgb, width, height);
+
+	if (pixels == NULL) {
+		return 0;
+	}
+
+	int result = write_bmp(path, (uint16_t)width, (uint16_t)height, (char*)pixels);
+	free(pixels);
+
+	return result;
+}
+
+char* headless_encode_rgb(const unsigned char* rgb, int width, int height, size_t* p_size) {
+	unsigned char* pixels = headless_to_bmp_order(rgb, width, height);
+
+	if (pixels == NULL) {
+		return NULL;
+	}
+
+	*p_size = bmp_encoded_size((uint16_t)width, (uint16_t)height);
+	char* bmp = (char*)malloc(*p_size);
+
+	if (bmp != NULL) {
+		encode_bmp(bmp, (uint16_t)width, (uint16_t)height, (const char*)pixels);
+	}
+
+	free(pixels);
+	return bmp;
+}
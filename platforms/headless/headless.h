@@ -0,0 +1,148 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#ifndef RTEVERYWHERE_HEADLESS_H
+#define RTEVERYWHERE_HEADLESS_H
+
+#include <stddef.h>
+
+#include <rt_everywhere.h>
+#include <render/wavefront.h>
+#include <render/adaptive.h>
+#include <render/denoise.h>
+
+//
+// Shared by every mode of the headless harness
+//
+
+typedef struct headless_options {
+	int width;
+	int height;
+	int samples;
+	int threads;
+	int tile_size;
+
+	int has_position;
+	int has_rotation;
+	rvec3_t position;
+	rvec3_t rotation;
+
+	rte_accel_e accel;
+	rte_builder_e builder;
+	unsigned long seed;
+	int bounces;
+	real_t min_energy; // Reflections darker than this stop early
+
+	int aces;
+	int wavefront;
+
+	// Adaptive sampling up to this many samples per pixel in place of --samples, 0 turns it off
+	int adaptive;
+	real_t adaptive_threshold;
+
+	// A-trous passes over the finished frame, 0 turns it off
+	int denoise;
+
+	const char* model;
+	const char* output;
+
+	// Prefix of the AOV images, NULL writes none, see aovs.h
+	const char* aovs;
+
+	// Distributed rendering, see distributed.h
+	const char* coordinator;
+	const char* worker;
+	int worker_timeout; // Seconds a worker may take on a tile before it's presumed dead
+
+	// Sequences, see sequence.h
+	const char* path;
+	int frames;
+
+	// Render service, see daemon.h
+	const char* daemon;
+	const char* client;
+	int priority;
+} headless_options_t;
+
+typedef enum headless_option_result {
+	HEADLESS_OPTION_OK,
+	HEADLESS_OPTION_UNKNOWN,
+	HEADLESS_OPTION_INVALID
+} headless_option_result_e;
+
+// Everything a frame is traced from, trace points into the struct so it must stay put once built
+typedef struct headless_scene {
+	rte_context_t context;
+	rte_mesh_t mesh;
+	trace_t trace;
+} headless_scene_t;
+
+typedef struct headless_worker {
+	rte_wavefront_t wavefront;
+	rvec3_t* colors;
+} headless_worker_t;
+
+// Traces tiles of a frame for the scheduler, the caller fills in trace and frame
+typedef struct headless_render {
+	trace_t trace;
+
+	rvec3_t* frame;
+	unsigned int width;
+
+	// Used instead of trace_pixel_block when max_samples isn't 0, rays counts the camera rays it traced
+	rte_adaptive_t adaptive;
+	volatile int adaptive_rays;
+
+	// Filled in alongside the frame by the packet tracer when not NULL
+	const rte_aovs_t* aovs;
+
+	// One per scheduler worker, only used when rendering as a wavefront or adaptively
+	headless_worker_t* workers;
+	int worker_count;
+} headless_render_t;
+
+extern void headless_default_options(headless_options_t* options);
+
+extern double headless_seconds();
+
+// Options are named like their command line switch without the dashes, flags take "1" or "0"
+extern int headless_option_is_flag(const char* name);
+
+// A NULL value is invalid for everything, strings are kept by pointer so the value has to outlive the options
+extern headless_option_result_e headless_set_option(headless_options_t* options, const char* name, const char* value);
+
+// Returns why the options can't be rendered or NULL if they can
+extern const char* headless_check_options(const headless_options_t* options);
+
+// Adaptive sampling settings of the options, max_samples is 0 when it's off
+extern rte_adaptive_t headless_adaptive(const headless_options_t* options);
+
+// Denoises a finished frame of the trace in place if the options ask for it, returns 0 if memory ran out
+extern int headless_denoise(rvec3_t* frame, const trace_t trace, const headless_options_t* options);
+
+// Builds the scene and camera the options describe, returns 0 and prints why on failure
+extern int headless_scene_build(headless_scene_t* scene, const headless_options_t* options);
+
+// Points the trace of an already built scene at the camera, resolution and quality of the options
+// Only the geometry (seed, builder and model) has to match the options it was built with
+extern void headless_scene_frame(headless_scene_t* scene, const headless_options_t* options);
+extern void headless_scene_free(headless_scene_t* scene);
+
+// Allocates the per worker state the options call for, returns 0 if memory ran out
+extern int headless_render_init(headless_render_t* render, const headless_options_t* options);
+extern void headless_render_free(headless_render_t* render);
+
+// rte_tile_func_t with a headless_render_t as the user data
+extern void headless_render_tile(void* user, int worker, rte_tile_t tile);
+
+// Converts colors to 8 bit RGB triplets, the same way for every mode so they all produce identical images
+extern void headless_quantize(unsigned char* dst, const rvec3_t* colors, int count);
+
+// Writes top-down rows of RGB triplets as a BMP
+extern int headless_write_rgb(const char* path, const unsigned char* rgb, int width, int height);
+
+// Same as headless_write_rgb but into memory, returns the BMP to free and its size or NULL if memory ran out
+extern char* headless_encode_rgb(const unsigned char* rgb, int width, int height, size_t* p_size);
+
+#endif //RTEVERYWHERE_HEADLESS_H
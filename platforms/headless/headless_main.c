@@ -0,0 +1,269 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <render/scheduler.h>
+#include <threading/pool.h>
+
+#include "headless.h"
+#include "distributed.h"
+#include "sequence.h"
+#include "daemon.h"
+#include "aovs.h"
+
+//
+// Headless batch renderer
+// Renders a single frame with every core and writes it out as a BMP, nothing past the core library is needed
+//
+
+static void print_usage(const char* program) {
+	printf("Usage: %s [options]\n", program);
+	printf("  --width <pixels>          Image width (default 640)\n");
+	printf("  --height <pixels>         Image height (default 480)\n");
+	printf("  --samples <1|4>           Samples per pixel (default 1)\n");
+	printf("  --threads <count>         Render threads (default all cores)\n");
+	printf("  --tile <pixels>           Tile size handed to each thread (default 16)\n");
+	printf("  --position <x,y,z>        Camera position (default looks at the spheres)\n");
+	printf("  --rotation <p,y,r>        Camera rotation in degrees\n");
+	printf("  --accel <none|bvh|qbvh>   Sphere acceleration structure (default bvh)\n");
+	printf("  --builder <sah|lbvh|treelets> Sphere BVH builder (default sah)\n");
+	printf("  --seed <number>           Sphere layout seed (default %lu)\n", (unsigned long)CRAND_DEFAULT_SEED);
+	printf("  --bounces <count>         Mirror bounces\n");
+	printf("  --min-energy <e>          Reflections carrying less stop before their bounces run out, 0 traces all (default 1/256)\n");
+	printf("  --model <file.obj>        Adds an OBJ model to the scene\n");
+	printf("  --aces                    ACES tonemapping\n");
+	printf("  --wavefront               Trace breadth first instead of in ray packets\n");
+	printf("  --adaptive <max samples>  Starts at 1 spp and refines edges and reflections up to max samples (1-16)\n");
+	printf("  --adaptive-threshold <t>  Pixel contrast left unrefined, from 0 to 1 (default 0.08)\n");
+	printf("  --denoise <passes>        Filters the finished frame with an edge-avoiding a-trous denoiser (1-5)\n");
+	printf("  --output <file.bmp>       Output path (default out.bmp)\n");
+	printf("  --aovs <prefix>           Also writes depth, normal, albedo, material, primitive and bounces as prefix_<aov>.bmp\n");
+	printf("  --path <file>             Renders a sequence along a camera path, one \"time x,y,z pitch,yaw,roll\" per line\n");
+	printf("  --frames <count>          Frames in the sequence (default 60), --output then takes a pattern like frame_%%04d.bmp\n");
+	printf("  --coordinator <address>   Hands tiles out to workers connecting on host:port or unix:/path\n");
+	printf("  --worker <address>        Renders tiles for the coordinator at host:port or unix:/path\n");
+	printf("  --worker-timeout <secs>   Time a worker may take on a tile before it's requeued (default 30)\n");
+	printf("  --daemon <address>        Serves renders over HTTP on host:port or unix:/path until POST /shutdown\n");
+	printf("  --client <address>        Has the daemon at host:port or unix:/path render the frame instead\n");
+	printf("  --priority <number>       Priority of a --client request, higher renders first (default 0)\n");
+}
+
+// Returns 0 and prints why if the arguments don't make sense
+static int parse_options(headless_options_t* options, int argc, char** argv) {
+	for (int a = 1; a < argc; a++) {
+		const char* arg = argv[a];
+
+		if (strcmp(arg, "--help") == 0) {
+			print_usage(argv[0]);
+			exit(0);
+		}
+
+		const char* name = strncmp(arg, "--", 2) == 0 ? arg + 2 : "";
+		const char* value = "1";
+
+		// Everything but flags takes a value
+		if (!headless_option_is_flag(name)) {
+			value = a + 1 < argc ? argv[a + 1] : NULL;
+		}
+
+		headless_option_result_e result = headless_set_option(options, name, value);
+
+		if (result == HEADLESS_OPTION_UNKNOWN) {
+			printf("Error: Unknown option '%s', see --help!\n", arg);
+			return 0;
+		}
+
+		if (result == HEADLESS_OPTION_INVALID) {
+			if (value == NULL) {
+				printf("Error: Missing value for '%s'!\n", arg);
+			} else {
+				printf("Error: Invalid value '%s' for '%s'!\n", value, arg);
+			}
+
+			return 0;
+		}
+
+		if (!headless_option_is_flag(name)) {
+			a++;
+		}
+	}
+
+	const char* error = headless_check_options(options);
+
+	if (error != NULL) {
+		printf("Error: %s!\n", error);
+		return 0;
+	}
+
+	int modes = (options->coordinator != NULL) + (options->worker != NULL) + (options->path != NULL) + (options->daemon != NULL) + (options->client != NULL);
+
+	if (modes > 1) {
+		printf("Error: Only one of --coordinator, --worker, --path, --daemon and --client can be used at once!\n");
+		return 0;
+	}
+
+	if (options->client != NULL && options->model != NULL) {
+		printf("Error: The daemon renders the model it was started with, pass --model to --daemon instead!\n");
+		return 0;
+	}
+
+	if (options->path != NULL) {
+		if (options->frames < 1) {
+			printf("Error: A sequence needs at least 1 frame!\n");
+			return 0;
+		}
+
+		if (!sequence_valid_pattern(options->output)) {
+			printf("Error: Sequences need an output pattern with one frame number like frame_%%04d.bmp, got '%s'!\n", options->output);
+			return 0;
+		}
+	}
+
+	if (options->worker_timeout < 1) {
+		printf("Error: Worker timeout must be at least 1 second!\n");
+		return 0;
+	}
+
+	return 1;
+}
+
+int main(int argc, char** argv) {
+	headless_options_t options;
+	headless_default_options(&options);
+
+	if (!parse_options(&options, argc, argv)) {
+		return 1;
+	}
+
+	// The worker count comes from who connects and the scene is built by each worker
+	if (options.coordinator != NULL) {
+		return distributed_coordinator(&options);
+	}
+
+	if (options.worker != NULL) {
+		return distributed_worker(&options);
+	}
+
+	if (options.path != NULL) {
+		return sequence_render(&options);
+	}
+
+	if (options.daemon != NULL) {
+		return daemon_serve(&options);
+	}
+
+	if (options.client != NULL) {
+		return daemon_request(&options);
+	}
+
+	double time_build = headless_seconds();
+
+	headless_scene_t scene;
+
+	if (!headless_scene_build(&scene, &options)) {
+		return 1;
+	}
+
+	time_build = headless_seconds() - time_build;
+
+	//
+	// Render
+	//
+	headless_render_t render;
+	rte_scheduler_t scheduler;
+
+	if (!headless_render_init(&render, &options) || !rte_scheduler_init(&scheduler, options.width, options.height, options.tile_size, options.threads)) {
+		printf("Error: Failed to allocate a %ix%i frame!\n", options.width, options.height);
+		return 1;
+	}
+
+	render.trace = scene.trace;
+	render.frame = (rvec3_t*)malloc(sizeof(rvec3_t) * options.width * options.height);
+
+	if (render.frame == NULL) {
+		printf("Error: Failed to allocate a %ix%i frame!\n", options.width, options.height);
+		return 1;
+	}
+
+	headless_aovs_t aovs;
+
+	if (options.aovs != NULL) {
+		if (!headless_aovs_init(&aovs, options.width, options.height)) {
+			printf("Error: Failed to allocate the AOVs of a %ix%i frame!\n", options.width, options.height);
+			return 1;
+		}
+
+		render.aovs = &aovs.planes;
+	}
+
+	// The calling thread is one of the workers
+	rte_pool_t* pool = rte_pool_create(options.threads - 1);
+
+	double time_render = headless_seconds();
+	rte_scheduler_run_pool(&scheduler, pool, headless_render_tile, &render);
+	time_render = headless_seconds() - time_render;
+
+	double time_denoise = headless_seconds();
+
+	if (!headless_denoise(render.frame, render.trace, &options)) {
+		printf("Error: Failed to allocate the denoiser, the frame is written as traced!\n");
+	}
+
+	time_denoise = headless_seconds() - time_denoise;
+
+	double pixels = (double)options.width * options.height;
+
+	printf("Built scene in %.2fms\n", time_build * 1000.0);
+	printf("Rendered %ix%i at %i spp on %i threads in %.2fms (%.2f Mpixels/s, %i tiles, %i stolen)\n",
+		options.width, options.height, options.samples, options.threads,
+		time_render * 1000.0, pixels / time_render / 1e6,
+		scheduler.tile_count, scheduler.steals
+	);
+
+	if (options.adaptive > 0) {
+		printf("Adaptive sampling traced %i camera rays, %.2f per pixel (%.1f%% of 4 spp)\n",
+			render.adaptive_rays, render.adaptive_rays / pixels, 100.0 * render.adaptive_rays / (pixels * 4.0)
+		);
+	}
+
+	if (options.denoise > 0) {
+		printf("Denoised with %i passes in %.2fms\n", options.denoise, time_denoise * 1000.0);
+	}
+
+	int status = 0;
+
+	unsigned char* rgb = (unsigned char*)malloc((size_t)options.width * options.height * 3);
+
+	if (rgb != NULL) {
+		headless_quantize(rgb, (const rvec3_t*)render.frame, options.width * options.height);
+	}
+
+	if (rgb != NULL && headless_write_rgb(options.output, rgb, options.width, options.height)) {
+		printf("Wrote %s\n", options.output);
+	} else {
+		printf("Error: Failed to write '%s'!\n", options.output);
+		status = 1;
+	}
+
+	if (options.aovs != NULL) {
+		if (headless_aovs_write(&aovs, options.aovs, render.trace.scene.mirror_bounces) > 0) {
+			status = 1;
+		}
+
+		headless_aovs_free(&aovs);
+	}
+
+	rte_pool_destroy(pool);
+	rte_scheduler_free(&scheduler);
+	free(render.frame);
+	headless_render_free(&render);
+
+	free(rgb);
+	headless_scene_free(&scene);
+
+	return status;
+}
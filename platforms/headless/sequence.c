@@ -0,0 +1,345 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#include "sequence.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <render/camera_path.h>
+#include <render/scheduler.h>
+#include <threading/pool.h>
+#include <threading/thread.h>
+
+// One frame being set up, one being traced and one being written
+#define SEQUENCE_SLOTS 3
+
+#define SEQUENCE_PATH_MAX 4096
+
+typedef struct sequence_slot {
+	int index;
+	trace_t trace;
+	rvec3_t* frame;
+} sequence_slot_t;
+
+// FIFO of slot numbers, pop blocks until one arrives or the queue closes
+typedef struct sequence_queue {
+	int slots[SEQUENCE_SLOTS];
+	int head;
+	int count;
+	int closed;
+} sequence_queue_t;
+
+typedef struct sequence {
+	const headless_options_t* options;
+	const headless_scene_t* scene;
+	rte_camera_path_t path;
+
+	sequence_slot_t slots[SEQUENCE_SLOTS];
+
+	// The queues and everything below them are guarded by mutex
+	rte_mutex_t* mutex;
+	rte_cond_t* changed;
+
+	sequence_queue_t free;   // Setup takes from here
+	sequence_queue_t ready;  // Set up, waiting to be traced
+	sequence_queue_t traced; // Waiting to be written
+
+	int failed; // Index of the first frame that couldn't be written, -1 while they all could
+} sequence_t;
+
+int sequence_valid_pattern(const char* pattern) {
+	int conversions = 0;
+
+	for (const char* c = pattern; *c != '\0'; c++) {
+		if (*c != '%') {
+			continue;
+		}
+
+		c++;
+
+		while (*c == '0' || *c == '-' || *c == '+' || *c == ' ') {
+			c++;
+		}
+
+		while (*c >= '0' && *c <= '9') {
+			c++;
+		}
+
+		if (*c != 'd' && *c != 'i') {
+			return 0;
+		}
+
+		conversions++;
+	}
+
+	return conversions == 1;
+}
+
+// Expects the mutex to be held
+static void sequence_push(sequence_t* sequence, sequence_queue_t* queue, int slot) {
+	queue->slots[(queue->head + queue->count) % SEQUENCE_SLOTS] = slot;
+	queue->count++;
+
+	rte_cond_broadcast(sequence->changed);
+}
+
+// Returns -1 once the queue is closed and empty
+static int sequence_pop(sequence_t* sequence, sequence_queue_t* queue) {
+	rte_mutex_lock(sequence->mutex);
+
+	while (queue->count == 0 && !queue->closed) {
+		rte_cond_wait(sequence->changed, sequence->mutex);
+	}
+
+	int slot = -1;
+
+	if (queue->count > 0) {
+		slot = queue->slots[queue->head];
+
+		queue->head = (queue->head + 1) % SEQUENCE_SLOTS;
+		queue->count--;
+	}
+
+	rte_mutex_unlock(sequence->mutex);
+	return slot;
+}
+
+static void sequence_give(sequence_t* sequence, sequence_queue_t* queue, int slot) {
+	rte_mutex_lock(sequence->mutex);
+	sequence_push(sequence, queue, slot);
+	rte_mutex_unlock(sequence->mutex);
+}
+
+static void sequence_close(sequence_t* sequence, sequence_queue_t* queue) {
+	rte_mutex_lock(sequence->mutex);
+
+	queue->closed = 1;
+	rte_cond_broadcast(sequence->changed);
+
+	rte_mutex_unlock(sequence->mutex);
+}
+
+// Time of the frame along the path, the first and last frames land on the first and last keyframes
+static real_t sequence_frame_time(const sequence_t* sequence, int index) {
+	real_t start = rte_camera_path_start(&sequence->path);
+	real_t end = rte_camera_path_end(&sequence->path);
+
+	if (sequence->options->frames < 2) {
+		return start;
+	}
+
+	return start + (end - start) * (real_t)index / (real_t)(sequence->options->frames - 1);
+}
+
+static int sequence_setup_thread(void* user) {
+	sequence_t* sequence = (sequence_t*)user;
+	const trace_t* base = &sequence->scene->trace;
+
+	for (int index = 0; index < sequence->options->frames; index++) {
+		int slot = sequence_pop(sequence, &sequence->free);
+
+		rte_mutex_lock(sequence->mutex);
+		int failed = sequence->failed >= 0;
+		rte_mutex_unlock(sequence->mutex);
+
+		// Nothing past a frame that couldn't be written is worth rendering
+		if (slot < 0 || failed) {
+			break;
+		}
+
+		rvec3_t position;
+		rvec3_t rotation;
+
+		rte_camera_path_sample(&sequence->path, sequence_frame_time(sequence, index), RVEC_OUT(position), RVEC_OUT(rotation));
+
+		trace_t* trace = &sequence->slots[slot].trace;
+
+		*trace = *base;
+		trace->camera = rte_setup_camera(base->camera.viewport, position, rotation);
+		trace->camera.samples = base->camera.samples;
+
+		sequence->slots[slot].index = index;
+		sequence_give(sequence, &sequence->ready, slot);
+	}
+
+	sequence_close(sequence, &sequence->ready);
+	return 0;
+}
+
+static int sequence_writer_thread(void* user) {
+	sequence_t* sequence = (sequence_t*)user;
+	const headless_options_t* options = sequence->options;
+
+	unsigned char* rgb = (unsigned char*)malloc((size_t)options->width * options->height * 3);
+	char path[SEQUENCE_PATH_MAX];
+
+	for (;;) {
+		int slot = sequence_pop(sequence, &sequence->traced);
+
+		if (slot < 0) {
+			break;
+		}
+
+		sequence_slot_t* frame = &sequence->slots[slot];
+
+		snprintf(path, sizeof(path), options->output, frame->index);
+
+		int written = 0;
+
+		if (rgb != NULL) {
+			headless_quantize(rgb, (const rvec3_t*)frame->frame, options->width * options->height);
+			written = headless_write_rgb(path, rgb, options->width, options->height);
+		}
+
+		rte_mutex_lock(sequence->mutex);
+
+		if (!written && sequence->failed < 0) {
+			sequence->failed = frame->index;
+		}
+
+		sequence_push(sequence, &sequence->free, slot);
+
+		rte_mutex_unlock(sequence->mutex);
+	}
+
+	free(rgb);
+	return 0;
+}
+
+int sequence_render(const headless_options_t* options) {
+	sequence_t sequence;
+	memset(&sequence, 0, sizeof(sequence));
+
+	sequence.options = options;
+	sequence.failed = -1;
+
+	rte_camera_path_init(&sequence.path);
+
+	if (!rte_camera_path_load(&sequence.path, options->path) || sequence.path.keyframe_count == 0) {
+		printf("Error: Failed to load camera path '%s'!\n", options->path);
+
+		rte_camera_path_free(&sequence.path);
+		return 1;
+	}
+
+	double time_build = headless_seconds();
+
+	headless_scene_t scene;
+
+	if (!headless_scene_build(&scene, options)) {
+		headless_scene_free(&scene);
+		rte_camera_path_free(&sequence.path);
+		return 1;
+	}
+
+	sequence.scene = &scene;
+	time_build = headless_seconds() - time_build;
+
+	headless_render_t render;
+	rte_scheduler_t scheduler;
+
+	int allocated = headless_render_init(&render, options);
+	allocated = rte_scheduler_init(&scheduler, options->width, options->height, options->tile_size, options->threads) && allocated;
+
+	for (int s = 0; s < SEQUENCE_SLOTS; s++) {
+		sequence.slots[s].frame = (rvec3_t*)malloc(sizeof(rvec3_t) * options->width * options->height);
+		allocated = sequence.slots[s].frame != NULL && allocated;
+
+		sequence.free.slots[s] = s;
+	}
+
+	sequence.free.count = SEQUENCE_SLOTS;
+
+	sequence.mutex = rte_mutex_create();
+	sequence.changed = rte_cond_create();
+
+	if (!allocated || sequence.mutex == NULL || sequence.changed == NULL) {
+		printf("Error: Failed to allocate %i %ix%i frames!\n", SEQUENCE_SLOTS, options->width, options->height);
+		return 1;
+	}
+
+	// The calling thread traces alongside the pool, setup and writing get their own threads since they mostly wait
+	rte_pool_t* pool = rte_pool_create(options->threads - 1);
+
+	double time_start = headless_seconds();
+
+	rte_thread_t* setup = rte_thread_create(sequence_setup_thread, &sequence);
+	rte_thread_t* writer = rte_thread_create(sequence_writer_thread, &sequence);
+
+	if (setup == NULL || writer == NULL) {
+		printf("Error: Failed to start the pipeline threads!\n");
+		return 1;
+	}
+
+	double time_trace = 0;
+	int frames = 0;
+
+	for (;;) {
+		int slot = sequence_pop(&sequence, &sequence.ready);
+
+		if (slot < 0) {
+			break;
+		}
+
+		render.trace = sequence.slots[slot].trace;
+		render.frame = sequence.slots[slot].frame;
+
+		double time_frame = headless_seconds();
+
+		rte_scheduler_reset(&scheduler);
+		rte_scheduler_run_pool(&scheduler, pool, headless_render_tile, &render);
+
+		if (!headless_denoise(render.frame, render.trace, options)) {
+			printf("Error: Failed to allocate the denoiser, frame %i is written as traced!\n", sequence.slots[slot].index);
+		}
+
+		time_trace += headless_seconds() - time_frame;
+		frames++;
+
+		sequence_give(&sequence, &sequence.traced, slot);
+	}
+
+	sequence_close(&sequence, &sequence.traced);
+
+	rte_thread_join(setup);
+	rte_thread_join(writer);
+
+	double time_total = headless_seconds() - time_start;
+
+	printf("Built scene in %.2fms\n", time_build * 1000.0);
+	printf("Rendered %i %ix%i frames at %i spp on %i threads in %.2fms (%.2f frames/s, tracing %.1f%% of the time)\n",
+		frames, options->width, options->height, options->samples, options->threads,
+		time_total * 1000.0, (double)frames / time_total, 100.0 * time_trace / time_total
+	);
+
+	int status = 0;
+
+	if (sequence.failed >= 0) {
+		char path[SEQUENCE_PATH_MAX];
+		snprintf(path, sizeof(path), options->output, sequence.failed);
+
+		printf("Error: Failed to write '%s'!\n", path);
+		status = 1;
+	} else {
+		printf("Wrote %i frames to %s\n", frames, options->output);
+	}
+
+	rte_pool_destroy(pool);
+
+	rte_cond_destroy(sequence.changed);
+	rte_mutex_destroy(sequence.mutex);
+
+	for (int s = 0; s < SEQUENCE_SLOTS; s++) {
+		free(sequence.slots[s].frame);
+	}
+
+	rte_scheduler_free(&scheduler);
+	headless_render_free(&render);
+	headless_scene_free(&scene);
+	rte_camera_path_free(&sequence.path);
+
+	return status;
+}
@@ -0,0 +1,23 @@
+//
+// Copyright (c) 2023-2025 Liam R. (zCubed3)
+//
+
+#ifndef RTEVERYWHERE_SEQUENCE_H
+#define RTEVERYWHERE_SEQUENCE_H
+
+#include "headless.h"
+
+//
+// Sequence rendering
+// Renders options->frames frames along the camera path in options->path, spread evenly from its first keyframe to its last
+// Frames move through a bounded pipeline: a setup thread prepares the camera of frame N+1 while every core traces frame N
+// and a writer thread encodes and writes frame N-1, so tracing never waits on either
+//
+
+// options->output is a printf pattern for the frame number like "frame_%04d.bmp", returns the exit code
+extern int sequence_render(const headless_options_t* options);
+
+// Returns 1 if the pattern holds exactly one integer conversion and nothing else printf would interpret
+extern int sequence_valid_pattern(const char* pattern);
+
+#endif //RTEVERYWHERE_SEQUENCE_H
@@ -4,14 +4,20 @@
 
 #include <cstdlib>
 #include <cstdio>
+#include <cstring>
 
 #include <SDL.h>
 
 #include <rt_everywhere.h>
-
-extern "C" {
-    #include <image/bmp.h>
-};
+#include <render/wavefront.h>
+#include <render/scheduler.h>
+#include <render/progressive.h>
+#include <render/adaptive.h>
+#include <render/temporal.h>
+#include <render/upscale.h>
+#include <threading/pool.h>
+#include <model/obj.h>
+#include <image/writer.h>
 
 #ifdef RTEVERYWHERE_IMGUI
 #include <imgui.h>
@@ -22,7 +28,13 @@ extern "C" {
 #define PREVIEW_SIZE_X 228
 #define PREVIEW_SIZE_Y 128
 
-int pixels_rendered = 0;
+// The upscaled preview shades as many pixels as the regular one but shows twice the resolution
+#define PREVIEW_UPSCALE_FACTOR 2
+
+// Tiles handed out by the scheduler, wavefront queues are sized to hold one
+#define RENDER_TILE_SIZE 16
+
+volatile int pixels_rendered = 0;
 int pixel_count = 1;
 int thread_alive = 1;
 int should_render = 0;
@@ -31,31 +43,66 @@ uint32_t time_render_start;
 uint32_t time_render_end;
 
 int use_msaa = 0;
+int use_wavefront = 0;
+int use_progressive = 0;
+
+// Replaces MSAA on screen renders, camera rays are counted to show what refinement cost
+int use_adaptive = 0;
+rte_adaptive_t adaptive_settings = rte_adaptive_defaults();
+volatile int adaptive_rays = 0;
+
+// The preview keeps its last frames and reprojects them while the camera moves, so 1 spp settles into a clean image
+int use_temporal = 0;
+rte_temporal_t preview_temporal;
+int preview_temporal_ready = 0;
+
+// Takes precedence over the temporal preview, the frame is traced on the shared pool and stored in one go
+int use_upscale = 0;
+rte_upscale_t preview_upscale;
+rvec3_t* upscale_frame = NULL;
+int preview_upscale_ready = 0;
+
+// Progressive renders keep the full color frame around so each level can fill from the pixels traced before it
+rvec3_t* progressive_frame = NULL;
+int progressive_active = 0;
+int render_level = 0;
+uint32_t time_first_level;
 
 rvec3_t position;
 rvec3_t rotation;
 
 SDL_Rect texture_rect;
 SDL_Rect preview_rect;
+SDL_Rect upscale_rect;
 
 SDL_Texture* texture = NULL;
 SDL_Texture* preview_texture = NULL;
+SDL_Texture* upscale_texture = NULL;
 
 SDL_Texture* render_texture = NULL;
 SDL_Rect render_rect;
 uint8_t* render_pixels = NULL;
 rte_bool_e render_lock = RTE_FALSE;
-int render_semaphore = 0;
 
-SDL_Thread** sdl_threads = NULL;
+// Started once, every render after that only wakes the workers
+rte_pool_t* render_pool = NULL;
+rte_job_t render_job;
+int render_job_active = 0;
+
 int sdl_concurrency;
 int actual_concurrency = 0;
 int render_concurrency = 0;
 
+rte_scheduler_t scheduler;
+trace_t render_trace;
+
 bool credits_open = true;
 
 rte_camera_t camera;
+rte_context_t context;
 rte_scene_t scene;
+rte_mesh_t mesh;
+rte_tlas_t tlas;
 rte_tonemap_e tonemapping = RTE_TONEMAP_NONE;
 
 typedef enum render_target {
@@ -63,11 +110,12 @@ typedef enum render_target {
     RENDER_TARGET_PREVIEW
 } render_target_e;
 
-typedef struct render_thread {
-    SDL_Thread** pp_thread;
-    SDL_Rect rect;
-    int thread_index;
-} render_thread_t;
+render_target_e render_target = RENDER_TARGET_SCREEN;
+
+// Finished renders are written in the background, each target opts in on its own
+rte_writer_t* image_writer = NULL;
+int write_screen = 1;
+int write_preview = 0;
 
 void get_rgb(rvec3_out_t dst, const uint8_t* src, int x, int y, int width, int stride) {
     int index = (y * width * stride) + (x * stride);
@@ -86,49 +134,85 @@ void begin_render(render_target_e target) {
     if (target == RENDER_TARGET_PREVIEW) {
         render_texture = preview_texture;
         render_rect = preview_rect;
+
+        if (use_upscale && preview_upscale_ready) {
+            render_texture = upscale_texture;
+            render_rect = upscale_rect;
+        }
     }
 
     SDL_LockTexture(render_texture, NULL, (void **) &render_pixels, &pitch);
 
+    render_target = target;
     pixels_rendered = 0;
+    adaptive_rays = 0;
     pixel_count = render_rect.w * render_rect.h;
     render_lock = RTE_TRUE;
     time_render_start = SDL_GetTicks();
+
+    render_level = 0;
+    progressive_active = 0;
+
+    if (use_progressive && target == RENDER_TARGET_SCREEN) {
+        rvec3_t* frame = (rvec3_t*) realloc(progressive_frame, sizeof(rvec3_t) * pixel_count);
+
+        if (frame != NULL) {
+            progressive_frame = frame;
+            progressive_active = 1;
+        } else {
+            printf("Error: Failed to allocate the progressive frame, rendering in one pass!\n");
+        }
+    }
+}
+
+// Uploads the finished level so it gets drawn, then locks the texture again for the next one
+void present_level() {
+    int pitch;
+
+    if (render_level == 0) {
+        time_first_level = SDL_GetTicks();
+    }
+
+    SDL_UnlockTexture(render_texture);
+    SDL_LockTexture(render_texture, NULL, (void **) &render_pixels, &pitch);
+
+    render_level++;
+    pixels_rendered = 0;
 }
 
 void end_render() {
     time_render_end = SDL_GetTicks();
 
-    uint8_t* fix_pixels = new uint8_t[render_rect.w * render_rect.h * 3];
-    for (int y = 0; y < render_rect.h; y++) {
-        int inv_y = render_rect.h - 1 - y;
+    int write = render_target == RENDER_TARGET_PREVIEW ? write_preview : write_screen;
 
-        for (int x = 0; x < render_rect.w; x++) {
-            int old_index = (y * render_rect.w * 4) + (x * 4);
-            int fix_index = (inv_y * render_rect.w * 3) + (x * 3);
+    // Only the copy out of the locked texture happens here, the flip and the disk are the writer thread's problem
+    if (write && image_writer != NULL) {
+        rte_image_buffer_t* image = rte_writer_acquire(image_writer, render_rect.w, render_rect.h, 4);
 
-            fix_pixels[fix_index + 2] = render_pixels[old_index + 2];
-            fix_pixels[fix_index + 1] = render_pixels[old_index + 1];
-            fix_pixels[fix_index + 0] = render_pixels[old_index + 0];
+        if (image != NULL) {
+            memcpy(image->pixels, render_pixels, (size_t)render_rect.w * render_rect.h * 4);
+            rte_writer_submit(image_writer, image, render_target == RENDER_TARGET_PREVIEW ? "preview.bmp" : "out.bmp");
         }
     }
 
-    write_bmp("out.bmp", texture_rect.w, texture_rect.h, (char*)fix_pixels);
-
-    delete[] fix_pixels;
-
     SDL_UnlockTexture(render_texture);
     render_lock = RTE_FALSE;
 }
 
-int render(render_target_e target, SDL_Rect rect) {
-	int pitch;
+void store_block(const rvec3_t* colors, int x, int y, int width, int height) {
+    for (int by = 0; by < height; by++) {
+        for (int bx = 0; bx < width; bx++) {
+            int index = ((y + by) * render_rect.w * 4) + ((x + bx) * 4);
+            real_t* color = (real_t*)&colors[by * width + bx];
 
-	if (render_texture == NULL) {
-		printf("Error: Render texture was NULL!\n");
-		return 1;
-	}
+            render_pixels[index + 2] = color[0] * 255;
+            render_pixels[index + 1] = color[1] * 255;
+            render_pixels[index + 0] = color[2] * 255;
+        }
+    }
+}
 
+trace_t setup_trace(render_target_e target) {
 	rte_viewport_t viewport;
 	viewport.width = render_rect.w;
 	viewport.height = render_rect.h;
@@ -147,63 +231,198 @@ int render(render_target_e target, SDL_Rect rect) {
     trace.scene = scene;
     trace.tonemapping = tonemapping;
 
-	for (int y = rect.y; y < rect.y + rect.h; y++) {
-		for (int x = rect.x; x < rect.x + rect.w; x++) {
-			int index = (y * render_rect.w * 4) + (x * 4);
+    return trace;
+}
 
-			rvec3_t color;
+// Wavefront is NULL for packet tracing, otherwise it has to hold a whole tile
+// Adaptive is NULL unless the tile is supersampled adaptively, which takes precedence over the wavefront
+// Temporal is NULL unless the tile accumulates over the previous frames, which takes precedence over both
+void render_tile(trace_t trace, rte_wavefront_t* wavefront, const rte_adaptive_t* adaptive, rte_temporal_t* temporal, rte_tile_t tile) {
+    if (progressive_active) {
+        trace_tile_progressive(progressive_frame, render_rect.w, trace, tile, render_level);
 
-            trace.point.x = x;
-            trace.point.y = y;
+        // Locked texture memory is write only, so the whole tile is stored again every level
+        for (unsigned int y = tile.y; y < tile.y + tile.height; y++) {
+            store_block(&progressive_frame[y * render_rect.w + tile.x], tile.x, y, tile.width, 1);
+        }
+
+        rte_atomic_add(&pixels_rendered, tile.width * tile.height);
+        return;
+    }
+
+    if (temporal != NULL) {
+        rvec3_t colors[RENDER_TILE_SIZE * RENDER_TILE_SIZE];
+
+        trace_tile_temporal(temporal, colors, trace, tile);
+        store_block(colors, tile.x, tile.y, tile.width, tile.height);
+
+        rte_atomic_add(&pixels_rendered, tile.width * tile.height);
+        return;
+    }
+
+    if (adaptive != NULL) {
+        rvec3_t colors[RENDER_TILE_SIZE * RENDER_TILE_SIZE];
+
+        rte_atomic_add(&adaptive_rays, trace_tile_adaptive(colors, trace, tile, adaptive));
+        store_block(colors, tile.x, tile.y, tile.width, tile.height);
+
+        rte_atomic_add(&pixels_rendered, tile.width * tile.height);
+        return;
+    }
+
+    if (wavefront != NULL) {
+        rvec3_t colors[RENDER_TILE_SIZE * RENDER_TILE_SIZE];
+
+        trace_tile_wavefront(wavefront, colors, trace, tile);
+        store_block(colors, tile.x, tile.y, tile.width, tile.height);
 
-			trace_pixel(RVEC_OUT(color), trace);
+        rte_atomic_add(&pixels_rendered, tile.width * tile.height);
+        return;
+    }
+
+    // Neighbouring pixels are traced together as ray packets, MSAA packets already hold 4 rays per pixel
+    int block = trace.camera.samples == CAMERA_SAMPLES_FOUR ? 2 : 4;
+
+    int end_x = tile.x + tile.width;
+    int end_y = tile.y + tile.height;
 
-			render_pixels[index + 2] = color[0] * 255;
-			render_pixels[index + 1] = color[1] * 255;
-			render_pixels[index + 0] = color[2] * 255;
+	for (int y = tile.y; y < end_y; y += block) {
+		for (int x = tile.x; x < end_x; x += block) {
+            int block_w = SDL_min(block, end_x - x);
+            int block_h = SDL_min(block, end_y - y);
+
+			rvec3_t colors[16];
+
+            trace.point.x = x;
+            trace.point.y = y;
 
-			pixels_rendered++;
+			trace_pixel_block(colors, trace, block_w, block_h);
+            store_block(colors, x, y, block_w, block_h);
 		}
 	}
 
-	return 0;
+    rte_atomic_add(&pixels_rendered, tile.width * tile.height);
 }
 
-int render_loop(void* data) {
-    render_thread_t* args = (render_thread_t*)data;
+// Renders every tile the scheduler still holds, each render thread runs this with its own worker index
+int render(render_target_e target, int worker) {
+	if (render_texture == NULL) {
+		printf("Error: Render texture was NULL!\n");
+		return 1;
+	}
+
+    trace_t trace = target == RENDER_TARGET_SCREEN ? render_trace : setup_trace(target);
+
+    rte_wavefront_t wavefront;
+    rte_wavefront_t* p_wavefront = NULL;
+
+    const rte_adaptive_t* p_adaptive = NULL;
+    rte_temporal_t* p_temporal = NULL;
+
+    if (use_temporal && target == RENDER_TARGET_PREVIEW && preview_temporal_ready) {
+        p_temporal = &preview_temporal;
+    }
+
+    if (use_adaptive && target == RENDER_TARGET_SCREEN && !progressive_active) {
+        p_adaptive = &adaptive_settings;
+    }
+
+    if (use_wavefront && !progressive_active && p_adaptive == NULL && p_temporal == NULL) {
+        if (!wavefront_init(&wavefront, RENDER_TILE_SIZE * RENDER_TILE_SIZE)) {
+            printf("Error: Failed to allocate wavefront queues!\n");
+            return 1;
+        }
+
+        p_wavefront = &wavefront;
+    }
+
+    rte_tile_t tile;
 
-    int status = render(RENDER_TARGET_SCREEN, args->rect);
+    while (rte_scheduler_next(&scheduler, worker, &tile)) {
+        render_tile(trace, p_wavefront, p_adaptive, p_temporal, tile);
+    }
 
-    *args->pp_thread = NULL;
-    render_semaphore--;
+    if (p_wavefront != NULL) {
+        wavefront_free(p_wavefront);
+    }
 
-    free(args);
 	return 0;
 }
 
-inline int threads_done() {
-    if (actual_concurrency == 0 || sdl_threads == NULL)
-        return 1;
+void render_worker(void* user, int index) {
+    render(RENDER_TARGET_SCREEN, index);
+}
 
-    if (sdl_threads != NULL) {
-        for (int t = 0; t < actual_concurrency; t++) {
-            if (sdl_threads[t] != NULL) {
-                return 0; // Not done
-            }
-        }
+// Cuts the current render target into tiles for the given number of workers
+int setup_scheduler(int workers) {
+    rte_scheduler_free(&scheduler);
+
+    if (!rte_scheduler_init(&scheduler, render_rect.w, render_rect.h, RENDER_TILE_SIZE, workers)) {
+        printf("Error: Failed to set up the tile scheduler!\n");
+        return 0;
     }
 
     return 1;
 }
 
+// Runs every scheduler tile on the render pool
+void submit_render() {
+    rte_pool_submit(render_pool, &render_job, render_worker, NULL, scheduler.worker_count);
+    render_job_active = 1;
+
+    // Without worker threads nothing would ever pick the job up, render it right here instead
+    if (rte_pool_thread_count(render_pool) == 0) {
+        rte_job_wait(&render_job);
+    }
+}
+
+inline int threads_done() {
+    return !render_job_active || rte_job_done(&render_job);
+}
+
+// Spins the model around its own center, only the top level is refit
+void spin_model(float angle) {
+    rvec3_t center;
+    aabb_centroid(RVEC_OUT(center), &mesh.bvh.nodes[0].bounds);
+
+    rvec3_t offset;
+    rvec3_mul_scalar(RVEC_OUT(offset), center, -1);
+
+    rvec3_t spin = {0, angle, 0};
+
+    rmat4_t to_origin;
+    rmat4_t rotation;
+    rmat4_t from_origin;
+    rmat4_t temp;
+    rmat4_t transform;
+
+    rmat4_translate(to_origin, offset);
+    rmat4_rotate(rotation, spin);
+    rmat4_translate(from_origin, center);
+
+    rmat4_mul(temp, rotation, to_origin);
+    rmat4_mul(transform, from_origin, temp);
+
+    tlas_set_transform(&tlas, 0, transform);
+    tlas_update(&tlas);
+}
+
 inline void wait_for_threads() {
-    if (sdl_threads != NULL) {
-        for (int t = 0; t < actual_concurrency; t++) {
-            if (sdl_threads[t] != NULL) {
-                int status;
-                SDL_WaitThread(sdl_threads[t], &status);
-            }
-        }
+    if (render_job_active) {
+        rte_job_wait(&render_job);
+    }
+}
+
+// Drops the running render, workers stop after the tile they're on and the partial frame is discarded
+void cancel_render() {
+    if (render_job_active) {
+        rte_scheduler_cancel(&scheduler);
+        wait_for_threads();
+    }
+
+    if (render_lock) {
+        SDL_UnlockTexture(render_texture);
+        render_lock = RTE_FALSE;
     }
 }
 
@@ -253,9 +472,51 @@ int main(int argc, char** argv) {
     preview_rect.w = PREVIEW_SIZE_X;
     preview_rect.h = PREVIEW_SIZE_Y;
 
+    // Upscaled preview texture
+    upscale_texture = SDL_CreateTexture(
+        renderer,
+        SDL_PIXELFORMAT_ARGB8888,
+        SDL_TEXTUREACCESS_STREAMING,
+        PREVIEW_SIZE_X * PREVIEW_UPSCALE_FACTOR,
+        PREVIEW_SIZE_Y * PREVIEW_UPSCALE_FACTOR
+    );
+
+    upscale_rect.x = 0;
+    upscale_rect.y = 0;
+    upscale_rect.w = PREVIEW_SIZE_X * PREVIEW_UPSCALE_FACTOR;
+    upscale_rect.h = PREVIEW_SIZE_Y * PREVIEW_UPSCALE_FACTOR;
+
     sdl_concurrency = SDL_GetCPUCount();
     actual_concurrency = sdl_concurrency / 2;
 
+    render_pool = rte_pool_create(sdl_concurrency);
+
+    if (render_pool == NULL) {
+        printf("Error: Failed to start the render threads!\n");
+        return 1;
+    }
+
+    // Enough buffers for a render being written while the next one finishes, anything past that is dropped
+    image_writer = rte_writer_create(2);
+
+    if (image_writer == NULL) {
+        printf("Error: Failed to start the image writer, renders won't be saved!\n");
+    }
+
+    preview_temporal_ready = temporal_init(&preview_temporal, PREVIEW_SIZE_X, PREVIEW_SIZE_Y);
+
+    if (!preview_temporal_ready) {
+        printf("Error: Failed to allocate the preview history, the temporal preview is unavailable!\n");
+    }
+
+    upscale_frame = (rvec3_t*)malloc(sizeof(rvec3_t) * upscale_rect.w * upscale_rect.h);
+    preview_upscale_ready = upscale_texture != NULL && upscale_frame != NULL
+        && upscale_init(&preview_upscale, upscale_rect.w, upscale_rect.h, PREVIEW_UPSCALE_FACTOR);
+
+    if (!preview_upscale_ready) {
+        printf("Error: Failed to allocate the upscaled preview, it is unavailable!\n");
+    }
+
     // Create a temporary camera to get the default values
     if (1) {
         rte_camera_t temp = rte_default_camera({64, 64});
@@ -263,7 +524,33 @@ int main(int argc, char** argv) {
         rvec3_copy(RVEC_OUT(rotation), temp.rotation);
     }
 
-    scene = rte_default_scene();
+    rte_context_init(&context);
+
+    if (!rte_context_build(&context)) {
+        printf("Error: Failed to build the scene!\n");
+        return 1;
+    }
+
+    scene = rte_default_scene(&context);
+
+    // Optional OBJ model, passed as the first argument
+    mesh_init(&mesh);
+    tlas_init(&tlas);
+
+    if (argc > 1) {
+        if (obj_load(&mesh, argv[1]) && mesh_build(&mesh) && mesh.triangle_count > 0) {
+            // Instanced so it can be animated without touching the mesh BVH
+            rmat4_t identity;
+            rmat4_identity(identity);
+
+            tlas_add_instance(&tlas, &mesh, identity);
+            tlas_update(&tlas);
+
+            scene.tlas = &tlas;
+        } else {
+            printf("Error: Failed to load model '%s'!\n", argv[1]);
+        }
+    }
 
 #ifdef RTEVERYWHERE_IMGUI
     ImGuiContext* imgui_context = ImGui::CreateContext();
@@ -296,6 +583,9 @@ int main(int argc, char** argv) {
     int q_down = 0;
     int e_down = 0;
 
+    int animate_model = 0;
+    float model_angle = 0;
+
     while (run) {
         int draw_preview = 0;
 
@@ -380,6 +670,9 @@ int main(int argc, char** argv) {
                     lock_cursor = !lock_cursor;
                     SDL_SetRelativeMouseMode(static_cast<SDL_bool>(lock_cursor));
 
+                    // Anything in the scene may have changed since the last time the preview ran
+                    temporal_reset(&preview_temporal);
+
                     if (lock_cursor == 0) {
                         should_render = 1;
                     }
@@ -478,47 +771,71 @@ int main(int argc, char** argv) {
             rvec3_add(RVEC_OUT(position), position, forward_vec);
         }
 
-        if (draw_preview && !should_render && threads_done()) {
-            begin_render(RENDER_TARGET_PREVIEW);
-            render(RENDER_TARGET_PREVIEW, render_rect);
-            end_render();
+        // Whatever the full render was showing is stale once the camera is being moved
+        if (draw_preview && !threads_done()) {
+            cancel_render();
         }
 
-        if (should_render && threads_done()) {
-            begin_render(RENDER_TARGET_SCREEN);
+        if (draw_preview && context.built && !should_render && threads_done()) {
+            begin_render(RENDER_TARGET_PREVIEW);
 
-            render_semaphore = actual_concurrency;
+            if (use_upscale && preview_upscale_ready) {
+                trace_frame_upscaled(&preview_upscale, upscale_frame, setup_trace(RENDER_TARGET_PREVIEW));
+                store_block(upscale_frame, 0, 0, upscale_rect.w, upscale_rect.h);
+            } else if (setup_scheduler(1)) {
+                render(RENDER_TARGET_PREVIEW, 0);
 
-            if (sdl_threads == NULL) {
-                sdl_threads = (SDL_Thread**) calloc(sizeof(SDL_Thread*), actual_concurrency);
+                if (use_temporal && preview_temporal_ready) {
+                    temporal_end_frame(&preview_temporal, &camera);
+                }
             }
 
-            int slice = render_rect.w / actual_concurrency;
+            end_render();
+        }
 
-            SDL_Rect rect = render_rect;
-            rect.w = slice;
+        if (animate_model && scene.tlas != NULL && !should_render && threads_done()) {
+            model_angle += delta_time * 45.0F;
+            spin_model(model_angle);
+            temporal_reset(&preview_temporal);
 
-            for (int c = 0; c < actual_concurrency; c++) {
-                render_thread_t* thread = (render_thread_t*) malloc(sizeof(render_thread_t));
+            should_render = 1;
+        }
 
-                rect.x = c * slice;
+        // Restart with the new parameters instead of finishing a frame nobody wants anymore
+        if (should_render && !threads_done()) {
+            cancel_render();
+        }
 
-                thread->pp_thread = &sdl_threads[c];
-                thread->rect = rect;
-                thread->thread_index = c;
+        if (should_render && context.built && threads_done()) {
+            begin_render(RENDER_TARGET_SCREEN);
 
-                sdl_threads[c] = SDL_CreateThread(render_loop, "RTEverywhereRenderThread", thread);
+            // Workers only ever see this snapshot, so the camera and scene can change while they run
+            render_trace = setup_trace(RENDER_TARGET_SCREEN);
+
+            // Tiles are stolen between workers, so any worker count covers the whole frame evenly
+            int workers = SDL_max(1, SDL_min(actual_concurrency, sdl_concurrency));
+
+            if (setup_scheduler(workers)) {
+                render_concurrency = workers;
+                submit_render();
             }
 
             should_render = 0;
         }
 
-        if (render_semaphore == 0 && threads_done() && render_lock) {
-            end_render();
+        if (threads_done() && render_lock) {
+            if (progressive_active && render_level < RTE_PROGRESSIVE_LEVELS - 1) {
+                present_level();
+
+                rte_scheduler_reset(&scheduler);
+                submit_render();
+            } else {
+                end_render();
+            }
         }
 
-        if (recreate_texture && render_semaphore == 0) {
-            wait_for_threads();
+        if (recreate_texture) {
+            cancel_render();
 
             SDL_DestroyTexture(texture);
             texture = NULL;
@@ -561,6 +878,11 @@ int main(int argc, char** argv) {
         if (ImGui::CollapsingHeader("Render Status")) {
             float frac = (float) pixels_rendered / (float) pixel_count;
             ImGui::Text("Rendered: %i out of %i pixels", pixels_rendered, pixel_count);
+
+            if (progressive_active) {
+                ImGui::Text("Level: %i out of %i", render_level + 1, RTE_PROGRESSIVE_LEVELS);
+            }
+
             ImGui::Text("Resolution: %i by %i", texture_rect.w, texture_rect.h);
 
             ImGui::ProgressBar(frac);
@@ -569,11 +891,38 @@ int main(int argc, char** argv) {
                 uint32_t elapsed = time_render_end - time_render_start;
                 ImGui::Text("Last render took %ums (%fs)", elapsed, (float)elapsed / 1000.0F);
                 ImGui::Text("Last render ran on %i threads", render_concurrency);
+
+                if (use_progressive && time_first_level >= time_render_start) {
+                    ImGui::Text("First level took %ums", time_first_level - time_render_start);
+                }
+
+                if (adaptive_rays > 0) {
+                    ImGui::Text("Adaptive sampling traced %.2f rays per pixel", (float)adaptive_rays / (float)pixel_count);
+                }
             }
         }
 
         if (ImGui::CollapsingHeader("Render Config")) {
             ImGui::Checkbox("MSAA?", reinterpret_cast<bool*>(&use_msaa));
+            ImGui::Checkbox("Adaptive?", reinterpret_cast<bool*>(&use_adaptive));
+
+            if (use_adaptive) {
+                float threshold = (float)adaptive_settings.threshold;
+
+                ImGui::SliderInt("Max Samples", &adaptive_settings.max_samples, 1, RTE_ADAPTIVE_MAX_SAMPLES);
+
+                if (ImGui::SliderFloat("Threshold", &threshold, 0.0F, 0.5F)) {
+                    adaptive_settings.threshold = (real_t)threshold;
+                }
+            }
+
+            bool temporal = use_temporal;
+            if (ImGui::Checkbox("Temporal Preview?", &temporal)) {
+                use_temporal = temporal;
+                temporal_reset(&preview_temporal);
+            }
+
+            ImGui::Checkbox("Upscaled Preview?", reinterpret_cast<bool*>(&use_upscale));
 
             ImGui::Checkbox("ACES Tonemap?", reinterpret_cast<bool*>(&tonemapping));
 
@@ -584,6 +933,13 @@ int main(int argc, char** argv) {
 
             ImGui::DragInt("Concurrency (Threads)", &actual_concurrency, 1.0F, 1, sdl_concurrency);
 
+            ImGui::Checkbox("Save Renders?", reinterpret_cast<bool*>(&write_screen));
+            ImGui::Checkbox("Save Previews?", reinterpret_cast<bool*>(&write_preview));
+
+            if (image_writer != NULL) {
+                ImGui::Text("Saves queued: %i, dropped: %i, failed: %i", rte_writer_pending(image_writer), rte_writer_dropped(image_writer), rte_writer_failed(image_writer));
+            }
+
             if (ImGui::Button("Recreate image")) {
                 recreate_texture = 1;
             }
@@ -600,6 +956,59 @@ int main(int argc, char** argv) {
                 should_render = 1;
             }
 
+            float min_energy = (float)scene.min_energy;
+            if (ImGui::SliderFloat("Min Reflection Energy", &min_energy, 0.0F, 0.1F, "%.4f")) {
+                scene.min_energy = (real_t)min_energy;
+                should_render = 1;
+            }
+
+            int accel = scene.accel;
+            if (ImGui::Combo("Acceleration", &accel, "None\0BVH\0Quantized BVH\0")) {
+                scene.accel = (rte_accel_e)accel;
+                should_render = 1;
+            }
+
+            static int sphere_seed = (int)context.seed;
+            static int sphere_builder = RTE_BUILDER_SAH;
+            static uint32_t sphere_build_ms = 0;
+
+            ImGui::InputInt("Sphere Seed", &sphere_seed);
+            ImGui::Combo("BVH Builder", &sphere_builder, "SAH\0LBVH\0LBVH + Treelets\0");
+
+            if (ImGui::Button("Regenerate Spheres")) {
+                cancel_render();
+
+                uint32_t start = SDL_GetTicks();
+                context.seed = (unsigned long)sphere_seed;
+                context.builder = (rte_builder_e)sphere_builder;
+
+                if (rte_context_build(&context)) {
+                    sphere_build_ms = SDL_GetTicks() - start;
+                    should_render = 1;
+                } else {
+                    // The context is left empty, nothing is rendered until a build succeeds
+                    printf("Error: Failed to build the scene!\n");
+                }
+            }
+
+            ImGui::Text("Regenerated in %u ms", sphere_build_ms);
+
+            if (scene.tlas != NULL) {
+                ImGui::Checkbox("Animate Model?", reinterpret_cast<bool*>(&animate_model));
+            }
+
+            bool progressive = use_progressive;
+            if (ImGui::Checkbox("Progressive?", &progressive)) {
+                use_progressive = progressive;
+                should_render = 1;
+            }
+
+            bool wavefront = use_wavefront;
+            if (ImGui::Checkbox("Wavefront?", &wavefront)) {
+                use_wavefront = wavefront;
+                should_render = 1;
+            }
+
             if (ImGui::CollapsingHeader("Sun")) {
                 ImGui::Indent();
 
@@ -636,6 +1045,11 @@ int main(int argc, char** argv) {
         if (draw_preview) {
             target_texture = preview_texture;
             target_rect = preview_rect;
+
+            if (use_upscale && preview_upscale_ready) {
+                target_texture = upscale_texture;
+                target_rect = upscale_rect;
+            }
         }
 
         SDL_RenderClear(renderer);
@@ -651,7 +1065,17 @@ int main(int argc, char** argv) {
         SDL_RenderPresent(renderer);
     }
 
-    wait_for_threads();
+    cancel_render();
+    rte_writer_destroy(image_writer);
+    rte_pool_destroy(render_pool);
+    rte_scheduler_free(&scheduler);
+    free(progressive_frame);
+    temporal_free(&preview_temporal);
+    upscale_free(&preview_upscale);
+    free(upscale_frame);
+    tlas_free(&tlas);
+    mesh_free(&mesh);
+    rte_context_free(&context);
 
     return 0;
 }
\ No newline at end of file